@@ -0,0 +1,162 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// compares the memory per BLOB and the lookup latency of blob_index with those of std::map,
+// which was used as the per-session BLOB index before, and those with the paths stored and derived
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <malloc.h>
+
+#include <gflags/gflags.h>
+
+#include <data_relay_grpc/common/detail/blob_index.h>
+
+DEFINE_uint64(blobs, 1000000, "the number of BLOBs in the index");
+DEFINE_uint64(lookups, 10000000, "the number of lookups to measure the latency");
+DEFINE_uint32(threads, 8, "the number of threads looking up concurrently");
+DEFINE_string(directory, "/var/lib/tsurugi/session_store", "the session store directory used to build the paths");
+
+namespace {
+
+// the entry storing the path
+struct path_entry {
+    std::filesystem::path path{};
+    std::size_t size{};
+    int fd{-1};
+};
+
+// the same layout as the entry of blob_session_impl, which derives the path from the BLOB ID
+struct compact_entry {
+    const std::string* external{};
+    std::size_t size{};
+    int fd{-1};
+    std::uint8_t prefix{};
+};
+
+std::size_t allocated() {
+    return mallinfo2().uordblks;
+}
+
+template <class Entry>
+Entry make_entry(std::uint64_t bid) {
+    if constexpr (std::is_same_v<Entry, path_entry>) {
+        return path_entry{std::filesystem::path(FLAGS_directory) / ("upload_" + std::to_string(bid)), bid};
+    } else {
+        return compact_entry{nullptr, bid};
+    }
+}
+
+template <class Find>
+double latency_ns(Find&& find) {
+    std::mt19937_64 rng(1);
+    std::uniform_int_distribution<std::uint64_t> dist(1, FLAGS_blobs);
+    std::size_t hits{};
+    auto begin = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < FLAGS_lookups; i++) {
+        hits += find(dist(rng)) ? 1 : 0;
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    if (hits != FLAGS_lookups) {
+        std::abort();
+    }
+    return elapsed / static_cast<double>(FLAGS_lookups);
+}
+
+template <class Find>
+double concurrent_lookups_per_second(Find&& find) {
+    std::atomic_bool stop{};
+    std::atomic<std::uint64_t> total{};
+    std::vector<std::thread> workers{};
+    for (std::uint32_t t = 0; t < FLAGS_threads; t++) {
+        workers.emplace_back([&, t]{
+            std::mt19937_64 rng(t);
+            std::uniform_int_distribution<std::uint64_t> dist(1, FLAGS_blobs);
+            std::uint64_t count{};
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (!find(dist(rng))) {
+                    std::abort();
+                }
+                count++;
+            }
+            total += count;
+        });
+    }
+    constexpr std::uint32_t duration_ms = 1000;
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop = true;
+    for (auto&& e : workers) {
+        e.join();
+    }
+    return static_cast<double>(total.load()) * 1000.0 / duration_ms;
+}
+
+void report(const char* name, std::size_t bytes, double ns, double ops) {
+    std::cout << name << ": " << static_cast<double>(bytes) / static_cast<double>(FLAGS_blobs) << " bytes/blob, "
+              << ns << " ns/lookup, " << static_cast<std::uint64_t>(ops) << " lookups/s with " << FLAGS_threads << " threads" << std::endl;
+}
+
+template <class Entry>
+void measure_blob_index(const char* name) {
+    auto before = allocated();
+    data_relay_grpc::common::detail::blob_index<Entry> index{};
+    for (std::uint64_t bid = 1; bid <= FLAGS_blobs; bid++) {
+        index.emplace(bid, make_entry<Entry>(bid));
+    }
+    auto bytes = allocated() - before;
+    std::shared_mutex mtx{};
+    auto find = [&](std::uint64_t bid) {
+        std::shared_lock<std::shared_mutex> lock(mtx);
+        return index.find(bid) != nullptr;
+    };
+    report(name, bytes, latency_ns(find), concurrent_lookups_per_second(find));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    gflags::SetUsageMessage("per-session BLOB index benchmark");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+    {
+        auto before = allocated();
+        std::map<std::uint64_t, path_entry> index{};
+        for (std::uint64_t bid = 1; bid <= FLAGS_blobs; bid++) {
+            index.emplace(bid, make_entry<path_entry>(bid));
+        }
+        auto bytes = allocated() - before;
+        std::mutex mtx{};
+        auto find = [&](std::uint64_t bid) {
+            std::lock_guard<std::mutex> lock(mtx);
+            return index.find(bid) != index.end();
+        };
+        report("std::map with paths  ", bytes, latency_ns(find), concurrent_lookups_per_second(find));
+    }
+    measure_blob_index<path_entry>("blob_index with paths");
+    measure_blob_index<compact_entry>("blob_index compact   ");
+    return 0;
+}
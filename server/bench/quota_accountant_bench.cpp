@@ -0,0 +1,112 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// compares the throughput of reserve/release by concurrent threads, as done for each chunk of concurrent uploads,
+// between quota_accountant and a single atomic counter updated by a CAS loop, which was used before
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include <data_relay_grpc/common/detail/quota_accountant.h>
+
+DEFINE_uint32(threads, 16, "the maximum number of threads, doubled from 1");
+DEFINE_uint64(quota, 1UL << 40U, "the quota in bytes");
+DEFINE_uint64(chunk, 64UL * 1024UL, "the size of a chunk reserved at once");
+DEFINE_uint32(duration, 1000, "the duration of each measurement in milliseconds");
+
+namespace {
+
+// the quota accounting of blob_session_store before quota_accountant
+class single_counter {
+public:
+    explicit single_counter(std::size_t quota) : quota_(quota) {}
+
+    bool reserve(std::size_t size) {
+        std::size_t current = current_size_.load();
+        while (true) {
+            if (current + size > quota_) {
+                return false;
+            }
+            if (current_size_.compare_exchange_strong(current, current + size)) {
+                return true;
+            }
+        }
+    }
+    void release(std::size_t size) {
+        current_size_.fetch_sub(size);
+    }
+
+private:
+    std::size_t quota_;
+    std::atomic<std::size_t> current_size_{};
+};
+
+template <class Accountant>
+double run(std::uint32_t threads) {
+    Accountant accountant(FLAGS_quota);
+    std::atomic_bool stop{};
+    std::atomic<std::uint64_t> total{};
+    std::vector<std::thread> workers{};
+    for (std::uint32_t t = 0; t < threads; t++) {
+        workers.emplace_back([&]{
+            // each thread holds a few chunks as an upload in progress does
+            constexpr std::size_t held = 4;
+            std::uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (std::size_t i = 0; i < held; i++) {
+                    if (!accountant.reserve(FLAGS_chunk)) {
+                        std::abort();
+                    }
+                }
+                accountant.release(FLAGS_chunk * held);
+                count += held;
+            }
+            total += count;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(FLAGS_duration));
+    stop = true;
+    for (auto&& e : workers) {
+        e.join();
+    }
+    return static_cast<double>(total.load()) * 1000.0 / FLAGS_duration;
+}
+
+template <class Accountant>
+void measure(const char* name) {
+    for (std::uint32_t threads = 1; threads <= FLAGS_threads; threads *= 2) {
+        auto ops = run<Accountant>(threads);
+        std::cout << name << " threads: " << threads << ", reserves/s: " << static_cast<std::uint64_t>(ops)
+                  << ", per thread: " << static_cast<std::uint64_t>(ops / threads) << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    gflags::SetUsageMessage("quota accounting benchmark");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+    measure<single_counter>("single_counter");
+    measure<data_relay_grpc::common::detail::quota_accountant>("quota_accountant");
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// measures the throughput of session lookups by concurrent threads, as done by concurrent RPCs
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gflags/gflags.h>
+
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+DEFINE_uint32(threads, 16, "the maximum number of lookup threads, doubled from 1");
+DEFINE_uint32(sessions, 1024, "the number of sessions");
+DEFINE_uint32(duration, 1000, "the duration of each measurement in milliseconds");
+
+namespace {
+
+using data_relay_grpc::common::blob_session;
+using data_relay_grpc::common::detail::blob_session_manager;
+
+double run(blob_session_manager& manager, const std::vector<blob_session::session_id_type>& session_ids, std::uint32_t threads) {
+    std::atomic_bool stop{};
+    std::atomic<std::uint64_t> total{};
+    std::vector<std::thread> workers{};
+    for (std::uint32_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]{
+            std::mt19937_64 rng(t);
+            std::uniform_int_distribution<std::size_t> dist(0, session_ids.size() - 1);
+            std::uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto i = dist(rng);
+                auto& session = manager.get_session(session_ids.at(i));
+                auto session_id = manager.get_session_id(static_cast<blob_session::transaction_id_type>(i));
+                if (session.session_id() != session_ids.at(i) || session_id != session_ids.at(i)) {
+                    std::abort();
+                }
+                count++;
+            }
+            total += count;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(FLAGS_duration));
+    stop = true;
+    for (auto&& e : workers) {
+        e.join();
+    }
+    return static_cast<double>(total.load()) * 1000.0 / FLAGS_duration;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    gflags::SetUsageMessage("session registry lookup benchmark");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+    auto directory = std::filesystem::temp_directory_path() / ("session_registry_bench-" + std::to_string(::getpid()));
+    std::filesystem::create_directory(directory);
+    {
+        data_relay_grpc::common::api api{
+            [](blob_session::blob_id_type, blob_session::transaction_id_type) { return blob_session::blob_tag_type{}; },
+            [](blob_session::blob_id_type) { return std::filesystem::path{}; }
+        };
+        blob_session_manager manager(api, directory.string(), 0, false);
+        std::vector<blob_session::session_id_type> session_ids{};
+        for (std::uint32_t i = 0; i < FLAGS_sessions; i++) {
+            session_ids.emplace_back(manager.create_session(static_cast<blob_session::transaction_id_type>(i)).session_id());
+        }
+        for (std::uint32_t threads = 1; threads <= FLAGS_threads; threads *= 2) {
+            auto ops = run(manager, session_ids, threads);
+            std::cout << "threads: " << threads << ", lookups/s: " << static_cast<std::uint64_t>(ops)
+                      << ", per thread: " << static_cast<std::uint64_t>(ops / threads) << std::endl;
+        }
+    }
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// compares the rates of creating, looking up and unlinking BLOB files in the session store, and the time to purge
+// the files left at the start, between the flat layout and the fan-out layouts of the subdirectories
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gflags/gflags.h>
+
+#include <data_relay_grpc/common/detail/session_manager.h>
+#include <data_relay_grpc/common/detail/session_impl.h>
+
+DEFINE_string(directory, "/tmp/session_store_fanout_bench", "the session store directory, which is purged");
+DEFINE_string(counts, "10000,1000000,10000000", "the numbers of files, separated by comma");
+DEFINE_string(levels, "0,1,2", "the levels of the subdirectories, separated by comma");
+DEFINE_bool(wipe, true, "whether the time to purge the files at the start is measured");
+
+namespace {
+
+using namespace data_relay_grpc::common;
+using clock_type = std::chrono::steady_clock;
+
+std::vector<std::uint64_t> parse_list(const std::string& s) {
+    std::vector<std::uint64_t> rv{};
+    std::stringstream ss(s);
+    std::string e{};
+    while (std::getline(ss, e, ',')) {
+        rv.emplace_back(std::stoull(e));
+    }
+    return rv;
+}
+
+double rate(std::uint64_t count, clock_type::duration elapsed) {
+    return static_cast<double>(count) / std::chrono::duration<double>(elapsed).count();
+}
+
+std::unique_ptr<detail::blob_session_manager> start(const api& a, std::size_t levels) {
+    detail::session_store_options options{};
+    options.cleanup_threads = 0;
+    options.fanout_levels = levels;
+    return std::make_unique<detail::blob_session_manager>(a, FLAGS_directory, 0, false, options);
+}
+
+std::vector<blob_session::blob_id_type> create_files(detail::blob_session_impl& session, std::uint64_t count) {
+    std::vector<blob_session::blob_id_type> rv{};
+    rv.reserve(count);
+    for (std::uint64_t i = 0; i < count; i++) {
+        auto [bid, path] = session.create_blob_file();
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);  // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg, hicpp-signed-bitwise)
+        if (fd < 0) {
+            std::cerr << "cannot create " << path.string() << std::endl;
+            std::abort();
+        }
+        ::close(fd);
+        rv.emplace_back(bid);
+    }
+    return rv;
+}
+
+void measure(const api& a, std::size_t levels, std::uint64_t count) {
+    std::filesystem::remove_all(FLAGS_directory);
+    std::filesystem::create_directories(FLAGS_directory);
+    auto manager = start(a, levels);
+    auto& session = manager->create_session(std::nullopt);
+    auto& session_impl = manager->get_session_impl(session.session_id());
+
+    auto begin = clock_type::now();
+    auto bids = create_files(session_impl, count);
+    auto created = clock_type::now();
+    for (auto bid : bids) {
+        struct stat st{};
+        if (::stat(session_impl.find(bid).value().c_str(), &st) != 0) {
+            std::abort();
+        }
+    }
+    auto looked_up = clock_type::now();
+    session.remove(bids);
+    auto unlinked = clock_type::now();
+    std::cout << "levels: " << levels << ", files: " << count
+              << ", creates/s: " << static_cast<std::uint64_t>(rate(count, created - begin))
+              << ", lookups/s: " << static_cast<std::uint64_t>(rate(count, looked_up - created))
+              << ", unlinks/s: " << static_cast<std::uint64_t>(rate(count, unlinked - looked_up));
+
+    if (FLAGS_wipe) {
+        create_files(session_impl, count);
+        manager.reset();
+        auto wipe_begin = clock_type::now();
+        manager = start(a, levels);
+        auto wiped = clock_type::now();
+        std::cout << ", purge at start: " << std::chrono::duration_cast<std::chrono::milliseconds>(wiped - wipe_begin).count() << " ms";
+    }
+    std::cout << std::endl;
+    manager.reset();
+    std::filesystem::remove_all(FLAGS_directory);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    gflags::SetUsageMessage("session store fan-out layout benchmark");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+    api a{
+        [](std::uint64_t, std::uint64_t) { return std::uint64_t{}; },
+        [](std::uint64_t) { return std::filesystem::path{}; }
+    };
+    for (auto count : parse_list(FLAGS_counts)) {
+        for (auto levels : parse_list(FLAGS_levels)) {
+            measure(a, levels, count);
+        }
+    }
+    return 0;
+}
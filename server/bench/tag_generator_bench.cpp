@@ -0,0 +1,133 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// compares the throughput of the reference tag generation per thread, as done for each Put and each tag check,
+// between tag_generator reusing the keyed HMAC context, its batch API, and the one-shot HMAC used before
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+#include <data_relay_grpc/common/tag_generator.h>
+
+DEFINE_uint32(threads, 16, "the maximum number of threads, doubled from 1");
+DEFINE_uint32(batch, 64, "the number of BLOB ids tagged in a batch");
+DEFINE_uint32(duration, 1000, "the duration of each measurement in milliseconds");
+
+namespace {
+
+using generator_type = data_relay_grpc::common::tag_generator<std::uint64_t, std::uint64_t, std::uint64_t>;
+
+// the tag generation of tag_generator before the HMAC context was reused
+class one_shot {
+public:
+    one_shot() = default;
+
+    std::uint64_t generate_reference_tag(std::uint64_t p1, std::uint64_t p2) {
+        std::array<unsigned char, sizeof(p1) + sizeof(p2)> input_bytes{};
+        std::memcpy(input_bytes.data(), &p1, sizeof(p1));
+        std::memcpy(input_bytes.data() + sizeof(p1), &p2, sizeof(p2));
+        ERR_clear_error();
+        std::array<unsigned char, EVP_MAX_MD_SIZE> md{};
+        unsigned int md_len = 0;
+        if (HMAC(EVP_sha256(), key_.data(), static_cast<int>(key_.size()), input_bytes.data(), input_bytes.size(), md.data(), &md_len) == nullptr) {
+            throw std::runtime_error("HMAC failed");
+        }
+        std::uint64_t tag = 0;
+        std::memcpy(&tag, md.data(), sizeof(tag));
+        return tag;
+    }
+    void generate_reference_tags(const std::uint64_t* p1, std::size_t count, std::uint64_t p2, std::uint64_t* tags) {
+        for (std::size_t i = 0; i < count; i++) {
+            tags[i] = generate_reference_tag(p1[i], p2);
+        }
+    }
+
+private:
+    std::array<unsigned char, 16> key_{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+};
+
+template <class Generator, bool Batch>
+double run(Generator& generator, std::uint32_t threads) {
+    std::atomic_bool stop{};
+    std::atomic<std::uint64_t> total{};
+    std::atomic<std::uint64_t> sink{};
+    std::vector<std::thread> workers{};
+    for (std::uint32_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]{
+            std::vector<std::uint64_t> ids(FLAGS_batch);
+            std::vector<std::uint64_t> tags(FLAGS_batch);
+            std::uint64_t next_id = static_cast<std::uint64_t>(t) << 40U;
+            std::uint64_t count = 0;
+            std::uint64_t x = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if constexpr (Batch) {
+                    for (auto&& e : ids) {
+                        e = next_id++;
+                    }
+                    generator.generate_reference_tags(ids.data(), ids.size(), t, tags.data());
+                    x ^= tags.back();
+                } else {
+                    for (std::uint32_t i = 0; i < FLAGS_batch; i++) {
+                        x ^= generator.generate_reference_tag(next_id++, t);
+                    }
+                }
+                count += FLAGS_batch;
+            }
+            total += count;
+            sink ^= x;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(FLAGS_duration));
+    stop = true;
+    for (auto&& e : workers) {
+        e.join();
+    }
+    return static_cast<double>(total.load()) * 1000.0 / FLAGS_duration;
+}
+
+template <class Generator, bool Batch>
+void measure(const char* name) {
+    Generator generator{};
+    for (std::uint32_t threads = 1; threads <= FLAGS_threads; threads *= 2) {
+        auto ops = run<Generator, Batch>(generator, threads);
+        std::cout << name << " threads: " << threads << ", tags/s: " << static_cast<std::uint64_t>(ops)
+                  << ", per thread: " << static_cast<std::uint64_t>(ops / threads) << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    gflags::SetUsageMessage("reference tag generation benchmark");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+    measure<one_shot, false>("one_shot");
+    measure<generator_type, false>("tag_generator");
+    measure<generator_type, true>("tag_generator batch");
+    return 0;
+}
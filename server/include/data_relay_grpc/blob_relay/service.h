@@ -19,6 +19,7 @@
 #include <functional>
 #include <filesystem>
 #include <memory>
+#include <string>
 
 #include <data_relay_grpc/common/session.h>
 #include <data_relay_grpc/common/api.h>
@@ -62,6 +63,12 @@ public:
 
     [[nodiscard]] common::blob_session_manager& get_session_manager() const noexcept override;
 
+    /**
+      * @brief returns the statistics of the relay in the Prometheus text exposition format.
+      * @details the same statistics are available from the BlobRelayStats service.
+      */
+    [[nodiscard]] std::string metrics_text() const;
+
 private:
     std::unique_ptr<blob_relay_service_impl, void(*)(blob_relay_service_impl*)> impl_;
 };
@@ -15,12 +15,51 @@
  */
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <cstdint>
 #include <filesystem>
+#include <vector>
 
 namespace data_relay_grpc::blob_relay {
 
+/**
+ * @brief the strategy to place a file uploaded by BlobRelayLocal.Put into the session store
+ * @details if the strategy is not available for the file, the next one in the order of
+ *    move, hardlink, reflink and copy is tried.
+ */
+enum class placement_strategy : std::uint8_t {
+    /// @brief reflink if local_upload_copy_file is set, otherwise hardlink, leaving the file uploaded as it is.
+    automatic = 0,
+
+    /// @brief rename the file into the session store, the file is consumed.
+    /// @details used only when the client requests it, the server configuration of this is treated as automatic.
+    move,
+
+    /// @brief create a hard link of the file in the session store.
+    hardlink,
+
+    /// @brief clone the file by FICLONE (copy-on-write).
+    reflink,
+
+    /// @brief copy the file contents by copy_file_range.
+    copy,
+};
+
+/**
+ * @brief the policy to place BLOB files uploaded in the directories of the striped session store
+ */
+enum class stripe_placement : std::uint8_t {
+    /// @brief the directories in turn.
+    round_robin = 0,
+
+    /// @brief the directory with the least usage, or with the most free space if session_quota_size is 0.
+    least_used,
+
+    /// @brief the directory determined by the hash of the BLOB ID.
+    hash,
+};
+
 /**
  * @brief blob relay service configuration
  */
@@ -60,6 +99,197 @@ public:
     bool dev_accept_mock_tag() const {
         return dev_accept_mock_tag_;
     }
+    placement_strategy local_upload_placement() const {
+        return local_upload_placement_;
+    }
+    void local_upload_placement(placement_strategy arg) {
+        local_upload_placement_ = arg;
+    }
+    /**
+     * @brief the Unix domain socket path to hand over file descriptors of BLOB files for BlobRelayLocal.
+     * @details file descriptor passing is disabled if the path is empty.
+     */
+    std::filesystem::path local_socket_path() const {
+        return local_socket_path_;
+    }
+    void local_socket_path(const std::filesystem::path& arg) {
+        local_socket_path_ = arg;
+    }
+    /**
+     * @brief the number of threads deleting BLOB files of disposed sessions and removed BLOBs in background.
+     * @details BLOB files are deleted synchronously if 0. The session storage usage is released immediately in either case.
+     */
+    std::size_t deletion_threads() const {
+        return deletion_threads_;
+    }
+    void deletion_threads(std::size_t arg) {
+        deletion_threads_ = arg;
+    }
+    /**
+     * @brief the number of threads deleting the files left in the session store at the start.
+     * @details the files are moved aside at once and deleted while the service accepts requests,
+     *    or are deleted before the service starts if 0.
+     */
+    std::size_t cleanup_threads() const {
+        return cleanup_threads_;
+    }
+    void cleanup_threads(std::size_t arg) {
+        cleanup_threads_ = arg;
+    }
+    /**
+     * @brief whether the sessions and the BLOB files uploaded to the session store survive a restart.
+     * @details the sessions are recorded in an index file (.index) in the session store, and are restored at the start
+     *    with their BLOB IDs and the session storage usage, instead of purging the files left in the session store.
+     */
+    bool persistent_index() const {
+        return persistent_index_;
+    }
+    void persistent_index(bool arg) {
+        persistent_index_ = arg;
+    }
+    /**
+     * @brief the maximum session storage usage of each session, in addition to session_quota_size for all sessions.
+     * @details the usage is not limited per session if 0.
+     */
+    std::size_t per_session_quota_size() const {
+        return per_session_quota_size_;
+    }
+    void per_session_quota_size(std::size_t arg) {
+        per_session_quota_size_ = arg;
+    }
+    /**
+     * @brief the maximum session storage usage of the sessions of each transaction.
+     * @details the usage is not limited per transaction if 0.
+     */
+    std::size_t per_transaction_quota_size() const {
+        return per_transaction_quota_size_;
+    }
+    void per_transaction_quota_size(std::size_t arg) {
+        per_transaction_quota_size_ = arg;
+    }
+    /**
+     * @brief the maximum time BlobRelayStreaming.Put exceeding session_quota_size waits for usage to be released.
+     * @details the waiting uploads are admitted in the order of arrival, and each waits until the deadline of the RPC
+     *    at most. Put fails with RESOURCE_EXHAUSTED immediately if 0.
+     */
+    std::chrono::milliseconds quota_wait_time() const {
+        return quota_wait_time_;
+    }
+    void quota_wait_time(std::chrono::milliseconds arg) {
+        quota_wait_time_ = arg;
+    }
+    /**
+     * @brief the additional directories to stripe the session store across, e.g. on different devices.
+     * @details the BLOB files uploaded are placed in session_store and these directories by stripe_placement,
+     *    and each directory has an equal share of session_quota_size. The session index is placed in session_store.
+     */
+    std::vector<std::filesystem::path> session_store_stripes() const {
+        return session_store_stripes_;
+    }
+    void session_store_stripes(const std::vector<std::filesystem::path>& arg) {
+        session_store_stripes_ = arg;
+    }
+    stripe_placement session_store_stripe_placement() const {
+        return session_store_stripe_placement_;
+    }
+    void session_store_stripe_placement(stripe_placement arg) {
+        session_store_stripe_placement_ = arg;
+    }
+    /**
+     * @brief the number of levels of the subdirectories in the session store where the BLOB files are placed.
+     * @details each level has 256 subdirectories keyed by the BLOB ID, which are created at the start, so that
+     *    no directory has too many entries. The BLOB files are placed in the session store directly if 0.
+     *    This must not be changed while persistent_index is enabled, otherwise the BLOB files left are not found.
+     */
+    std::size_t session_store_fanout_levels() const {
+        return session_store_fanout_levels_;
+    }
+    void session_store_fanout_levels(std::size_t arg) {
+        session_store_fanout_levels_ = arg;
+    }
+    /**
+     * @brief the size of a segment file packing the tiny BLOBs uploaded by BlobRelayStreaming.Put.
+     * @details the BLOBs up to segment_threshold not kept in the memory tier are appended to the segment files
+     *    in the session store instead of creating a file for each, and are written to their own files when
+     *    BlobRelayLocal.Get requires their paths. The BLOBs in the segment files are not restored after restart,
+     *    even if persistent_index is enabled. Each BLOB is placed in its own file if 0.
+     */
+    std::size_t segment_file_size() const {
+        return segment_file_size_;
+    }
+    void segment_file_size(std::size_t arg) {
+        segment_file_size_ = arg;
+    }
+    /**
+     * @brief the maximum size of a BLOB packed in the segment files.
+     */
+    std::size_t segment_threshold() const {
+        return segment_threshold_;
+    }
+    void segment_threshold(std::size_t arg) {
+        segment_threshold_ = arg;
+    }
+    /**
+     * @brief the memory available to keep the BLOBs uploaded by BlobRelayStreaming.Put in memory instead of files.
+     * @details the BLOBs up to memory_tier_threshold are kept in memory while the budget allows, and the others are
+     *    written to the session store. A BLOB in memory is written to a file when BlobRelayLocal.Get requires its path.
+     *    The memory tier is disabled if 0.
+     */
+    std::size_t memory_tier_size() const {
+        return memory_tier_size_;
+    }
+    void memory_tier_size(std::size_t arg) {
+        memory_tier_size_ = arg;
+    }
+    /**
+     * @brief the maximum size of a BLOB kept in the memory tier.
+     */
+    std::size_t memory_tier_threshold() const {
+        return memory_tier_threshold_;
+    }
+    void memory_tier_threshold(std::size_t arg) {
+        memory_tier_threshold_ = arg;
+    }
+    /**
+     * @brief the maximum number of the tags returned by api.get_tag to be cached.
+     * @details the tag of a BLOB is cached for the transaction, or the session without transaction, until the session
+     *    is disposed, so that reading the BLOB again does not call api.get_tag. The cache is disabled if 0.
+     */
+    std::size_t tag_cache_size() const {
+        return tag_cache_size_;
+    }
+    void tag_cache_size(std::size_t arg) {
+        tag_cache_size_ = arg;
+    }
+    /**
+     * @brief the maximum number of the paths in the limestone blob store to be cached.
+     * @details BlobRelayStreaming.Get caches the path returned by api.get_path with whether the file exists,
+     *    for path_cache_ttl if it exists, or for path_cache_negative_ttl if not. The cache is disabled if 0.
+     */
+    std::size_t path_cache_size() const {
+        return path_cache_size_;
+    }
+    void path_cache_size(std::size_t arg) {
+        path_cache_size_ = arg;
+    }
+    /**
+     * @brief the time the path of an existing file is cached.
+     */
+    std::chrono::milliseconds path_cache_ttl() const {
+        return path_cache_ttl_;
+    }
+    void path_cache_ttl(std::chrono::milliseconds arg) {
+        path_cache_ttl_ = arg;
+    }
+    /**
+     * @brief the time the path of a file not found is cached.
+     */
+    std::chrono::milliseconds path_cache_negative_ttl() const {
+        return path_cache_negative_ttl_;
+    }
+    void path_cache_negative_ttl(std::chrono::milliseconds arg) {
+        path_cache_negative_ttl_ = arg;
+    }
 
 private:
     std::filesystem::path session_store_;
@@ -68,6 +298,25 @@ private:
     bool local_upload_copy_file_;
     std::size_t stream_chunk_size_;
     bool dev_accept_mock_tag_;
+    placement_strategy local_upload_placement_{placement_strategy::automatic};
+    std::filesystem::path local_socket_path_{};
+    std::size_t deletion_threads_{0};
+    std::size_t cleanup_threads_{2};
+    bool persistent_index_{false};
+    std::size_t per_session_quota_size_{0};
+    std::size_t per_transaction_quota_size_{0};
+    std::chrono::milliseconds quota_wait_time_{0};
+    std::vector<std::filesystem::path> session_store_stripes_{};
+    stripe_placement session_store_stripe_placement_{stripe_placement::round_robin};
+    std::size_t session_store_fanout_levels_{0};
+    std::size_t segment_file_size_{0};
+    std::size_t segment_threshold_{4UL * 1024UL};
+    std::size_t memory_tier_size_{0};
+    std::size_t memory_tier_threshold_{64UL * 1024UL};
+    std::size_t tag_cache_size_{0};
+    std::size_t path_cache_size_{0};
+    std::chrono::milliseconds path_cache_ttl_{10000};
+    std::chrono::milliseconds path_cache_negative_ttl_{500};
 };
 
 } // namespace
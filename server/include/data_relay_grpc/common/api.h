@@ -1,5 +1,5 @@
 /*
- * Copyright 2025-2025 Project Tsurugi.
+ * Copyright 2025-2026 Project Tsurugi.
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -15,6 +15,7 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <functional>
 #include <filesystem>
 
@@ -27,10 +28,30 @@ namespace data_relay_grpc::common {
  */
 class api {
 public:
+    /**
+     * @brief the function filling tags[i] with the tag of blob_ids[i] in the transaction, for i in [0, count).
+     */
+    using get_tags_type = std::function<void(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::transaction_id_type, blob_session::blob_tag_type* tags)>;
+
+    /**
+     * @brief the function filling paths[i] with the path of blob_ids[i], for i in [0, count).
+     */
+    using get_paths_type = std::function<void(const blob_session::blob_id_type* blob_ids, std::size_t count, std::filesystem::path* paths)>;
+
     api(const std::function<blob_session::blob_tag_type(blob_session::blob_id_type, blob_session::transaction_id_type)> get_tag,
         const std::function<std::filesystem::path(blob_session::blob_id_type)> get_path)
         : get_tag_(get_tag), get_path_(get_path) {}
 
+    /**
+     * @brief creates the api with the batch variants, which are used instead of get_tag and get_path for multiple BLOBs.
+     * @details either of get_tags and get_paths may be empty, in which case the scalar one is called for each BLOB.
+     */
+    api(const std::function<blob_session::blob_tag_type(blob_session::blob_id_type, blob_session::transaction_id_type)> get_tag,
+        const std::function<std::filesystem::path(blob_session::blob_id_type)> get_path,
+        const get_tags_type get_tags,
+        const get_paths_type get_paths)
+        : get_tag_(get_tag), get_path_(get_path), get_tags_(get_tags), get_paths_(get_paths) {}
+
     api(api const&) = default;
     api(api&&) = delete;
     api& operator=(api const&) = default;
@@ -38,10 +59,14 @@ public:
 
     const std::function<blob_session::blob_tag_type(blob_session::blob_id_type, blob_session::transaction_id_type)>& get_tag() {return get_tag_; }
     const std::function<std::filesystem::path(blob_session::blob_id_type)>& get_path() { return get_path_; }
+    const get_tags_type& get_tags() { return get_tags_; }
+    const get_paths_type& get_paths() { return get_paths_; }
 
 private:
     std::function<blob_session::blob_tag_type(blob_session::blob_id_type, blob_session::transaction_id_type)> get_tag_;
     std::function<std::filesystem::path(blob_session::blob_id_type)> get_path_;
+    get_tags_type get_tags_{};
+    get_paths_type get_paths_{};
 };
 
 } // namespace
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief an open addressing hash table from BLOB IDs to the entries of a session
+ * @details entries are stored inline in one array with linear probing, and are removed by backward shifting
+ *    so that no tombstone remains. This class is not thread-safe.
+ * @tparam Value the entry type, which must be default constructible and movable
+ * @note the BLOB ID 0 is reserved to represent an empty slot, which is never assigned by blob_session_manager.
+ */
+template <class Value>
+class blob_index {
+public:
+    using key_type = std::uint64_t;
+
+    constexpr static key_type empty_key = 0;
+
+    /**
+     * @brief returns the entry of the key.
+     * @return the pointer to the entry, or nullptr if not found
+     */
+    [[nodiscard]] Value* find(key_type key) noexcept {
+        if (auto pos = position(key); pos) {
+            return &slots_[pos.value()].value;
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] const Value* find(key_type key) const noexcept {
+        if (auto pos = position(key); pos) {
+            return &slots_[pos.value()].value;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief inserts the entry if the key does not exist.
+     * @return the pointer to the entry in the table, valid until the next modification, and whether it has been inserted
+     */
+    std::pair<Value*, bool> emplace(key_type key, Value value) {
+        if ((size_ + 1) * max_load_denominator > slots_.size() * max_load_numerator) {
+            rehash(slots_.empty() ? initial_capacity : slots_.size() * 2);
+        }
+        auto mask = slots_.size() - 1;
+        for (auto i = home(key); ; i = (i + 1) & mask) {
+            auto& s = slots_[i];
+            if (s.key == key) {
+                return { &s.value, false };
+            }
+            if (s.key == empty_key) {
+                s.key = key;
+                s.value = std::move(value);
+                ++size_;
+                return { &s.value, true };
+            }
+        }
+    }
+
+    /**
+     * @brief makes room for the entries so that inserting them does not rehash the table.
+     * @param count the number of entries to be inserted in addition to the current ones
+     */
+    void reserve(std::size_t count) {
+        auto capacity = slots_.empty() ? initial_capacity : slots_.size();
+        while ((size_ + count) * max_load_denominator > capacity * max_load_numerator) {
+            capacity *= 2;
+        }
+        if (capacity != slots_.size()) {
+            rehash(capacity);
+        }
+    }
+
+    /**
+     * @brief removes the entry of the key and returns it.
+     * @return the removed entry, or std::nullopt if not found
+     */
+    std::optional<Value> extract(key_type key) {
+        auto pos = position(key);
+        if (!pos) {
+            return std::nullopt;
+        }
+        auto mask = slots_.size() - 1;
+        auto hole = pos.value();
+        std::optional<Value> rv{std::move(slots_[hole].value)};
+        // shift the following entries of the probe sequence back into the hole
+        for (auto i = (hole + 1) & mask; slots_[i].key != empty_key; i = (i + 1) & mask) {
+            auto h = home(slots_[i].key);
+            if (((i - h) & mask) >= ((i - hole) & mask)) {
+                slots_[hole] = std::move(slots_[i]);
+                hole = i;
+            }
+        }
+        slots_[hole] = slot{};
+        --size_;
+        return rv;
+    }
+
+    /**
+     * @brief calls the function with the key and the entry of each entry in no particular order.
+     */
+    template <class F>
+    void for_each(F&& f) {
+        for (auto&& s : slots_) {
+            if (s.key != empty_key) {
+                f(s.key, s.value);
+            }
+        }
+    }
+
+    template <class F>
+    void for_each(F&& f) const {
+        for (auto&& s : slots_) {
+            if (s.key != empty_key) {
+                f(s.key, s.value);
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return size_;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    /**
+     * @brief returns the bytes allocated for the slots, excluding memory owned by the entries.
+     */
+    [[nodiscard]] std::size_t memory_usage() const noexcept {
+        return slots_.capacity() * sizeof(slot);
+    }
+
+private:
+    struct slot {
+        key_type key{empty_key};
+        Value value{};
+    };
+
+    constexpr static std::size_t initial_capacity = 8;
+    constexpr static std::size_t max_load_numerator = 7;
+    constexpr static std::size_t max_load_denominator = 8;
+
+    std::vector<slot> slots_{};
+    std::size_t size_{};
+    unsigned shift_{};
+
+    std::size_t home(key_type key) const noexcept {
+        // Fibonacci hashing, as the BLOB IDs are mostly sequential
+        constexpr std::uint64_t multiplier = 0x9e3779b97f4a7c15ULL;
+        return static_cast<std::size_t>((key * multiplier) >> shift_);
+    }
+
+    std::optional<std::size_t> position(key_type key) const noexcept {
+        if (slots_.empty() || key == empty_key) {
+            return std::nullopt;
+        }
+        auto mask = slots_.size() - 1;
+        for (auto i = home(key); ; i = (i + 1) & mask) {
+            if (slots_[i].key == key) {
+                return i;
+            }
+            if (slots_[i].key == empty_key) {
+                return std::nullopt;
+            }
+        }
+    }
+
+    void rehash(std::size_t capacity) {
+        std::vector<slot> old(capacity);
+        old.swap(slots_);
+        shift_ = 64U;  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+        for (auto c = capacity; c > 1; c >>= 1U) {
+            --shift_;
+        }
+        auto mask = slots_.size() - 1;
+        for (auto&& s : old) {
+            if (s.key != empty_key) {
+                auto i = home(s.key);
+                while (slots_[i].key != empty_key) {
+                    i = (i + 1) & mask;
+                }
+                slots_[i] = std::move(s);
+            }
+        }
+    }
+};
+
+} // namespace
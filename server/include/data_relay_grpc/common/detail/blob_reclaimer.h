@@ -0,0 +1,111 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief deletes BLOB files no longer used, in background worker threads if any
+ * @details the session storage usage is released by the caller before the files are passed to this object,
+ *    so that the quota is available immediately.
+ */
+class blob_reclaimer {
+public:
+    /**
+     * @brief creates the object and starts the worker threads.
+     * @param threads the number of worker threads, or 0 to delete files synchronously in the caller's thread
+     */
+    explicit blob_reclaimer(std::size_t threads);
+
+    /**
+     * @brief stops the sweep if running, deletes all pending files, and then stops the worker threads.
+     */
+    ~blob_reclaimer();
+
+    blob_reclaimer(const blob_reclaimer&) = delete;
+    blob_reclaimer& operator=(const blob_reclaimer&) = delete;
+    blob_reclaimer(blob_reclaimer&&) = delete;
+    blob_reclaimer& operator=(blob_reclaimer&&) = delete;
+
+    /**
+     * @brief deletes the file, which may not exist.
+     * @param path the path of the file
+     */
+    void remove(std::filesystem::path path);
+
+    /**
+     * @brief deletes the files, which may not exist.
+     * @param paths the paths of the files
+     */
+    void remove(std::vector<std::filesystem::path> paths);
+
+    /**
+     * @brief deletes the files in the directories which satisfy the predicate, scanning them in background if there are worker threads.
+     * @details the subdirectories whose names start with '.' are not scanned. The files found are counted as pending
+     *    only when queued, while the sweep running keeps pending() above 0.
+     * @param directories the directories to scan recursively
+     * @param pred the predicate of the path of a file to delete, called in the scanning thread
+     */
+    void sweep(std::vector<std::filesystem::path> directories, std::function<bool(const std::filesystem::path&)> pred);
+
+    /**
+     * @brief returns the number of files waiting for or under deletion.
+     */
+    [[nodiscard]] std::size_t pending() const noexcept {
+        return pending_.load();
+    }
+
+    /**
+     * @brief returns the number of files deleted so far.
+     */
+    [[nodiscard]] std::size_t deleted() const noexcept {
+        return deleted_.load();
+    }
+
+    /**
+     * @brief waits until no file is pending.
+     */
+    void wait_idle();
+
+private:
+    std::deque<std::filesystem::path> queue_{};
+    std::atomic<std::size_t> pending_{};
+    std::atomic<std::size_t> deleted_{};
+    bool stopping_{};
+    std::mutex mtx_{};
+    std::condition_variable cv_{};
+    std::condition_variable idle_cv_{};
+    std::vector<std::thread> workers_{};
+    std::thread sweeper_{};
+    std::atomic<bool> stop_sweep_{};
+
+    void run();
+    std::vector<std::filesystem::path> scan(const std::vector<std::filesystem::path>& directories, const std::function<bool(const std::filesystem::path&)>& pred);
+    void unlink(const std::filesystem::path& path);
+    void done(std::size_t count);
+};
+
+} // namespace
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief returns the stripe of the current thread, assigned to the threads in turn.
+ * @param stripes the number of stripes, must be a power of two
+ */
+std::size_t metric_stripe(std::size_t stripes) noexcept;
+
+/**
+ * @brief a counter split into the cells updated by different threads
+ * @details each thread adds to its own cell without contention in most cases, and the value is the sum of the cells.
+ */
+class striped_counter {
+public:
+    static constexpr std::size_t stripes = 16;
+
+    void add(std::uint64_t n = 1) noexcept {
+        cells_[metric_stripe(stripes)].value.fetch_add(n, std::memory_order_relaxed);  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+
+    [[nodiscard]] std::uint64_t value() const noexcept {
+        std::uint64_t rv{};
+        for (auto&& e : cells_) {
+            rv += e.value.load(std::memory_order_relaxed);
+        }
+        return rv;
+    }
+
+private:
+    struct alignas(64) cell {  // NOLINT(cppcoreguidelines-avoid-magic-numbers): cache line size
+        std::atomic<std::uint64_t> value{};
+    };
+    std::array<cell, stripes> cells_{};
+};
+
+/**
+ * @brief a histogram of integer values with log-linear buckets, as in HdrHistogram
+ * @details each power of two is split into 2^sub_bucket_bits buckets, so that the value of a bucket is within
+ *    1/2^sub_bucket_bits of the values recorded in it. Values are recorded to the stripe of the thread without lock.
+ */
+class histogram {
+public:
+    static constexpr std::size_t sub_bucket_bits = 3;
+    static constexpr std::size_t sub_buckets = 1U << sub_bucket_bits;
+    static constexpr std::size_t bucket_count = (64 - sub_bucket_bits + 1) * sub_buckets;
+    static constexpr std::size_t stripes = 4;
+
+    /**
+     * @brief the values recorded at a point in time
+     */
+    struct snapshot {
+        std::uint64_t count{};
+        std::uint64_t sum{};
+        std::uint64_t max{};
+        std::vector<std::uint64_t> buckets{};
+
+        /**
+         * @brief returns the value at the percentile, the upper bound of the bucket where it falls.
+         * @param percentile the percentile in [0, 100]
+         */
+        [[nodiscard]] std::uint64_t value_at(double percentile) const noexcept;
+    };
+
+    void record(std::uint64_t value) noexcept;
+
+    [[nodiscard]] snapshot take() const;
+
+    /**
+     * @brief returns the index of the bucket of the value.
+     */
+    [[nodiscard]] static std::size_t bucket_of(std::uint64_t value) noexcept;
+
+    /**
+     * @brief returns the largest value in the bucket.
+     */
+    [[nodiscard]] static std::uint64_t upper_bound(std::size_t bucket) noexcept;
+
+private:
+    struct alignas(64) stripe {  // NOLINT(cppcoreguidelines-avoid-magic-numbers): cache line size
+        std::array<std::atomic<std::uint64_t>, bucket_count> buckets{};
+        std::atomic<std::uint64_t> sum{};
+        std::atomic<std::uint64_t> max{};
+    };
+    std::array<stripe, stripes> stripes_{};
+};
+
+} // namespace
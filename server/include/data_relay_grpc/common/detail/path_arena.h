@@ -0,0 +1,85 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief an arena interning the paths of BLOB files added from outside of the session store
+ * @details the same path added by multiple sessions is stored once, and is freed when the last of them releases it.
+ */
+class path_arena {
+public:
+    /// @brief the handle of an interned path, which is valid until released
+    using handle_type = const std::string*;
+
+    /**
+     * @brief interns the path.
+     * @param path the path string
+     * @return the handle of the interned path, which must be released by release()
+     */
+    [[nodiscard]] handle_type intern(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto itr = paths_.try_emplace(path, 0).first;
+        ++itr->second;
+        return &itr->first;
+    }
+
+    /**
+     * @brief interns the paths at once, taking the lock only once.
+     * @param paths the pointer to the first path string
+     * @param count the number of paths
+     * @param handles the pointer to the array receiving the handles, which must be released by release()
+     */
+    void intern(const std::string* paths, std::size_t count, handle_type* handles) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (std::size_t i = 0; i < count; i++) {
+            auto itr = paths_.try_emplace(paths[i], 0).first;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            ++itr->second;
+            handles[i] = &itr->first;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+    }
+
+    /**
+     * @brief releases the handle returned by intern().
+     * @param handle the handle, which must not be used afterwards
+     */
+    void release(handle_type handle) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (auto itr = paths_.find(*handle); itr != paths_.end() && --itr->second == 0) {
+            paths_.erase(itr);
+        }
+    }
+
+    /**
+     * @brief returns the number of distinct paths interned.
+     */
+    [[nodiscard]] std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return paths_.size();
+    }
+
+private:
+    std::unordered_map<std::string, std::size_t> paths_{};  // the path and its reference count
+    mutable std::mutex mtx_{};
+};
+
+} // namespace
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief a bounded cache of the paths returned by api.get_path, with whether the file exists
+ * @details an entry expires after the TTL, which is usually shorter for the files not found, so that a BLOB
+ *    committed later or deleted by the datastore is noticed. The cache is split into shards by the BLOB ID,
+ *    and the entries expired, or the one found first if none, are evicted when the shard is full.
+ */
+class path_cache {
+public:
+    using blob_id_type = std::uint64_t;
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t shard_count = 16;
+
+    /**
+     * @brief the path of a BLOB and whether the file exists
+     */
+    struct entry {
+        std::filesystem::path path{};
+        bool exists{};
+    };
+
+    /**
+     * @brief creates the cache.
+     * @param capacity the maximum number of the entries, or 0 to disable the cache
+     * @param ttl the time an entry of an existing file is kept
+     * @param negative_ttl the time an entry of a file not found is kept
+     */
+    path_cache(std::size_t capacity, std::chrono::milliseconds ttl, std::chrono::milliseconds negative_ttl);
+
+    /**
+     * @brief returns whether the cache is enabled.
+     */
+    [[nodiscard]] bool enabled() const noexcept {
+        return capacity_ > 0;
+    }
+
+    /**
+     * @brief returns the entry not expired, counting a hit or a miss.
+     */
+    [[nodiscard]] std::optional<entry> find(blob_id_type blob_id);
+
+    /**
+     * @brief caches the entry, replacing the existing one.
+     */
+    void insert(blob_id_type blob_id, entry e);
+
+    /**
+     * @brief returns the number of lookups which found the entry of an existing file.
+     */
+    [[nodiscard]] std::uint64_t hits() const;
+
+    /**
+     * @brief returns the number of lookups which found the entry of a file not found.
+     */
+    [[nodiscard]] std::uint64_t negative_hits() const;
+
+    /**
+     * @brief returns the number of lookups which did not find the entry, or found it expired.
+     */
+    [[nodiscard]] std::uint64_t misses() const;
+
+    /**
+     * @brief returns the number of the entries, including those expired.
+     */
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    struct cached {
+        entry value{};
+        clock::time_point expires{};
+    };
+    struct alignas(64) shard {  // NOLINT(cppcoreguidelines-avoid-magic-numbers): cache line size
+        mutable std::mutex mtx{};
+        std::unordered_map<blob_id_type, cached> entries{};
+        std::uint64_t hits{};
+        std::uint64_t negative_hits{};
+        std::uint64_t misses{};
+    };
+
+    std::size_t capacity_;
+    std::size_t shard_capacity_;
+    std::chrono::milliseconds ttl_;
+    std::chrono::milliseconds negative_ttl_;
+    std::array<shard, shard_count> shards_{};
+
+    shard& shard_for(blob_id_type blob_id) noexcept;
+    template <class F>
+    std::uint64_t sum(F&& f) const;
+};
+
+} // namespace
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief an accountant of the session storage usage against the quota, scalable with concurrent threads
+ * @details each thread reserves the usage from a slab of quota leased in large units from the global budget,
+ *    so that the shared counter is rarely touched. When the rest of the budget becomes small, the quota is leased
+ *    exactly as requested, and the quota held by the slabs is returned to the budget before a reservation fails,
+ *    so that the quota is enforced exactly near the limit.
+ */
+class quota_accountant {
+public:
+    /// @brief the default unit of quota leased to a slab
+    constexpr static std::size_t default_lease_unit = 1024UL * 1024UL;
+
+    /**
+     * @brief creates the object.
+     * @param quota the quota in bytes, or 0 not to limit (and not to count) the usage
+     * @param lease_unit the unit of quota leased to a slab
+     */
+    explicit quota_accountant(std::size_t quota, std::size_t lease_unit = default_lease_unit) noexcept;
+
+    /**
+     * @brief reserves the usage.
+     * @param size the size in bytes
+     * @return true if reserved, or false if the usage would exceed the quota
+     */
+    bool reserve(std::size_t size) noexcept;
+
+    /**
+     * @brief releases the usage reserved.
+     * @param size the size in bytes
+     */
+    void release(std::size_t size) noexcept;
+
+    /**
+     * @brief adds the usage regardless of the quota, e.g. the usage restored at the start.
+     * @param size the size in bytes
+     */
+    void restore(std::size_t size) noexcept;
+
+    /**
+     * @brief returns the quota in bytes, or 0 if not limited.
+     */
+    [[nodiscard]] std::size_t quota() const noexcept {
+        return quota_;
+    }
+
+    /**
+     * @brief returns the usage reserved, which is exact if no other thread is changing it.
+     */
+    [[nodiscard]] std::size_t used() const noexcept;
+
+private:
+    struct alignas(64) slab {  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+        std::atomic<std::size_t> available{};
+    };
+    constexpr static std::size_t slab_count = 64;
+
+    std::size_t quota_;
+    std::size_t lease_unit_;
+    alignas(64) std::atomic<std::size_t> leased_{};  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+    std::array<slab, slab_count> slabs_{};
+
+    slab& local_slab() noexcept;
+    bool near_limit() const noexcept;
+    bool lease(std::size_t amount) noexcept;
+    bool take(slab& s, std::size_t size) noexcept;
+    void drain() noexcept;
+};
+
+} // namespace
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief a first-in first-out queue of reservations waiting for the session storage usage to be released
+ * @details only the reservation at the head of the queue is retried when usage is released, so that a large
+ *    reservation is not starved by smaller ones arriving later.
+ */
+class quota_admission {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief waits in the queue until the reservation succeeds or the deadline passes.
+     * @param try_reserve the function reserving the usage, which returns true if reserved
+     * @param deadline the time to give up waiting
+     * @return true if reserved
+     */
+    bool wait(const std::function<bool()>& try_reserve, clock::time_point deadline);
+
+    /**
+     * @brief wakes up the reservation at the head of the queue, called when usage is released.
+     */
+    void notify();
+
+    /**
+     * @brief returns the number of reservations waiting.
+     */
+    [[nodiscard]] std::size_t waiting() const noexcept {
+        return waiting_.load();
+    }
+
+    /**
+     * @brief returns the maximum number of reservations waiting at once so far.
+     */
+    [[nodiscard]] std::size_t max_waiting() const noexcept {
+        return max_waiting_.load();
+    }
+
+    /**
+     * @brief returns the number of reservations which have waited so far.
+     */
+    [[nodiscard]] std::uint64_t waits() const noexcept {
+        return waits_.load();
+    }
+
+    /**
+     * @brief returns the number of reservations which have given up waiting so far.
+     */
+    [[nodiscard]] std::uint64_t timeouts() const noexcept {
+        return timeouts_.load();
+    }
+
+    /**
+     * @brief returns the total time of the reservations waiting so far.
+     */
+    [[nodiscard]] std::chrono::nanoseconds wait_time() const noexcept {
+        return std::chrono::nanoseconds(wait_time_.load());
+    }
+
+private:
+    std::mutex mtx_{};
+    std::condition_variable cv_{};
+    std::deque<std::uint64_t> queue_{};  // the tickets of the reservations waiting
+    std::uint64_t next_ticket_{};
+
+    std::atomic<std::size_t> waiting_{};
+    std::atomic<std::size_t> max_waiting_{};
+    std::atomic<std::uint64_t> waits_{};
+    std::atomic<std::uint64_t> timeouts_{};
+    std::atomic<std::int64_t> wait_time_{};
+};
+
+} // namespace
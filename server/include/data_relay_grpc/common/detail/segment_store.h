@@ -0,0 +1,115 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief a log-structured store packing tiny BLOBs into large segment files
+ * @details each BLOB is appended to the active segment file, and is located by the (offset, length) kept in memory,
+ *    so that no file is created nor deleted for each BLOB. A segment file is deleted when all of its BLOBs are removed,
+ *    and the BLOBs left in a segment mostly removed are moved to the active segment to reclaim the space.
+ *    The segment files are not recovered after restart.
+ */
+class segment_store {
+public:
+    using key_type = std::uint64_t;
+
+    /**
+     * @brief creates the store in the directory, deleting the segment files left in it.
+     * @param directory the directory of the segment files, created if not exists
+     * @param segment_size the size of a segment file, which is sealed when it is full
+     * @throws std::runtime_error if the directory cannot be created
+     */
+    segment_store(std::filesystem::path directory, std::size_t segment_size);
+
+    ~segment_store() = default;
+
+    segment_store(const segment_store&) = delete;
+    segment_store& operator=(const segment_store&) = delete;
+    segment_store(segment_store&&) = delete;
+    segment_store& operator=(segment_store&&) = delete;
+
+    /**
+     * @brief appends a BLOB.
+     * @param key the key of the BLOB, which must not be in this store
+     * @param data the BLOB data, up to the segment size
+     * @return true if appended, or false if the segment file cannot be written
+     */
+    bool append(key_type key, std::string_view data);
+
+    /**
+     * @brief reads a BLOB.
+     * @return the BLOB data, or std::nullopt if the BLOB is not in this store or cannot be read
+     */
+    [[nodiscard]] std::optional<std::string> read(key_type key) const;
+
+    /**
+     * @brief removes a BLOB, and reclaims the space of the segment if most of it is no longer used.
+     * @return true if removed, or false if the BLOB is not in this store
+     */
+    bool remove(key_type key);
+
+    /**
+     * @brief returns the number of segment files.
+     */
+    [[nodiscard]] std::size_t segment_count() const;
+
+    /**
+     * @brief returns the total size of the BLOBs in this store.
+     */
+    [[nodiscard]] std::size_t live_size() const;
+
+    /**
+     * @brief returns the total size of the segment files, including the space of the BLOBs removed.
+     */
+    [[nodiscard]] std::size_t file_size() const;
+
+private:
+    struct segment;
+    struct location {
+        std::shared_ptr<segment> seg{};
+        std::uint64_t offset{};
+        std::size_t length{};
+    };
+
+    std::filesystem::path directory_;
+    std::size_t segment_size_;
+    mutable std::mutex mtx_{};
+    std::unordered_map<key_type, location> index_{};
+    std::map<std::uint64_t, std::shared_ptr<segment>> segments_{};
+    std::shared_ptr<segment> active_{};
+    std::uint64_t next_segment_id_{};
+    std::atomic_bool compacting_{};
+
+    std::optional<location> reserve(std::size_t length);
+    void release(const location& loc);
+    void compact(const std::shared_ptr<segment>& seg);
+};
+
+} // namespace
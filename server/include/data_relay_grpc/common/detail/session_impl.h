@@ -15,25 +15,61 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
-#include <map>
+#include <memory>
 #include <optional>
 #include <filesystem>
 #include <vector>
 #include <atomic>
 #include <mutex>
+#include <shared_mutex>
+#include <string_view>
 
 #include <data_relay_grpc/common/session.h>
 #include <data_relay_grpc/common/detail/session_manager.h>
+#include <data_relay_grpc/common/detail/blob_index.h>
+#include <data_relay_grpc/common/detail/path_arena.h>
 
 namespace data_relay_grpc::common::detail {
 
 class blob_session_manager;
 
+/**
+ * @brief the level of the quota which a reservation of the session storage usage has exceeded
+ */
+enum class quota_level : std::uint8_t {
+    /// @brief no quota has been exceeded, i.e. the usage has been reserved.
+    none = 0,
+
+    /// @brief the quota of each session.
+    session,
+
+    /// @brief the quota of the sessions of each transaction.
+    transaction,
+
+    /// @brief the quota of the session store shared by all sessions.
+    store,
+};
+
+/**
+ * @brief returns the message of RESOURCE_EXHAUSTED for the quota level exceeded.
+ */
+inline std::string_view quota_exceeded_message(quota_level level) noexcept {
+    switch (level) {
+        case quota_level::session: return "session storage usage of the session has reached its limit";
+        case quota_level::transaction: return "session storage usage of the transaction has reached its limit";
+        default: return "session storage usage has reached its limit";
+    }
+}
+
 /**
  * @brief blob session impl class
+ * @details the object is shared by the session registry and the handles pinning it,
+ *    and the BLOB files of a disposed session are deleted when the last of them releases the object.
  */
-class blob_session_impl {
+class blob_session_impl : public std::enable_shared_from_this<blob_session_impl> {
 public:
     using session_id_type = blob_session::session_id_type;
     using transaction_id_type = blob_session::transaction_id_type;
@@ -44,6 +80,16 @@ public:
     blob_session_impl(session_id_type session_id, blob_session_store& session_store, std::optional<blob_session::transaction_id_type> transaction_id_opt, blob_session_manager& manager)
         : session_id_(session_id), session_store_(session_store), transaction_id_opt_(transaction_id_opt), manager_(manager) {}
 
+    /**
+     * @brief deletes the BLOB files in this session if it has been disposed.
+     */
+    ~blob_session_impl();
+
+    blob_session_impl(const blob_session_impl&) = delete;
+    blob_session_impl& operator=(const blob_session_impl&) = delete;
+    blob_session_impl(blob_session_impl&&) = delete;
+    blob_session_impl& operator=(blob_session_impl&&) = delete;
+
     /**
      * @brief returns the ID of this session.
      * @return the session ID
@@ -54,11 +100,20 @@ public:
 
     /**
      * @brief dispose this session and release all resources associated with it.
+     * @details the resources are released when the last handle pinning this session is released.
      * @note After calling this method, the session becomes invalid and cannot be used anymore.
      * @attention please ensure to call this method to avoid resource leaks before this object is destroyed.
      */
     void dispose();
 
+    /**
+     * @brief returns whether this session has been disposed.
+     * @return true if disposed
+     */
+    [[nodiscard]] bool disposed() const noexcept {
+        return disposed_.load();
+    }
+
     /**
      * @brief adds a BLOB data file path to this session.
      * @param path the path to the BLOB data file to add.
@@ -67,18 +122,45 @@ public:
      */
     [[nodiscard]] blob_session::blob_id_type add(blob_session::blob_path_type);
 
+    /**
+     * @brief adds BLOB data file paths to this session at once.
+     * @details each path is examined by one lstat(2), and the canonical paths of the directories are resolved
+     *    once for the paths in the same directory.
+     * @param paths the pointer to the first path
+     * @param count the number of paths
+     * @return the BLOB IDs assigned, which are consecutive
+     * @throws std::runtime_error if any of the paths does not exist, and then none of them is added
+     */
+    [[nodiscard]] std::vector<blob_id_type> add(const blob_path_type* paths, std::size_t count);
+
     /**
      * @brief find the BLOB data file path associated with the given BLOB ID.
+     * @details the BLOB in a memory file or packed in a segment file is written to its own file by materialize().
      * @param blob_id the BLOB ID to retrieve
      * @return the path to the BLOB data file if found
      * @return otherwise, std::nullopt.
      */
-    [[nodiscard]] std::optional<blob_session::blob_path_type> find(blob_session::blob_id_type blob_id) const {
-        std::lock_guard<std::mutex> lock(mtx_);
-        if (auto&& itr = blobs_.find(blob_id); itr != blobs_.end()) {
-            return itr->second.first;
+    [[nodiscard]] std::optional<blob_session::blob_path_type> find(blob_session::blob_id_type blob_id) {
+        {
+            std::shared_lock<std::shared_mutex> lock(mtx_);
+            auto* e = blobs_.find(blob_id);
+            if (e == nullptr) {
+                return std::nullopt;
+            }
+            if (!e->packed && e->fd < 0) {
+                return path_of(blob_id, *e);
+            }
         }
-        return std::nullopt;
+        // the BLOB has no path of its own which remains valid after the lock is released
+        return materialize(blob_id);
+    }
+
+    /**
+     * @brief returns the number of BLOBs in this session.
+     */
+    [[nodiscard]] std::size_t blob_count() const {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        return blobs_.size();
     }
 
     /**
@@ -86,11 +168,13 @@ public:
      * @return the list of added BLOB IDs.
      */
     [[nodiscard]] std::vector<blob_session::blob_id_type> entries() const {
-        std::lock_guard<std::mutex> lock(mtx_);
         std::vector<blob_session::blob_id_type> v{};
-        for (auto&& e: blobs_) {
-            v.emplace_back(e.first);
+        {
+            std::shared_lock<std::shared_mutex> lock(mtx_);
+            v.reserve(blobs_.size());
+            blobs_.for_each([&v](blob_id_type bid, const blob_entry&) { v.emplace_back(bid); });
         }
+        std::sort(v.begin(), v.end());
         return v;
     }
 
@@ -101,34 +185,234 @@ public:
       */
     [[nodiscard]] blob_session::blob_tag_type compute_tag(blob_session::blob_id_type blob_id) const;
 
+    /**
+      * @brief computes the tag values for the BLOB IDs in the given array at once.
+      * @param blob_ids the pointer to the first BLOB ID.
+      * @param count the number of BLOB IDs.
+      * @param tags the pointer to the array receiving the tag values.
+      */
+    void compute_tags(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::blob_tag_type* tags) const;
+
     /**
       * @brief generate a tag value for the given BLOB ID using api.get_tag.
+      * @details the tag is cached for the transaction of this session, and is not cached if this session has none.
       * @param blob_id the BLOB ID to compute the tag for.
       * @return the computed tag value.
       */
     [[nodiscard]] blob_session::blob_tag_type get_tag(blob_session::blob_id_type blob_id) const;
 
+    /**
+      * @brief generate the tag values for the BLOB IDs in the given array using api.get_tags.
+      * @param blob_ids the pointer to the first BLOB ID.
+      * @param count the number of BLOB IDs.
+      * @param tags the pointer to the array receiving the tag values.
+      */
+    void get_tags(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::blob_tag_type* tags) const;
+
 // below this point is for internal use
     std::pair<blob_id_type, std::filesystem::path> create_blob_file(const std::string prefix = "upload");
 
     void delete_blob_file(blob_id_type bid);
 
+    /**
+     * @brief deletes the BLOB files at once, taking the lock and releasing the session storage usage only once.
+     * @param bids the pointer to the first BLOB ID, the BLOB IDs not in this session are ignored
+     * @param count the number of BLOB IDs
+     */
+    void delete_blob_files(const blob_id_type* bids, std::size_t count);
+
+    /**
+     * @brief notifies that the contents of the BLOB file created by create_blob_file() have been completely written.
+     * @details the BLOB file is recorded in the session index if enabled, and is restored after restart.
+     * @param bid the BLOB ID
+     */
+    void complete_blob_file(blob_id_type bid);
+
     [[nodiscard]] std::optional<transaction_id_type> get_transaction_id() const noexcept;
 
     bool reserve_session_store(blob_id_type bid, std::size_t size);
 
+    /**
+     * @brief reserves the session storage usage for the BLOB, checking the quotas of the session, the transaction and the store in this order.
+     * @details the usage and the size of the BLOB are counted by atomic operations, and only the shared lock of this session
+     *    is taken, so that the reservations of the uploads in this session do not wait for each other.
+     * @param bid the BLOB ID created by create_blob_file()
+     * @param size the size to reserve in bytes
+     * @return quota_level::none if reserved, otherwise the level of the quota exceeded
+     * @throws std::out_of_range if the BLOB is not in this session
+     */
+    quota_level try_reserve_session_store(blob_id_type bid, std::size_t size);
+
+    /**
+     * @brief reserves the session storage usage for the BLOB, waiting for usage to be released if the quota of the store is exceeded.
+     * @details the reservation waits only if the admission wait is enabled, and the lock of this session is not held while waiting.
+     * @param deadline the deadline of the RPC
+     * @see try_reserve_session_store(blob_id_type, std::size_t)
+     */
+    quota_level try_reserve_session_store(blob_id_type bid, std::size_t size, std::chrono::system_clock::time_point deadline);
+
+    /**
+     * @brief adds a sealed memory file (memfd) to this session without copying it.
+     * @details the BLOB data is read through a descriptor opened by reopen_descriptor(), and is written to
+     *    the session store by materialize() if a path is required.
+     * @param fd the file descriptor, owned by this session if this function succeeds
+     * @param size the size of the file, which is subject to quota management
+     * @return the BLOB ID assigned, or std::nullopt if the session storage usage has reached its limit
+     */
+    [[nodiscard]] std::optional<blob_id_type> adopt_blob_file(int fd, std::size_t size);
+
+    /**
+     * @brief adds a sealed memory file (memfd) to this session without copying it.
+     * @param exceeded set to the level of the quota exceeded if std::nullopt is returned
+     * @see adopt_blob_file(int, std::size_t)
+     */
+    [[nodiscard]] std::optional<blob_id_type> adopt_blob_file(int fd, std::size_t size, quota_level& exceeded);
+
+    /**
+     * @brief adds a BLOB to this session in the memory tier, copying the data into a sealed memory file.
+     * @details the BLOB data is read through a descriptor opened by reopen_descriptor() while it is in memory,
+     *    and is moved to the session store by materialize() if a path is required.
+     * @param data the BLOB data
+     * @param exceeded set to the level of the quota exceeded if std::nullopt is returned
+     * @return the BLOB ID assigned, or std::nullopt if the quota is exceeded, or if exceeded is quota_level::none,
+     *    the BLOB does not fit in the memory tier and should be placed in the session store
+     */
+    [[nodiscard]] std::optional<blob_id_type> add_memory_blob(std::string_view data, quota_level& exceeded);
+
+    /**
+     * @brief adds a tiny BLOB to this session, appending the data to a segment file of the session store.
+     * @param data the BLOB data
+     * @param exceeded set to the level of the quota exceeded if std::nullopt is returned
+     * @return the BLOB ID assigned, or std::nullopt if the quota is exceeded, or if exceeded is quota_level::none,
+     *    the BLOB cannot be packed and should be placed in its own file
+     */
+    [[nodiscard]] std::optional<blob_id_type> add_packed_blob(std::string_view data, quota_level& exceeded);
+
+    /**
+     * @brief reads the BLOB packed in a segment file.
+     * @param bid the BLOB ID
+     * @return the BLOB data, or std::nullopt if the BLOB is not packed
+     */
+    [[nodiscard]] std::optional<std::string> read_packed(blob_id_type bid) const;
+
+    /**
+     * @brief returns the path of the BLOB, writing the BLOB in memory or in a segment file to its own file if needed.
+     * @details the size of the BLOB is moved from the budget of the memory tier to the session store,
+     *    and may exceed its quota temporarily, as the BLOB has been already accepted.
+     * @param bid the BLOB ID
+     * @return the path of the BLOB file, or std::nullopt if the BLOB is not in this session
+     * @throws std::system_error if the file cannot be written
+     */
+    [[nodiscard]] std::optional<blob_path_type> materialize(blob_id_type bid);
+
+    /**
+     * @brief returns the session storage usage of this session.
+     */
+    [[nodiscard]] std::size_t usage() const noexcept {
+        return usage_.load();
+    }
+
+    /**
+     * @brief opens a new read-only file descriptor of the BLOB in a memory file, added by adopt_blob_file() or add_memory_blob().
+     * @details the descriptor is opened under the lock, so that it refers to the memory file even if the BLOB is removed later.
+     * @param bid the BLOB ID
+     * @return the file descriptor owned by the caller, or std::nullopt if the BLOB is not backed by a descriptor
+     */
+    [[nodiscard]] std::optional<int> reopen_descriptor(blob_id_type bid) const;
+
 private:
+    // the size of a BLOB, which is added under the shared lock while the BLOB is being written
+    class blob_size {
+    public:
+        blob_size() = default;
+        blob_size(std::size_t size) noexcept : value_(size) {}  // NOLINT(google-explicit-constructor, hicpp-explicit-conversions)
+        blob_size(const blob_size& other) noexcept : value_(other.value_.load(std::memory_order_relaxed)) {}
+        blob_size& operator=(const blob_size& other) noexcept {
+            value_.store(other.value_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+        ~blob_size() = default;
+        // moved by copying, as the entries are moved in the table only under the exclusive lock
+        blob_size(blob_size&& other) noexcept : blob_size(static_cast<const blob_size&>(other)) {}
+        blob_size& operator=(blob_size&& other) noexcept {
+            return *this = static_cast<const blob_size&>(other);
+        }
+
+        blob_size& operator+=(std::size_t size) noexcept {
+            value_.fetch_add(size, std::memory_order_relaxed);
+            return *this;
+        }
+        operator std::size_t() const noexcept {  // NOLINT(google-explicit-constructor, hicpp-explicit-conversions)
+            return value_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<std::size_t> value_{};
+    };
+
+    // the path is not stored but derived from the BLOB ID unless the BLOB has been added from outside of the session store
+    struct blob_entry {
+        path_arena::handle_type external{};  // the interned path if added by add(), otherwise nullptr
+        blob_size size{};
+        int fd{-1};  // the owned descriptor if adopted, otherwise -1
+        blob_session_store::prefix_id_type prefix{};  // the prefix of the file name in the session store
+        blob_session_store::stripe_id_type stripe{};  // the directory of the session store where the file is placed
+        bool memory_tier{};  // whether the descriptor is a memory file of the memory tier, whose size is charged to its budget
+        bool packed{};  // whether the BLOB is packed in a segment file, keyed by the BLOB ID
+    };
+    using stripe_id_type = blob_session_store::stripe_id_type;
+
     session_id_type session_id_;
     blob_session_store& session_store_;
     std::optional<transaction_id_type> transaction_id_opt_;
     blob_session_manager& manager_;
 
     bool valid_{};
-    std::map<blob_id_type, std::pair<blob_path_type, std::size_t>> blobs_{};
-    mutable std::mutex mtx_{};
+    std::atomic_bool disposed_{};
+    blob_index<blob_entry> blobs_{};
+    mutable std::shared_mutex mtx_{};
+    std::atomic<std::size_t> usage_{};
+    std::shared_ptr<std::atomic<std::size_t>> transaction_usage_{};  // nullptr unless the usage per transaction is limited
 
     friend class blob_session;
     friend class blob_session_manager;
+
+    void check_not_disposed() const;
+    quota_level reserve_session_quota(std::size_t size);
+    void release_session_quota(std::size_t size);
+    quota_level reserve_quota(stripe_id_type stripe, std::size_t size, std::optional<std::chrono::system_clock::time_point> deadline = std::nullopt);
+    void release_quota(stripe_id_type stripe, std::size_t size);
+    void release_quota(const std::vector<std::size_t>& sizes, std::size_t memory_size);  // the sizes released from each stripe and the memory tier
+    void restore_quota(stripe_id_type stripe, std::size_t size);
+    blob_path_type path_of(blob_id_type bid, const blob_entry& entry) const;
+    blob_path_type materialize_packed(blob_id_type bid, blob_entry& entry);
+};
+
+/**
+ * @brief a handle pinning a session during an RPC
+ * @details the session is not destructed and its BLOB files are kept while any handle refers to it,
+ *    even if the session is disposed in the meantime.
+ */
+class blob_session_handle {
+public:
+    blob_session_handle() = default;
+
+    explicit blob_session_handle(std::shared_ptr<blob_session_impl> impl) noexcept : impl_(std::move(impl)) {}
+
+    blob_session_impl* operator->() const noexcept {
+        return impl_.get();
+    }
+
+    blob_session_impl& operator*() const noexcept {
+        return *impl_;
+    }
+
+    explicit operator bool() const noexcept {
+        return static_cast<bool>(impl_);
+    }
+
+private:
+    std::shared_ptr<blob_session_impl> impl_{};
 };
 
 } // namespace
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief an append-only index of the sessions and the BLOB files in the session store, to recover them after restart
+ * @details each change is appended as a fixed size record with a checksum, and thus the records torn by a crash are
+ *    ignored in the recovery. The index is compacted to the live records when it is opened, and in background
+ *    once the dead records, i.e. the records superseded by later ones, outnumber the live ones.
+ *    The records are written to the file without synchronization, and survive a crash of the process but not of the OS.
+ */
+class session_index {
+public:
+    using id_type = std::uint64_t;
+
+    /// @brief a BLOB file recovered
+    struct blob_state {
+        std::string prefix{};
+        std::size_t size{};
+        std::uint8_t stripe{};
+    };
+
+    /// @brief a session recovered
+    struct session_state {
+        std::optional<id_type> transaction_id_opt{};
+        std::map<id_type, blob_state> blobs{};
+    };
+
+    /// @brief the state recovered from the index
+    struct recovered_state {
+        std::map<id_type, session_state> sessions{};
+        id_type max_session_id{};
+        id_type max_blob_id{};  // the upper bound of the BLOB IDs which may have been assigned
+    };
+
+    /// @brief the default number of the dead records to compact the index in background
+    static constexpr std::size_t default_compaction_threshold = 65536;
+
+    /**
+     * @brief opens the index, recovering the state from the file if exists.
+     * @param path the path of the index file
+     * @param compaction_threshold the least number of the dead records to compact the index in background,
+     *    or 0 to compact it only when it is opened
+     * @throws std::system_error if the index file cannot be written
+     */
+    explicit session_index(std::filesystem::path path, std::size_t compaction_threshold = default_compaction_threshold);
+
+    ~session_index();
+
+    session_index(const session_index&) = delete;
+    session_index& operator=(const session_index&) = delete;
+    session_index(session_index&&) = delete;
+    session_index& operator=(session_index&&) = delete;
+
+    /**
+     * @brief returns the state recovered when this object was created.
+     */
+    [[nodiscard]] const recovered_state& recovered() const noexcept {
+        return recovered_;
+    }
+
+    void session_created(id_type session_id, std::optional<id_type> transaction_id_opt);
+
+    /**
+     * @brief records that the session has been disposed.
+     * @param blob_count the number of the BLOB files of the session, to estimate the records superseded by this
+     */
+    void session_disposed(id_type session_id, std::size_t blob_count = 0);
+
+    /**
+     * @brief records a BLOB file whose contents have been completely written in the session store.
+     * @param prefix the prefix of the file name, up to 24 bytes; otherwise the BLOB is not recorded
+     * @param stripe the directory of the session store where the file is placed
+     */
+    void blob_added(id_type blob_id, id_type session_id, std::size_t size, const std::string& prefix, std::uint8_t stripe = 0);
+
+    void blob_removed(id_type blob_id);
+
+    /**
+     * @brief records that the BLOB files have been removed, by one write.
+     */
+    void blobs_removed(const id_type* blob_ids, std::size_t count);
+
+    /**
+     * @brief records that the BLOB ID is going to be assigned, which must be done before creating the file.
+     * @details the BLOB IDs are reserved in blocks, so that no BLOB ID of the files left by a crash is assigned after restart.
+     *    The blocks grow as they are used up, and thus a record is appended for exponentially more BLOB IDs.
+     */
+    void assign_blob_id(id_type blob_id);
+
+    /**
+     * @brief returns the number of the records in the index file.
+     */
+    [[nodiscard]] std::size_t record_count() const noexcept {
+        return records_.load();
+    }
+
+    /**
+     * @brief waits for the compaction in background to finish if running.
+     */
+    void wait_compaction();
+
+private:
+    struct record;
+
+    std::filesystem::path path_;
+    int fd_{-1};
+    recovered_state recovered_{};
+    std::atomic<id_type> reserved_blob_id_{};
+    id_type reservation_{};  // the number of the BLOB IDs reserved by the next record
+    std::unordered_map<std::string, std::uint8_t> prefixes_{};
+    std::mutex mtx_{};
+
+    // compaction in background
+    std::size_t compaction_threshold_;
+    std::shared_mutex file_mtx_{};  // held exclusively only to replace the file with the compacted one
+    std::atomic<std::size_t> records_{};
+    std::atomic<std::size_t> dead_records_{};  // estimated
+    std::atomic_bool compacting_{};
+    std::thread compactor_{};
+    std::mutex compactor_mtx_{};
+
+    std::size_t replay(std::size_t limit, recovered_state& state, std::map<std::uint8_t, std::string>& prefixes) const;
+    void recover();
+    void compact();
+    void compact_live();
+    void maybe_compact();
+    std::vector<record> live_records(const recovered_state& state, id_type max_blob_id, const std::unordered_map<std::string, std::uint8_t>& prefixes) const;
+    int replace_file(const std::vector<record>& records, const std::vector<char>& tail) const;
+    void append(const record& rec);
+    void append(record* records, std::size_t count);
+    std::optional<std::uint8_t> prefix_id(const std::string& prefix);
+};
+
+} // namespace
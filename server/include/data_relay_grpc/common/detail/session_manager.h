@@ -16,19 +16,37 @@
 #pragma once
 
 #include <cstdint>
-#include <map>
 #include <optional>
 #include <filesystem>
 #include <atomic>
+#include <memory>
 #include <mutex>
 
 #include <data_relay_grpc/common/api.h>
 #include <data_relay_grpc/common/tag_generator.h>
 #include <data_relay_grpc/common/detail/session_store.h>
 #include <data_relay_grpc/common/detail/session_impl.h>
+#include <data_relay_grpc/common/detail/path_arena.h>
+#include <data_relay_grpc/common/detail/blob_reclaimer.h>
+#include <data_relay_grpc/common/detail/session_store_options.h>
+#include <data_relay_grpc/common/detail/sharded_map.h>
+#include <data_relay_grpc/common/detail/session_index.h>
+#include <data_relay_grpc/common/detail/tag_cache.h>
+#include <data_relay_grpc/common/detail/path_cache.h>
 
 namespace data_relay_grpc::common::detail {
 
+class blob_session_handle;
+
+/**
+ * @brief the number of sessions and their BLOBs at a point in time
+ */
+struct session_statistics {
+    std::size_t sessions{};
+    std::size_t blobs{};
+    std::size_t max_blobs_per_session{};
+};
+
 /**
  * @brief a class of manager for blob session
  */
@@ -36,18 +54,57 @@ class blob_session_manager {
 public:
     blob_session_manager(const api&, const std::string&, std::size_t, bool);
 
+    /**
+     * @brief creates the manager, restoring the sessions recorded in the session index if options.persistent_index is set.
+     * @details the files in the session store which are not recorded in the session index, such as the BLOB files being
+     *    uploaded at a crash, are deleted in the restoration. The key of the reference tags is persisted with the session
+     *    index, so that the tags issued before restart remain valid.
+     * @throws std::runtime_error if the session store is not available, or the key of the reference tags is broken
+     * @throws std::system_error if the session index or the key of the reference tags cannot be written
+     */
+    blob_session_manager(const api&, const std::string&, std::size_t, bool, const session_store_options&);
+
     blob_session& create_session(std::optional<blob_session::transaction_id_type>);
 
     void dispose(blob_session::session_id_type);
 
     blob_session& get_session(blob_session::session_id_type);
 
+    /**
+     * @brief returns the tag of the BLOB by api.get_tag, or the one cached for the transaction.
+     * @details the tags are cached only while a session of the transaction exists.
+     */
     blob_session::blob_tag_type get_tag(blob_session::blob_id_type, blob_session::transaction_id_type);
 
+    /**
+     * @brief fills tags[i] with the tag of blob_ids[i] in the transaction, calling api.get_tags at once for those not cached.
+     * @details api.get_tag is called for each BLOB instead if api.get_tags is not given.
+     */
+    void get_tags(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::transaction_id_type, blob_session::blob_tag_type* tags);
+
     blob_session::blob_path_type get_path(blob_session::blob_id_type);
 
+    /**
+     * @brief returns the path of the BLOB by api.get_path if the file exists, using the paths cached.
+     * @return the path, or std::nullopt if the file does not exist
+     */
+    std::optional<blob_session::blob_path_type> find_path(blob_session::blob_id_type);
+
+    /**
+     * @brief fills paths[i] with the path of blob_ids[i], calling api.get_paths at once for those not cached.
+     * @details api.get_path is called for each BLOB instead if api.get_paths is not given.
+     *    the paths retrieved are added to the path cache used by find_path().
+     */
+    void get_paths(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::blob_path_type* paths);
+
     blob_session_impl& get_session_impl(blob_session::session_id_type);
 
+    /**
+     * @brief returns a handle pinning the session, which should be held during an RPC.
+     * @throws std::out_of_range if the session does not exist or has been disposed
+     */
+    blob_session_handle pin_session(blob_session::session_id_type);
+
     blob_session::session_id_type get_session_id(blob_session::transaction_id_type);
 
     bool dev_accept_mock_tag() {
@@ -56,24 +113,111 @@ public:
     constexpr static blob_session::blob_tag_type MOCK_TAG = 0xffffffffffffffffLL;
 
     blob_session::blob_tag_type generate_reference_tag(blob_session::blob_id_type, blob_session::session_id_type);
+    void generate_reference_tags(const blob_session::blob_id_type*, std::size_t, blob_session::session_id_type, blob_session::blob_tag_type*);
 
     // for test only
     std::size_t session_store_current_size() const noexcept;
 
+    /**
+     * @brief returns the quota of the session store, or 0 if not limited.
+     */
+    std::size_t session_store_quota() const noexcept;
+
+    /**
+     * @brief counts the sessions and their BLOBs.
+     */
+    session_statistics statistics() const;
+
+    /**
+     * @brief returns the queue of the reservations waiting for the usage of a session store directory to be released.
+     * @param stripe_id the index of the directory, 0 for the primary one
+     */
+    const quota_admission& admission(std::size_t stripe_id = 0) const noexcept;
+
+    /**
+     * @brief returns the maximum size of a BLOB kept in the memory tier, or 0 if the memory tier is disabled.
+     */
+    std::size_t memory_tier_threshold() const noexcept;
+
+    /**
+     * @brief returns the memory used by the BLOBs in the memory tier.
+     */
+    std::size_t memory_tier_usage() const noexcept;
+
+    /**
+     * @brief returns the maximum size of a BLOB packed in the segment files, or 0 if the segment store is disabled.
+     */
+    std::size_t segment_threshold() const noexcept;
+
+    /**
+     * @brief returns the segment store, or nullptr if disabled.
+     */
+    const segment_store* segments() const noexcept;
+
+    /**
+     * @brief returns the number of the calls of get_tag served from the cache.
+     */
+    std::uint64_t tag_cache_hits() const;
+
+    /**
+     * @brief returns the number of the calls of get_tag which invoked api.get_tag.
+     */
+    std::uint64_t tag_cache_misses() const;
+
+    /**
+     * @brief returns the cache of the paths used by find_path.
+     */
+    const path_cache& paths() const noexcept {
+        return path_cache_;
+    }
+
+    /**
+     * @brief returns the number of BLOB files waiting for or under deletion in background.
+     */
+    std::size_t pending_deletions() const noexcept;
+
+    /**
+     * @brief waits until all BLOB files waiting for deletion are deleted.
+     */
+    void wait_deletions();
+
+    /**
+     * @brief returns the number of sessions restored from the session index at the start.
+     */
+    std::size_t restored_sessions() const noexcept {
+        return restored_sessions_;
+    }
+
 private:
     api api_;
     blob_session_store session_store_;
     bool dev_accept_mock_tag_;
-    tag_generator<blob_session::blob_id_type, blob_session::session_id_type, blob_session::blob_tag_type> tag_generator_{};
+    using tag_generator_type = tag_generator<blob_session::blob_id_type, blob_session::session_id_type, blob_session::blob_tag_type>;
+    tag_generator_type tag_generator_;
+    tag_cache tag_cache_;
+    path_cache path_cache_;
     std::atomic<blob_session::session_id_type> session_id_{};
     std::atomic<blob_session::blob_id_type> blob_id_{};
+    path_arena path_arena_{};
+    blob_reclaimer reclaimer_;
+    std::unique_ptr<session_index> index_{};  // nullptr unless the persistent index is enabled
+    std::size_t restored_sessions_{};
+    std::size_t session_quota_;
+    std::size_t transaction_quota_;
+    sharded_map<blob_session::transaction_id_type, std::shared_ptr<std::atomic<std::size_t>>> transaction_usages_{};
 
-    std::map<blob_session::session_id_type, blob_session> blob_sessions_{};
-    std::map<blob_session::transaction_id_type, blob_session::session_id_type> blob_session_ids_{};
-    mutable std::mutex mtx_{};
+    sharded_map<blob_session::session_id_type, blob_session> blob_sessions_{};
+    sharded_map<blob_session::transaction_id_type, blob_session::session_id_type> blob_session_ids_{};
 
     friend class blob_session_impl;
     blob_session::blob_id_type get_new_blob_id();
+    blob_session::blob_id_type get_new_blob_ids(std::size_t count);
+    void restore_sessions();
+    static tag_generator_type::key_type load_tag_key(const std::filesystem::path& path);
+    std::shared_ptr<blob_session_impl> make_session_impl(blob_session::session_id_type, std::optional<blob_session::transaction_id_type>);
+    void release_transaction_usage(blob_session::transaction_id_type);
+    // retrieves the tags by api.get_tags, or api.get_tag for each BLOB, bypassing the tag cache
+    void retrieve_tags(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::transaction_id_type, blob_session::blob_tag_type* tags);
 };
 
 } // namespace
@@ -15,8 +15,25 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <data_relay_grpc/common/detail/quota_accountant.h>
+#include <data_relay_grpc/common/detail/quota_admission.h>
+#include <data_relay_grpc/common/detail/segment_store.h>
+#include <data_relay_grpc/common/detail/session_store_options.h>
 
 namespace data_relay_grpc::common::detail {
 
@@ -25,67 +42,280 @@ namespace data_relay_grpc::common::detail {
  */
 class blob_session_store {
 public:
-    blob_session_store(const std::string& directory, std::size_t quota) : directory_(directory), quota_(quota) {
-        namespace fs = std::filesystem;
-    
-        if (!fs::exists(directory_)) {
-            throw std::runtime_error(directory_.string() + " does not exists");
-        }
-        fs::file_status status = fs::status(directory_);
-        if (status.type() != fs::file_type::directory &&
-            !(status.type() == fs::file_type::symlink && fs::symlink_status(directory).type() == fs::file_type::directory)) {
-            throw std::runtime_error(directory_.string() + " is not a directory");
-        }
-        fs::perms perm = status.permissions();
-        if ((perm & (fs::perms::owner_write | fs::perms::group_write | fs::perms::others_write)) == fs::perms::none) {
-            throw std::runtime_error(directory_.string() + " is not writable");
+    /**
+     * @brief creates the session store on the directory, purging the files left in it synchronously.
+     * @throws std::runtime_error if the directory is not available or the files cannot be purged
+     */
+    blob_session_store(const std::string& directory, std::size_t quota);
+
+    /**
+     * @brief creates the session store on the directory, purging the files left in it in background.
+     * @details the files left are moved aside to the trash directory `.trash` in the directory at once,
+     *    and are deleted by the cleanup threads while the session store is in use.
+     * @param cleanup_threads the number of threads deleting the files left, or 0 to delete them synchronously
+     * @throws std::runtime_error if the directory is not available or the files cannot be moved aside
+     */
+    blob_session_store(const std::string& directory, std::size_t quota, std::size_t cleanup_threads);
+
+    /**
+     * @brief creates the session store on the directory, keeping the files left in it if keep_files is true.
+     * @details the files are kept to be restored from the session index, and only the trash directories left are purged.
+     * @param keep_files whether the files left in the directory are kept
+     * @throws std::runtime_error if the directory is not available or the files cannot be moved aside
+     */
+    blob_session_store(const std::string& directory, std::size_t quota, std::size_t cleanup_threads, bool keep_files);
+
+    /**
+     * @brief creates the session store striped across the directories, e.g. on different devices.
+     * @details each BLOB file is placed in one of the directories by the placement policy, and each directory
+     *    has an equal share of the quota. The first directory is the primary one, where the session index is placed.
+     * @param directories the directories, up to 256
+     * @param placement the placement policy of the BLOB files
+     * @throws std::runtime_error if any of the directories is not available or the files cannot be moved aside
+     */
+    blob_session_store(const std::vector<std::filesystem::path>& directories, std::size_t quota, std::size_t cleanup_threads, bool keep_files, stripe_placement placement);
+
+    /**
+     * @brief stops the cleanup threads, and the files not deleted yet are purged at the next start.
+     */
+    ~blob_session_store();
+
+    blob_session_store(const blob_session_store&) = delete;
+    blob_session_store& operator=(const blob_session_store&) = delete;
+    blob_session_store(blob_session_store&&) = delete;
+    blob_session_store& operator=(blob_session_store&&) = delete;
+
+    /**
+     * @brief waits until the files left at the start are deleted.
+     */
+    void wait_cleanup();
+
+    // for test only
+    std::size_t current_size() const noexcept {
+        std::size_t rv{};
+        for (auto&& e : stripes_) {
+            rv += e.quota->used();
         }
+        return rv;
+    }
 
-        // remove existing files in the initialization
-        for (const fs::directory_entry& itr : fs::directory_iterator(directory)) {
-            std::error_code ec;
-            fs::remove(itr.path(), ec);
-            if (ec) {
-                throw std::runtime_error(itr.path().string() + "remains in the session store directory (" + directory_.string() + ")");
-            }
+    /**
+     * @brief returns the quota of the session store, or 0 if not limited.
+     */
+    std::size_t quota() const noexcept {
+        std::size_t rv{};
+        for (auto&& e : stripes_) {
+            rv += e.quota->quota();
         }
+        return rv;
     }
 
-    // for test only
-    std::size_t current_size() const noexcept {
-        return current_size_.load();
+    /**
+     * @brief returns the number of directories the session store is striped across.
+     */
+    std::size_t stripe_count() const noexcept {
+        return stripes_.size();
+    }
+
+    /**
+     * @brief sets the maximum time a reservation exceeding the quota waits for usage to be released.
+     * @param wait the maximum time, or 0 to fail such reservations immediately
+     */
+    void admission_wait(std::chrono::milliseconds wait) noexcept {
+        admission_wait_ = wait;
+    }
+
+    /**
+     * @brief returns the queue of the reservations waiting for usage of the directory to be released.
+     * @details each directory has its own queue, so that a reservation waiting for a full directory
+     *    does not hold up the reservations for the others.
+     * @param stripe_id the index of the directory, 0 for the primary one
+     */
+    const quota_admission& admission(std::size_t stripe_id = 0) const noexcept {
+        return *stripes_[stripe_id].admission;  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+
+    /**
+     * @brief places the BLOB files in the subdirectories of the directories, keyed by the BLOB ID.
+     * @details each level has 256 subdirectories named by a byte of the BLOB ID in hex, e.g. `3f/a0/upload_41023`
+     *    for two levels, so that no directory has too many entries. The subdirectories are created by this function.
+     *    The levels must not be changed while the session index keeps the BLOB files.
+     * @param levels the number of levels of the subdirectories, up to max_fanout_levels, or 0 for the flat layout
+     * @throws std::runtime_error if the levels is too large or the subdirectories cannot be created
+     */
+    void fanout(std::size_t levels);
+
+    /// @brief the maximum number of levels of the subdirectories
+    constexpr static std::size_t max_fanout_levels = 2;
+
+    /**
+     * @brief enables the memory tier, which keeps small BLOBs in memory files (memfd) instead of the directories.
+     * @details the memory tier has its own budget, and the BLOBs not fitting in it are placed in the directories.
+     * @param budget the memory available in bytes, or 0 to disable the memory tier
+     * @param threshold the maximum size of a BLOB kept in the memory tier in bytes
+     */
+    void memory_tier(std::size_t budget, std::size_t threshold) {
+        memory_tier_ = budget == 0 ? nullptr : std::make_unique<quota_accountant>(budget);
+        memory_tier_threshold_ = budget == 0 ? 0 : threshold;
+    }
+
+    /**
+     * @brief returns the maximum size of a BLOB kept in the memory tier, or 0 if the memory tier is disabled.
+     */
+    std::size_t memory_tier_threshold() const noexcept {
+        return memory_tier_threshold_;
+    }
+
+    /**
+     * @brief returns the memory used by the BLOBs in the memory tier.
+     */
+    std::size_t memory_tier_usage() const noexcept {
+        return memory_tier_ ? memory_tier_->used() : 0;
+    }
+
+    /**
+     * @brief enables the segment store, which packs tiny BLOBs into segment files in `.segments` of the primary directory.
+     * @details the BLOBs in the segment files are charged to the quota of the primary directory.
+     * @param segment_size the size of a segment file in bytes, or 0 to disable the segment store
+     * @param threshold the maximum size of a BLOB packed in bytes
+     * @throws std::runtime_error if the directory of the segment files cannot be created
+     */
+    void segments(std::size_t segment_size, std::size_t threshold) {
+        segments_ = segment_size == 0 ? nullptr : std::make_unique<segment_store>(directory_ / segment_directory_name, segment_size);
+        segment_threshold_ = segment_size == 0 ? 0 : std::min(threshold, segment_size);
+    }
+
+    /**
+     * @brief returns the maximum size of a BLOB packed in the segment files, or 0 if the segment store is disabled.
+     */
+    std::size_t segment_threshold() const noexcept {
+        return segment_threshold_;
+    }
+
+    /**
+     * @brief returns the segment store, or nullptr if disabled.
+     */
+    segment_store* segments() const noexcept {
+        return segments_.get();
     }
 
   private:
-    std::filesystem::path directory_;
-    std::size_t quota_;
-    
-    std::atomic<std::size_t> current_size_{};
+    // a directory of the session store with its share of the quota
+    struct stripe {
+        std::filesystem::path directory;
+        std::unique_ptr<quota_accountant> quota;
+        std::unique_ptr<quota_admission> admission;
+    };
+
+    std::filesystem::path directory_;  // the primary directory
+    std::vector<stripe> stripes_{};
+    stripe_placement placement_;
+    std::atomic<std::size_t> next_stripe_{};
+    std::chrono::milliseconds admission_wait_{};
+    std::unique_ptr<quota_accountant> memory_tier_{};
+    std::size_t memory_tier_threshold_{};
+    std::unique_ptr<segment_store> segments_{};
+    std::size_t segment_threshold_{};
+    constexpr static std::string_view segment_directory_name = ".segments";
+    std::size_t fanout_levels_{};
+
+    // cleanup of the files left at the start
+    std::vector<std::filesystem::path> trash_{};
+    std::size_t trash_index_{};
+    bool trash_opened_{};
+    std::filesystem::directory_iterator trash_itr_{};
+    std::mutex trash_mtx_{};
+    std::atomic_bool stop_cleanup_{};
+    std::atomic<std::size_t> active_cleanup_threads_{};
+    std::vector<std::thread> cleanup_threads_{};
+
+    static void check_directory(const std::filesystem::path& directory);
+    static void remove_entries(const std::filesystem::path& directory);
+    static void move_to_trash(const std::filesystem::path& directory);
+    void purge_trash();
+    std::optional<std::filesystem::path> next_trash_entry();
+
+    // the prefixes of the BLOB file names, append only so that they can be read without the lock
+    constexpr static std::size_t max_prefixes = 256;
+    std::array<std::string, max_prefixes> prefixes_{};
+    std::atomic<std::size_t> prefix_count_{};
+    std::mutex prefix_mtx_{};
 
     friend class blob_session_impl;
     friend class blob_session_manager;
-    std::filesystem::path create_blob_file(std::uint64_t new_blob_id, const std::string& prefix) {
-        std::filesystem::path file_path = directory_;
-        return directory_ / std::filesystem::path(prefix + "_" + std::to_string(new_blob_id));
-    }
-    bool reserve(std::size_t size) {
-        if (quota_ != 0) {
-            std::size_t current = current_size_.load();
-            while (true) {
-                if (current + size > quota_) {
-                    return false;
-                }
-                if (current_size_.compare_exchange_strong(current, current + size)) {
-                    return true;
-                }
+    using prefix_id_type = std::uint8_t;
+    using stripe_id_type = std::uint8_t;
+
+    // returns the ID of the prefix, which is used to derive the BLOB file path instead of storing it
+    prefix_id_type prefix_id(const std::string& prefix) {
+        auto count = prefix_count_.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < count; i++) {
+            if (prefixes_.at(i) == prefix) {
+                return static_cast<prefix_id_type>(i);
             }
         }
-        return true;
+        std::lock_guard<std::mutex> lock(prefix_mtx_);
+        count = prefix_count_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < count; i++) {
+            if (prefixes_.at(i) == prefix) {
+                return static_cast<prefix_id_type>(i);
+            }
+        }
+        if (count == max_prefixes) {
+            throw std::runtime_error("too many kinds of BLOB file prefixes");
+        }
+        prefixes_.at(count) = prefix;
+        prefix_count_.store(count + 1, std::memory_order_release);
+        return static_cast<prefix_id_type>(count);
+    }
+    // returns the stripe where the new BLOB file is placed
+    stripe_id_type place(std::uint64_t blob_id);
+    std::filesystem::path blob_file_path(std::uint64_t blob_id, prefix_id_type prefix_id, stripe_id_type stripe_id) const {
+        auto rv = stripes_[stripe_id].directory;  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        for (std::size_t i = 0; i < fanout_levels_; i++) {
+            rv /= bucket_name(blob_id >> (i * 8U));  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+        }
+        return rv / std::filesystem::path(prefixes_.at(prefix_id) + "_" + std::to_string(blob_id));
+    }
+    // the name of the subdirectory for the lowest byte of the key
+    static std::string bucket_name(std::uint64_t key) {
+        constexpr std::string_view digits = "0123456789abcdef";
+        return std::string{digits[(key >> 4U) & 0xfU], digits[key & 0xfU]};  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
     }
-    void remove(std::size_t size) {
-        if (quota_ != 0) {
-            current_size_.fetch_sub(size);
+    bool reserve(stripe_id_type stripe_id, std::size_t size) {
+        return stripes_[stripe_id].quota->reserve(size);  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+    // reserves the usage, waiting in the admission queue of the stripe until the deadline if enabled
+    bool reserve(stripe_id_type stripe_id, std::size_t size, std::chrono::system_clock::time_point deadline) {
+        auto& e = stripes_[stripe_id];  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        auto& quota = *e.quota;
+        if (admission_wait_.count() == 0) {
+            return quota.reserve(size);
+        }
+        // the reservations waiting for the stripe go first
+        if (e.admission->waiting() == 0 && quota.reserve(size)) {
+            return true;
         }
+        auto now = std::chrono::system_clock::now();
+        auto wait = deadline > now ? std::min<std::chrono::system_clock::duration>(deadline - now, admission_wait_) : std::chrono::system_clock::duration::zero();
+        return e.admission->wait([&quota, size]{ return quota.reserve(size); },
+            quota_admission::clock::now() + std::chrono::duration_cast<quota_admission::clock::duration>(wait));
+    }
+    void remove(stripe_id_type stripe_id, std::size_t size) {
+        auto& e = stripes_[stripe_id];  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        e.quota->release(size);
+        e.admission->notify();
+    }
+    // adds the size of a BLOB file restored at the start, which may exceed the quota if it has been lowered
+    void restore(stripe_id_type stripe_id, std::size_t size) {
+        stripes_[stripe_id].quota->restore(size);  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+    // reserves the memory for a BLOB kept in the memory tier, or returns false to place it in the directories
+    bool reserve_memory(std::size_t size) {
+        return memory_tier_ && size <= memory_tier_threshold_ && memory_tier_->reserve(size);
+    }
+    void release_memory(std::size_t size) {
+        memory_tier_->release(size);
     }
 };
 
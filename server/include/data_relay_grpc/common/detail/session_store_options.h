@@ -0,0 +1,96 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief the policy to place BLOB files in the directories of the session store
+ */
+enum class stripe_placement : std::uint8_t {
+    /// @brief the directories in turn.
+    round_robin = 0,
+
+    /// @brief the directory with the least usage, or with the most free space if the quota is not set.
+    least_used,
+
+    /// @brief the directory determined by the hash of the BLOB ID.
+    hash,
+};
+
+/**
+ * @brief optional settings of the session store
+ */
+struct session_store_options {
+    /// @brief the number of threads deleting BLOB files in background, or 0 to delete them synchronously.
+    std::size_t deletion_threads{0};
+
+    /// @brief the number of threads deleting the files left in the session store at the start, or 0 to delete them before starting.
+    std::size_t cleanup_threads{2};
+
+    /// @brief whether the sessions and their BLOB files are recorded in the session index with the key of the reference tags, and restored at the start.
+    bool persistent_index{false};
+
+    /// @brief the maximum storage usage of each session in bytes, or 0 not to limit.
+    std::size_t session_quota{0};
+
+    /// @brief the maximum storage usage of the sessions of each transaction in bytes, or 0 not to limit.
+    std::size_t transaction_quota{0};
+
+    /// @brief the maximum time a reservation exceeding the quota of the session store waits for usage to be released, or 0 not to wait.
+    std::chrono::milliseconds admission_wait{0};
+
+    /// @brief the additional directories of the session store to stripe the BLOB files across, each with an equal share of the quota.
+    std::vector<std::filesystem::path> stripe_directories{};
+
+    /// @brief the policy to place BLOB files in the directories.
+    stripe_placement placement{stripe_placement::round_robin};
+
+    /// @brief the number of levels of the subdirectories, each with 256 entries, where the BLOB files are placed, or 0 for the flat layout.
+    std::size_t fanout_levels{0};
+
+    /// @brief the size of a segment file packing tiny BLOBs in bytes, or 0 to place each BLOB in its own file.
+    std::size_t segment_size{0};
+
+    /// @brief the maximum size of a BLOB packed in the segment files in bytes.
+    std::size_t segment_threshold{4UL * 1024UL};
+
+    /// @brief the memory available to keep small BLOBs uploaded in memory instead of files in bytes, or 0 to disable the memory tier.
+    std::size_t memory_tier_budget{0};
+
+    /// @brief the maximum size of a BLOB kept in the memory tier in bytes.
+    std::size_t memory_tier_threshold{64UL * 1024UL};
+
+    /// @brief the maximum number of the tags returned by api.get_tag cached until the session is disposed, or 0 to disable the cache.
+    std::size_t tag_cache_size{0};
+
+    /// @brief the maximum number of the paths returned by api.get_path cached with whether the file exists, or 0 to disable the cache.
+    std::size_t path_cache_size{0};
+
+    /// @brief the time the path of an existing file is cached.
+    std::chrono::milliseconds path_cache_ttl{10000};
+
+    /// @brief the time the path of a file not found is cached.
+    std::chrono::milliseconds path_cache_negative_ttl{500};
+};
+
+} // namespace
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief a hash map keyed by integer IDs, split into shards each guarded by its own reader-writer lock
+ * @details references to the values remain valid until the entries are erased.
+ * @tparam Key the integer key type
+ * @tparam Value the value type
+ * @tparam Shards the number of shards, must be a power of two
+ */
+template <class Key, class Value, std::size_t Shards = 64>
+class sharded_map {
+    static_assert((Shards & (Shards - 1)) == 0, "the number of shards must be a power of two");
+
+public:
+    /**
+     * @brief inserts the value if the key does not exist.
+     * @return the reference to the value in the map and whether the value has been inserted
+     */
+    template <class... Args>
+    std::pair<Value&, bool> try_emplace(const Key& key, Args&&... args) {
+        auto& s = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(s.mtx);
+        auto [itr, inserted] = s.map.try_emplace(key, std::forward<Args>(args)...);
+        return { itr->second, inserted };
+    }
+
+    /**
+     * @brief returns a copy of the value of the key, inserting the value if the key does not exist.
+     * @details the copy is made under the lock, e.g. to share a std::shared_ptr which may be erased concurrently.
+     */
+    template <class... Args>
+    Value find_or_emplace(const Key& key, Args&&... args) {
+        auto& s = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(s.mtx);
+        return s.map.try_emplace(key, std::forward<Args>(args)...).first->second;
+    }
+
+    /**
+     * @brief calls the function with the value of the key under the shared lock.
+     * @return true if the key exists
+     */
+    template <class F>
+    bool find(const Key& key, F&& f) {
+        auto& s = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(s.mtx);
+        if (auto itr = s.map.find(key); itr != s.map.end()) {
+            std::forward<F>(f)(itr->second);
+            return true;
+        }
+        return false;
+    }
+
+    template <class F>
+    bool find(const Key& key, F&& f) const {
+        auto& s = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(s.mtx);
+        if (auto itr = s.map.find(key); itr != s.map.end()) {
+            std::forward<F>(f)(std::as_const(itr->second));
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief removes the entry of the key and returns its value, which is destructed outside the lock.
+     */
+    std::optional<Value> extract(const Key& key) {
+        auto& s = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(s.mtx);
+        if (auto node = s.map.extract(key); node) {
+            return std::optional<Value>{std::move(node.mapped())};
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief removes the entry of the key if its value satisfies the predicate.
+     * @return true if the entry has been removed
+     */
+    template <class Pred>
+    bool erase_if(const Key& key, Pred&& pred) {
+        auto& s = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(s.mtx);
+        if (auto itr = s.map.find(key); itr != s.map.end() && std::forward<Pred>(pred)(itr->second)) {
+            s.map.erase(itr);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief calls the function with each key and value under the shared lock of its shard.
+     */
+    template <class F>
+    void for_each(F&& f) const {
+        for (auto&& s : shards_) {
+            std::shared_lock<std::shared_mutex> lock(s.mtx);
+            for (auto&& [key, value] : s.map) {
+                f(key, value);
+            }
+        }
+    }
+
+    /**
+     * @brief returns the number of entries, which may be outdated under concurrent updates.
+     */
+    [[nodiscard]] std::size_t size() const {
+        std::size_t rv{};
+        for (auto&& s : shards_) {
+            std::shared_lock<std::shared_mutex> lock(s.mtx);
+            rv += s.map.size();
+        }
+        return rv;
+    }
+
+private:
+    struct alignas(64) shard {  // NOLINT(cppcoreguidelines-avoid-magic-numbers): cache line size
+        mutable std::shared_mutex mtx{};
+        std::unordered_map<Key, Value> map{};
+    };
+    std::array<shard, Shards> shards_{};
+
+    shard& shard_for(const Key& key) noexcept {
+        return shards_[index(key)];  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+    const shard& shard_for(const Key& key) const noexcept {
+        return shards_[index(key)];  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+    static std::size_t index(const Key& key) noexcept {
+        // Fibonacci hashing, as the IDs are mostly sequential
+        constexpr std::uint64_t multiplier = 0x9e3779b97f4a7c15ULL;
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(key) * multiplier) >> 32U) & (Shards - 1);  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+    }
+};
+
+} // namespace
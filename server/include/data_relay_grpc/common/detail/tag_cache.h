@@ -0,0 +1,111 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief a bounded cache of the tags returned by api.get_tag, keyed by the BLOB ID and the transaction ID
+ * @details the tags are cached only for the transactions opened, and are dropped when the transaction is closed as
+ *    many times as opened, so that no tag outlives the last session of the transaction. The cache is split into shards by the transaction ID,
+ *    and the tags of the transaction least recently opened in the shard are evicted when the shard is full.
+ */
+class tag_cache {
+public:
+    using blob_id_type = std::uint64_t;
+    using transaction_id_type = std::uint64_t;
+    using tag_type = std::uint64_t;
+
+    static constexpr std::size_t shard_count = 16;
+
+    /**
+     * @brief creates the cache.
+     * @param capacity the maximum number of the tags cached, or 0 to disable the cache
+     */
+    explicit tag_cache(std::size_t capacity);
+
+    /**
+     * @brief returns whether the cache is enabled.
+     */
+    [[nodiscard]] bool enabled() const noexcept {
+        return capacity_ > 0;
+    }
+
+    /**
+     * @brief starts caching the tags of the transaction, or counts another session of the transaction opened.
+     */
+    void open(transaction_id_type transaction_id);
+
+    /**
+     * @brief counts a session of the transaction closed, and drops the tags and stops caching them when the last one is closed.
+     */
+    void close(transaction_id_type transaction_id);
+
+    /**
+     * @brief returns the tag cached, counting a hit or a miss.
+     */
+    [[nodiscard]] std::optional<tag_type> find(blob_id_type blob_id, transaction_id_type transaction_id);
+
+    /**
+     * @brief caches the tag if the transaction is opened.
+     */
+    void insert(blob_id_type blob_id, transaction_id_type transaction_id, tag_type tag);
+
+    /**
+     * @brief returns the number of lookups which found the tag.
+     */
+    [[nodiscard]] std::uint64_t hits() const;
+
+    /**
+     * @brief returns the number of lookups which did not find the tag.
+     */
+    [[nodiscard]] std::uint64_t misses() const;
+
+    /**
+     * @brief returns the number of the tags cached.
+     */
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    struct transaction_entry {
+        std::uint64_t opened{};  // the order of open(), to find the transaction to evict
+        std::size_t sessions{};  // the number of open() not closed
+        std::unordered_map<blob_id_type, tag_type> tags{};
+    };
+    struct alignas(64) shard {  // NOLINT(cppcoreguidelines-avoid-magic-numbers): cache line size
+        mutable std::mutex mtx{};
+        std::unordered_map<transaction_id_type, transaction_entry> transactions{};
+        std::size_t size{};
+        std::uint64_t opened{};
+        std::uint64_t hits{};
+        std::uint64_t misses{};
+    };
+
+    std::size_t capacity_;
+    std::size_t shard_capacity_;
+    std::array<shard, shard_count> shards_{};
+
+    shard& shard_for(transaction_id_type transaction_id) noexcept;
+    static void evict(shard& s, transaction_id_type keep);
+};
+
+} // namespace
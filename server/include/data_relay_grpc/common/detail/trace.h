@@ -0,0 +1,42 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+/**
+ * @file trace.h
+ * @brief the macros to instrument the hot paths for Tracy, which expand to nothing unless TRACY_ENABLE is defined.
+ * @details trace_scope_name() opens a zone until the end of the enclosing scope, and at most one zone can be opened
+ *    in a scope. trace_scope_value() attaches a value, such as the size of the data, to the zone opened last.
+ *    trace_event() records a message at the point, e.g. a quota exceeded, whose text must be a string literal.
+ */
+
+#ifdef TRACY_ENABLE
+
+#include <cstdint>
+
+#include <tracy/Tracy.hpp>
+
+#define trace_scope_name(name) ZoneScopedN(name)  // NOLINT(cppcoreguidelines-macro-usage)
+#define trace_scope_value(value) ZoneValue(static_cast<std::uint64_t>(value))  // NOLINT(cppcoreguidelines-macro-usage)
+#define trace_event(text) TracyMessageL(text)  // NOLINT(cppcoreguidelines-macro-usage)
+
+#else
+
+#define trace_scope_name(name)  // NOLINT(cppcoreguidelines-macro-usage)
+#define trace_scope_value(value)  // NOLINT(cppcoreguidelines-macro-usage)
+#define trace_event(text)  // NOLINT(cppcoreguidelines-macro-usage)
+
+#endif
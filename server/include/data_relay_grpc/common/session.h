@@ -17,8 +17,11 @@
 
 #include <memory>
 #include <cstdint>
+#include <iterator>
 #include <optional>
 #include <filesystem>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace data_relay_grpc::common::detail {
@@ -72,6 +75,36 @@ public:
      */
     [[nodiscard]] blob_id_type add(blob_path_type path);
 
+    /**
+     * @brief adds BLOB data file paths to this session at once.
+     * @details the BLOB IDs are assigned as a block, and the paths are added taking the lock of this session only once.
+     *    If any of the paths does not exist, none of them is added.
+     * @param paths_begin the beginning of the range of paths to add.
+     * @param paths_end the end of the range of paths to add.
+     * @return the BLOB IDs assigned to the added BLOB data files, in the order of the paths.
+     * @throws std::runtime_error if any of the paths does not exist.
+     * @attention undefined behavior occurs if a path is already added in this session.
+     */
+    template<class Iter>
+    [[nodiscard]] std::vector<blob_id_type> add(Iter paths_begin, Iter paths_end) {
+        if constexpr (std::is_same_v<Iter, blob_path_type*> || std::is_same_v<Iter, const blob_path_type*>) {
+            return add(paths_begin, static_cast<std::size_t>(paths_end - paths_begin));
+        } else if constexpr (std::is_same_v<Iter, std::vector<blob_path_type>::iterator> || std::is_same_v<Iter, std::vector<blob_path_type>::const_iterator>) {
+            return add(paths_begin == paths_end ? nullptr : &*paths_begin, static_cast<std::size_t>(paths_end - paths_begin));
+        } else {
+            std::vector<blob_path_type> paths(paths_begin, paths_end);
+            return add(paths.data(), paths.size());
+        }
+    }
+
+    /**
+     * @brief adds BLOB data file paths in the given array to this session at once.
+     * @param paths the pointer to the first path.
+     * @param count the number of paths.
+     * @see add(Iter, Iter)
+     */
+    [[nodiscard]] std::vector<blob_id_type> add(const blob_path_type* paths, std::size_t count);
+
     /**
      * @brief find the BLOB data file path associated with the given BLOB ID.
      * @param blob_id the BLOB ID to retrieve
@@ -89,11 +122,47 @@ public:
     /**
      * @brief removes the BLOB data file associated with the given BLOB IDs from this session.
      * @details if there is no BLOB data file associated with the given BLOB ID, this method does nothing.
+     *    The BLOB data files are removed at once, taking the lock of this session only once.
      * @param blob_ids_begin the beginning of the range of BLOB IDs to remove.
      * @param blob_ids_end the end of the range of BLOB IDs to remove.
+     * @throws std::runtime_error if blob_ids_begin is greater than blob_ids_end for random access iterators.
      */
     template<class Iter>
-    void remove(Iter blob_ids_begin, Iter blob_ids_end);
+    void remove(Iter blob_ids_begin, Iter blob_ids_end) {
+        using category = typename std::iterator_traits<Iter>::iterator_category;
+        if constexpr (std::is_base_of_v<std::random_access_iterator_tag, category>) {
+            if (blob_ids_end < blob_ids_begin) {
+                throw std::runtime_error("iterator begin is greather than iterator end");
+            }
+        }
+        if constexpr (std::is_same_v<Iter, blob_id_type*> || std::is_same_v<Iter, const blob_id_type*>) {
+            remove(blob_ids_begin, static_cast<std::size_t>(blob_ids_end - blob_ids_begin));
+        } else if constexpr (std::is_same_v<Iter, std::vector<blob_id_type>::iterator> || std::is_same_v<Iter, std::vector<blob_id_type>::const_iterator>) {
+            // contiguous, and thus passed without copying
+            remove(blob_ids_begin == blob_ids_end ? nullptr : &*blob_ids_begin, static_cast<std::size_t>(blob_ids_end - blob_ids_begin));
+        } else {
+            std::vector<blob_id_type> blob_ids(blob_ids_begin, blob_ids_end);
+            remove(blob_ids.data(), blob_ids.size());
+        }
+    }
+
+    /**
+     * @brief removes the BLOB data file associated with the BLOB IDs in the given range from this session.
+     * @param blob_ids the range of BLOB IDs to remove, such as a container.
+     * @see remove(Iter, Iter)
+     */
+    template<class Range>
+    void remove(const Range& blob_ids) {
+        remove(std::begin(blob_ids), std::end(blob_ids));
+    }
+
+    /**
+     * @brief removes the BLOB data file associated with the BLOB IDs in the given array from this session.
+     * @param blob_ids the pointer to the first BLOB ID.
+     * @param count the number of BLOB IDs.
+     * @see remove(Iter, Iter)
+     */
+    void remove(const blob_id_type* blob_ids, std::size_t count);
 
     /**
       * @brief computes a tag value for the given BLOB ID.
@@ -102,11 +171,30 @@ public:
       */
     [[nodiscard]] blob_tag_type compute_tag(blob_id_type blob_id) const;
 
+    /**
+      * @brief computes the tag values for the BLOB IDs in the given array at once.
+      * @param blob_ids the pointer to the first BLOB ID.
+      * @param count the number of BLOB IDs.
+      * @param tags the pointer to the array receiving the tag values, where tags[i] is for blob_ids[i].
+      * @see compute_tag(blob_id_type)
+      */
+    void compute_tags(const blob_id_type* blob_ids, std::size_t count, blob_tag_type* tags) const;
+
+    /**
+      * @brief retrieves the tag values of the BLOB IDs in the given array from the datastore at once.
+      * @details the tags not cached are retrieved by one call of api.get_tags, or api.get_tag for each BLOB if
+      *    api.get_tags is not given, for the transaction of this session, or this session if it has no transaction.
+      * @param blob_ids the pointer to the first BLOB ID.
+      * @param count the number of BLOB IDs.
+      * @param tags the pointer to the array receiving the tag values, where tags[i] is for blob_ids[i].
+      */
+    void get_tags(const blob_id_type* blob_ids, std::size_t count, blob_tag_type* tags) const;
+
 private:
-    std::unique_ptr<blob_session_impl> impl_;
+    std::shared_ptr<blob_session_impl> impl_;
 
     friend class blob_session_manager;
-    blob_session(std::unique_ptr<blob_session_impl> impl);
+    blob_session(std::shared_ptr<blob_session_impl> impl);
 };
 
 } // namespace
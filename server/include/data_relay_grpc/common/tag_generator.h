@@ -16,54 +16,241 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <cstring>
 #include <stdexcept>
 
+#include <openssl/opensslv.h>
 #include <openssl/hmac.h>
 #include <openssl/rand.h>
 #include <openssl/evp.h>
 #include <openssl/err.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
 
 namespace data_relay_grpc::common {
 
+/**
+ * @brief generates the reference tags of BLOBs by HMAC-SHA256 with a random or given key.
+ * @details the HMAC context keyed once at construction is duplicated for each thread,
+ *    and is reinitialized for each tag from the inner/outer states kept in it,
+ *    so that neither the key schedule nor the digest lookup is repeated for each tag.
+ */
 template <typename T1, typename T2, typename T3>
 class tag_generator {
   public:
-    tag_generator() {
+    using key_type = std::array<std::uint8_t, 16>;
+
+    /**
+     * @brief creates the generator with a random key.
+     * @throws std::runtime_error if the key cannot be generated
+     */
+    tag_generator() : tag_generator(random_key()) {
+    }
+
+    /**
+     * @brief creates the generator with the key, e.g. the one persisted to verify the tags issued before restart.
+     * @throws std::runtime_error if the HMAC context cannot be initialized
+     */
+    explicit tag_generator(const key_type& key) : hmac_secret_key_(key) {
+        ERR_clear_error();
+        if (!init_template_context()) {
+            auto msg = hmac_error_message();
+            free_template_context();
+            throw std::runtime_error(msg);
+        }
+    }
+    ~tag_generator() {
+        free_template_context();
+    }
+
+    /**
+     * @brief generates a random key.
+     * @throws std::runtime_error if the random bytes cannot be generated
+     */
+    static key_type random_key() {
         // The generated key is 128 bits (16 bytes). Although HMAC-SHA256 can use
         // longer keys (and RFC 2104 recommends keys at least as long as the hash
         // output), we keep the 16-byte key length for compatibility with existing
         // systems that assume this size.
-        if (RAND_bytes(hmac_secret_key_.data(), static_cast<int>(hmac_secret_key_.size())) != 1) {
+        key_type rv{};
+        if (RAND_bytes(rv.data(), static_cast<int>(rv.size())) != 1) {
             throw std::runtime_error("Failed to generate random bytes for HMAC secret key for BLOB reference tag generation");
         }
+        return rv;
     }
+
+    tag_generator(const tag_generator&) = delete;
+    tag_generator& operator=(const tag_generator&) = delete;
+    tag_generator(tag_generator&&) = delete;
+    tag_generator& operator=(tag_generator&&) = delete;
+
     T3 generate_reference_tag(
         T1 p1,
         T2 p2) {
+        return compute(local_context(), p1, p2);
+    }
+
+    /**
+     * @brief generates the reference tags of the BLOBs in one call.
+     * @param p1 the array of the first parameters, such as BLOB ids
+     * @param count the number of elements in p1 and tags
+     * @param p2 the second parameter shared by all tags, such as a session id
+     * @param tags the array receiving the tags, where tags[i] is the tag of p1[i]
+     */
+    void generate_reference_tags(
+        const T1* p1,
+        std::size_t count,
+        T2 p2,
+        T3* tags) {
+        if (count == 0) {
+            return;
+        }
+        auto* ctx = local_context();
+        for (std::size_t i = 0; i < count; i++) {
+            tags[i] = compute(ctx, p1[i], p2);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+    }
+
+  private:
+    // HMAC secret key for BLOB reference tag generation (128-bit, 16 bytes).
+    // Note:
+    //   - HMAC-SHA256 accepts keys of any length, but RFC 2104 recommends
+    //     using a key at least as long as the hash output (256 bits).
+    //   - This implementation intentionally uses a 128-bit random key because
+    //     the key size is constrained by existing deployments (e.g. stored
+    //     configuration / wire format) and changing it would invalidate
+    //     previously generated BLOB reference tags.
+    //   - A 128-bit uniformly random secret key still provides strong security
+    //     for this use case, and the choice is documented here for clarity.
+    key_type hmac_secret_key_{};
+
+    // the HMAC context keyed with hmac_secret_key_, from which the context of each thread is duplicated
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    using context_type = EVP_MAC_CTX;
+    EVP_MAC* mac_{};
+#else
+    using context_type = HMAC_CTX;
+#endif
+    context_type* template_context_{};
+
+    // distinguishes the instances, since the context of a thread is keyed for one of them
+    std::uint64_t id_{next_id()};
 
+    static std::uint64_t next_id() {
+        static std::atomic<std::uint64_t> id{};
+        return ++id;
+    }
+
+    /**
+     * @brief the HMAC context of a thread, duplicated from the template context of the owner
+     */
+    struct thread_context {
+        std::uint64_t owner{};
+        context_type* ctx{};
+
+        thread_context() = default;
+        ~thread_context() {
+            free_context(ctx);
+        }
+        thread_context(const thread_context&) = delete;
+        thread_context& operator=(const thread_context&) = delete;
+        thread_context(thread_context&&) = delete;
+        thread_context& operator=(thread_context&&) = delete;
+    };
+
+    static void free_context(context_type* ctx) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        EVP_MAC_CTX_free(ctx);
+#else
+        HMAC_CTX_free(ctx);
+#endif
+    }
+
+    bool init_template_context() {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        mac_ = EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+        if (mac_ == nullptr) {
+            return false;
+        }
+        template_context_ = EVP_MAC_CTX_new(mac_);
+        if (template_context_ == nullptr) {
+            return false;
+        }
+        std::array<char, 7> digest{"SHA256"};
+        std::array<OSSL_PARAM, 2> params{
+            OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest.data(), 0),
+            OSSL_PARAM_construct_end()
+        };
+        return EVP_MAC_init(template_context_, hmac_secret_key_.data(), hmac_secret_key_.size(), params.data()) == 1;
+#else
+        template_context_ = HMAC_CTX_new();
+        if (template_context_ == nullptr) {
+            return false;
+        }
+        return HMAC_Init_ex(template_context_, hmac_secret_key_.data(), static_cast<int>(hmac_secret_key_.size()), EVP_sha256(), nullptr) == 1;
+#endif
+    }
+
+    void free_template_context() {
+        free_context(template_context_);
+        template_context_ = nullptr;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        EVP_MAC_free(mac_);
+        mac_ = nullptr;
+#endif
+    }
+
+    // returns the context of the current thread keyed for this instance, duplicating it if not yet
+    context_type* local_context() {
+        thread_local thread_context local{};
+        if (local.owner == id_ && local.ctx != nullptr) {
+            return local.ctx;
+        }
+        ERR_clear_error();
+        free_context(local.ctx);
+        local.owner = 0;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        local.ctx = EVP_MAC_CTX_dup(template_context_);
+#else
+        local.ctx = HMAC_CTX_new();
+        if (local.ctx != nullptr && HMAC_CTX_copy(local.ctx, template_context_) != 1) {
+            HMAC_CTX_free(local.ctx);
+            local.ctx = nullptr;
+        }
+#endif
+        if (local.ctx == nullptr) {
+            throw std::runtime_error(hmac_error_message());
+        }
+        local.owner = id_;
+        return local.ctx;
+    }
+
+    T3 compute(context_type* ctx, T1 p1, T2 p2) {
         // Prepare input data: concatenate p1 and p2 using portable approach
         std::array<unsigned char, sizeof(T1) + sizeof(T2)> input_bytes{};
         std::memcpy(input_bytes.data(), &p1, sizeof(T1));
         std::memcpy(input_bytes.data() + sizeof(T1), &p2, sizeof(T2));
 
-        // Clear OpenSSL error queue to avoid noise from previous API calls
-        ERR_clear_error();
-
-        // Calculate HMAC-SHA256
+        // Calculate HMAC-SHA256, restarting from the keyed state
         std::array<unsigned char, EVP_MAX_MD_SIZE> md{};
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        std::size_t md_len = 0;
+        bool success = EVP_MAC_init(ctx, nullptr, 0, nullptr) == 1 &&
+            EVP_MAC_update(ctx, input_bytes.data(), input_bytes.size()) == 1 &&
+            EVP_MAC_final(ctx, md.data(), &md_len, md.size()) == 1;
+#else
         unsigned int md_len = 0;
-
-        unsigned char* result = HMAC(EVP_sha256(),
-                                     hmac_secret_key_.data(),
-                                     static_cast<int>(hmac_secret_key_.size()),
-                                     input_bytes.data(),
-                                     input_bytes.size(),
-                                     md.data(),
-                                     &md_len);
-
-        if (result == nullptr) {
+        bool success = HMAC_Init_ex(ctx, nullptr, 0, nullptr, nullptr) == 1 &&
+            HMAC_Update(ctx, input_bytes.data(), input_bytes.size()) == 1 &&
+            HMAC_Final(ctx, md.data(), &md_len) == 1;
+#endif
+        if (!success || md_len < sizeof(T3)) {
             throw std::runtime_error(hmac_error_message());
         }
 
@@ -74,19 +261,6 @@ class tag_generator {
         return tag;
     }
 
-  private:
-    // HMAC secret key for BLOB reference tag generation (128-bit, 16 bytes).
-    // Note:
-    //   - HMAC-SHA256 accepts keys of any length, but RFC 2104 recommends
-    //     using a key at least as long as the hash output (256 bits).
-    //   - This implementation intentionally uses a 128-bit random key because
-    //     the key size is constrained by existing deployments (e.g. stored
-    //     configuration / wire format) and changing it would invalidate
-    //     previously generated BLOB reference tags.
-    //   - A 128-bit uniformly random secret key still provides strong security
-    //     for this use case, and the choice is documented here for clarity.
-    std::array<std::uint8_t, 16> hmac_secret_key_{};
-
     std::string hmac_error_message() {
         // Retrieve all OpenSSL error codes and error strings
         std::string msg = "Failed to calculate reference tag: ";
@@ -0,0 +1,321 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <openssl/rand.h>
+
+#include <glog/logging.h>
+#include "data_relay_grpc/logging_helper.h"
+#include "data_relay_grpc/logging.h"
+
+#include "descriptor_relay.h"
+
+namespace data_relay_grpc::blob_relay {
+
+namespace {
+
+constexpr std::size_t request_size = 1 + sizeof(descriptor_relay::token_type);
+constexpr int io_timeout_ms = 1000;
+
+// receives a fixed size message, with a descriptor if the peer attached one
+bool receive(int conn, std::array<char, request_size>& buf, file_descriptor& received) {
+    std::size_t done = 0;
+    while (done < buf.size()) {
+        iovec iov{buf.data() + done, buf.size() - done};  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control{};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+        ssize_t n = ::recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) {
+                int fd{};
+                std::memcpy(&fd, CMSG_DATA(c), sizeof(fd));
+                received.reset(fd);
+            }
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// sends a message, with the descriptor attached if fd is not negative
+bool send(int conn, const void* data, std::size_t size, int fd) {
+    iovec iov{const_cast<void*>(data), size};  // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control{};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (fd >= 0) {
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+        cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(c), &fd, sizeof(fd));
+    }
+    while (true) {
+        ssize_t n = ::sendmsg(conn, &msg, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return n == static_cast<ssize_t>(size);
+    }
+}
+
+// whether the peer runs as the same user as the server
+bool same_user(int conn) {
+    ucred cred{};
+    socklen_t len = sizeof(cred);
+    if (::getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) {
+        return false;
+    }
+    return cred.uid == ::geteuid();
+}
+
+} // namespace
+
+descriptor_relay::descriptor_relay(std::filesystem::path socket_path, clock::duration ttl, std::size_t workers)
+    : socket_path_(std::move(socket_path)), ttl_(ttl) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path_.native().size() >= sizeof(addr.sun_path)) {
+        throw std::system_error(ENAMETOOLONG, std::generic_category(), socket_path_.string());
+    }
+    std::memcpy(addr.sun_path, socket_path_.c_str(), socket_path_.native().size());  // NOLINT
+
+    listen_fd_.reset(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (!listen_fd_) {
+        throw std::system_error(errno, std::generic_category(), "cannot create a socket for " + socket_path_.string());
+    }
+    std::error_code ec{};
+    if (std::filesystem::is_socket(socket_path_, ec)) {
+        std::filesystem::remove(socket_path_, ec);
+    }
+    // no connection is accepted before the socket file is made accessible only by the owner
+    if (::bind(listen_fd_.get(), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||  // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        ::chmod(socket_path_.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+        ::listen(listen_fd_.get(), SOMAXCONN) != 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot listen on " + socket_path_.string());
+    }
+    wakeup_fd_.reset(::eventfd(0, EFD_CLOEXEC));
+    if (!wakeup_fd_) {
+        throw std::system_error(errno, std::generic_category(), "cannot create an eventfd");
+    }
+    workers = std::max(workers, std::size_t{1});
+    workers_.reserve(workers);
+    for (std::size_t i = 0; i < workers; i++) {
+        workers_.emplace_back([this]{ serve(); });
+    }
+    thread_ = std::thread([this]{ run(); });
+    VLOG_LP(log_info) << "descriptor relay listens on " << socket_path_.string();
+}
+
+descriptor_relay::~descriptor_relay() {
+    std::uint64_t one = 1;
+    if (::write(wakeup_fd_.get(), &one, sizeof(one)) < 0) {
+        LOG_LP(ERROR) << "cannot wake up the descriptor relay thread: " << std::strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(connections_mtx_);
+        stopping_ = true;
+    }
+    connections_cv_.notify_all();
+    for (auto&& e : workers_) {
+        if (e.joinable()) {
+            e.join();
+        }
+    }
+    std::error_code ec{};
+    std::filesystem::remove(socket_path_, ec);
+}
+
+descriptor_relay::token_type descriptor_relay::offer(file_descriptor fd) {
+    return store(std::move(fd), true);
+}
+
+file_descriptor descriptor_relay::take(token_type token) {
+    if (auto e = remove(token, false); e) {
+        return std::move(e->fd);
+    }
+    return {};
+}
+
+descriptor_relay::token_type descriptor_relay::store(file_descriptor fd, bool offered) {
+    auto now = clock::now();
+    std::lock_guard<std::mutex> lock(mtx_);
+    purge_expired(now);
+    while (true) {
+        token_type token{};
+        if (RAND_bytes(reinterpret_cast<unsigned char*>(&token), sizeof(token)) != 1) {  // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            throw std::runtime_error("failed to generate a descriptor token");
+        }
+        if (token != 0 && entries_.find(token) == entries_.end()) {
+            entries_.emplace(token, entry{std::move(fd), now + ttl_, offered});
+            return token;
+        }
+    }
+}
+
+std::optional<descriptor_relay::entry> descriptor_relay::remove(token_type token, bool offered) {
+    auto now = clock::now();
+    std::lock_guard<std::mutex> lock(mtx_);
+    purge_expired(now);
+    if (auto itr = entries_.find(token); itr != entries_.end() && itr->second.offered == offered) {
+        auto e = std::move(itr->second);
+        entries_.erase(itr);
+        return e;
+    }
+    return std::nullopt;
+}
+
+// puts back the entry removed, which is purged later if it has expired
+void descriptor_relay::restore(token_type token, entry e) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    entries_.emplace(token, std::move(e));
+}
+
+void descriptor_relay::purge_expired(clock::time_point now) {
+    for (auto itr = entries_.begin(); itr != entries_.end(); ) {
+        if (itr->second.expiry < now) {
+            itr = entries_.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
+void descriptor_relay::run() {
+    std::array<pollfd, 2> fds{{{listen_fd_.get(), POLLIN, 0}, {wakeup_fd_.get(), POLLIN, 0}}};
+    while (true) {
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_LP(ERROR) << "descriptor relay stops polling: " << std::strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+            return;
+        }
+        if ((fds[1].revents & POLLIN) != 0) {  // NOLINT(hicpp-signed-bitwise)
+            return;
+        }
+        if ((fds[0].revents & POLLIN) != 0) {  // NOLINT(hicpp-signed-bitwise)
+            file_descriptor conn(::accept4(listen_fd_.get(), nullptr, nullptr, SOCK_CLOEXEC));
+            if (!conn) {
+                continue;
+            }
+            if (!same_user(conn.get())) {
+                LOG_LP(WARNING) << "descriptor relay refused a connection from a peer of another user";
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(connections_mtx_);
+                connections_.emplace_back(std::move(conn));
+            }
+            connections_cv_.notify_one();
+        }
+    }
+}
+
+void descriptor_relay::serve() {
+    std::unique_lock<std::mutex> lock(connections_mtx_);
+    while (true) {
+        connections_cv_.wait(lock, [this]{ return stopping_ || !connections_.empty(); });
+        if (stopping_) {
+            return;  // the connections left are closed without response
+        }
+        auto conn = std::move(connections_.front());
+        connections_.pop_front();
+        lock.unlock();
+        handle(conn.get());
+        lock.lock();
+    }
+}
+
+void descriptor_relay::handle(int conn) {
+    timeval tv{0, io_timeout_ms * 1000};
+    ::setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ::setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    std::array<char, request_size> request{};
+    file_descriptor received{};
+    if (!receive(conn, request, received)) {
+        VLOG_LP(log_debug) << "descriptor relay cannot receive a request";
+        return;
+    }
+    token_type token{};
+    std::memcpy(&token, request.data() + 1, sizeof(token));  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+    switch (request[0]) {
+        case OP_GET: {
+            auto e = remove(token, true);
+            std::uint8_t status = e ? STATUS_OK : STATUS_NOT_FOUND;
+            if (!send(conn, &status, sizeof(status), e ? e->fd.get() : -1)) {
+                if (e) {
+                    LOG_LP(WARNING) << "descriptor relay cannot hand over a descriptor, which is offered again until the token expires: " << std::strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+                    restore(token, std::move(e.value()));
+                }
+                return;
+            }
+            VLOG_LP(log_debug) << "descriptor relay handed over a descriptor, status = " << static_cast<int>(status);
+            return;
+        }
+        case OP_PUT: {
+            std::array<char, request_size> response{};
+            if (!received) {
+                response[0] = static_cast<char>(STATUS_INVALID);
+                send(conn, response.data(), response.size(), -1);
+                return;
+            }
+            token = store(std::move(received), false);
+            response[0] = static_cast<char>(STATUS_OK);
+            std::memcpy(response.data() + 1, &token, sizeof(token));  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            send(conn, response.data(), response.size(), -1);
+            VLOG_LP(log_debug) << "descriptor relay received a descriptor";
+            return;
+        }
+        default: {
+            std::uint8_t status = STATUS_INVALID;
+            send(conn, &status, sizeof(status), -1);
+            return;
+        }
+    }
+}
+
+} // namespace data_relay_grpc::blob_relay
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "file_descriptor.h"
+
+namespace data_relay_grpc::blob_relay {
+
+/**
+ * @brief hands over file descriptors between the server and local clients through a Unix domain socket
+ * @details descriptors are exchanged with one-time tokens, which are passed through BlobRelayLocal.
+ *    See DescriptorHandoff in blob_relay_local.proto for the protocol on the socket.
+ *    The socket file is accessible only by the owner, and connections from the peers running as other users
+ *    are closed. The connections are served by a few worker threads, so that a slow peer does not delay others.
+ */
+class descriptor_relay {
+public:
+    using token_type = std::uint64_t;
+    using clock = std::chrono::steady_clock;
+
+    constexpr static char OP_GET = 'G';
+    constexpr static char OP_PUT = 'P';
+    constexpr static std::uint8_t STATUS_OK = 0;
+    constexpr static std::uint8_t STATUS_NOT_FOUND = 1;
+    constexpr static std::uint8_t STATUS_INVALID = 2;
+
+    /**
+     * @brief creates the socket and starts accepting connections.
+     * @param socket_path the path to the Unix domain socket, an existing socket file is replaced
+     * @param ttl the time a token remains valid
+     * @param workers the number of threads serving the connections, at least 1
+     * @throws std::system_error if the socket cannot be created
+     */
+    explicit descriptor_relay(std::filesystem::path socket_path, clock::duration ttl = std::chrono::seconds(30), std::size_t workers = 4);
+
+    /**
+     * @brief stops accepting connections, removes the socket file and closes pending descriptors.
+     */
+    ~descriptor_relay();
+
+    descriptor_relay(const descriptor_relay&) = delete;
+    descriptor_relay& operator=(const descriptor_relay&) = delete;
+    descriptor_relay(descriptor_relay&&) = delete;
+    descriptor_relay& operator=(descriptor_relay&&) = delete;
+
+    [[nodiscard]] const std::filesystem::path& socket_path() const noexcept {
+        return socket_path_;
+    }
+
+    /**
+     * @brief registers a descriptor to be received by a client with the returned token.
+     * @param fd the descriptor, owned by this object afterwards
+     * @return the token
+     */
+    [[nodiscard]] token_type offer(file_descriptor fd);
+
+    /**
+     * @brief takes the descriptor sent by a client with the token.
+     * @param token the token returned to the client
+     * @return the descriptor, or an empty one if the token is unknown or has expired
+     */
+    [[nodiscard]] file_descriptor take(token_type token);
+
+private:
+    struct entry {
+        file_descriptor fd;
+        clock::time_point expiry;
+        bool offered;
+    };
+
+    std::filesystem::path socket_path_;
+    clock::duration ttl_;
+    file_descriptor listen_fd_{};
+    file_descriptor wakeup_fd_{};
+    std::unordered_map<token_type, entry> entries_{};
+    std::mutex mtx_{};
+    std::thread thread_{};
+
+    // the accepted connections waiting for a worker
+    std::deque<file_descriptor> connections_{};
+    bool stopping_{};
+    std::mutex connections_mtx_{};
+    std::condition_variable connections_cv_{};
+    std::vector<std::thread> workers_{};
+
+    token_type store(file_descriptor fd, bool offered);
+    std::optional<entry> remove(token_type token, bool offered);
+    void restore(token_type token, entry e);
+    void purge_expired(clock::time_point now);
+    void run();
+    void serve();
+    void handle(int conn);
+};
+
+} // namespace data_relay_grpc::blob_relay
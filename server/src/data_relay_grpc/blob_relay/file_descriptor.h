@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <utility>
+
+#include <unistd.h>
+
+namespace data_relay_grpc::blob_relay {
+
+/**
+ * @brief an owning file descriptor, closed on destruction
+ */
+class file_descriptor {
+public:
+    file_descriptor() noexcept = default;
+    explicit file_descriptor(int fd) noexcept : fd_(fd) {}
+    ~file_descriptor() {
+        reset();
+    }
+    file_descriptor(const file_descriptor&) = delete;
+    file_descriptor& operator=(const file_descriptor&) = delete;
+    file_descriptor(file_descriptor&& other) noexcept : fd_(other.release()) {}
+    file_descriptor& operator=(file_descriptor&& other) noexcept {
+        if (this != &other) {
+            reset(other.release());
+        }
+        return *this;
+    }
+
+    [[nodiscard]] int get() const noexcept { return fd_; }
+    explicit operator bool() const noexcept { return fd_ >= 0; }
+
+    int release() noexcept {
+        return std::exchange(fd_, -1);
+    }
+    void reset(int fd = -1) noexcept {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        fd_ = fd;
+    }
+
+private:
+    int fd_{-1};
+};
+
+} // namespace data_relay_grpc::blob_relay
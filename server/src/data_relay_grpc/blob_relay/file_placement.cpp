@@ -0,0 +1,263 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+
+#include <glog/logging.h>
+#include "data_relay_grpc/logging_helper.h"
+#include "data_relay_grpc/logging.h"
+
+#include "file_placement.h"
+#include "file_descriptor.h"
+
+namespace data_relay_grpc::blob_relay {
+
+namespace {
+
+// copies the whole contents regardless of the file offset of src,
+// using the in-kernel copy_file_range if the file systems support it
+bool copy_contents(int src, int dst) {
+    loff_t offset = 0;
+    bool in_kernel = true;
+    while (in_kernel) {
+        ssize_t n = ::copy_file_range(src, &offset, dst, nullptr, SSIZE_MAX, 0);
+        if (n == 0) {
+            return true;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EXDEV && errno != ENOSYS && errno != EOPNOTSUPP && errno != EINVAL) {
+                return false;
+            }
+            in_kernel = false;
+        }
+    }
+
+    std::array<char, 1024 * 1024> buf{};  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+    while (true) {
+        ssize_t n = ::pread(src, buf.data(), buf.size(), offset);
+        if (n == 0) {
+            return true;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        for (ssize_t done = 0; done < n; ) {
+            ssize_t w = ::write(dst, buf.data() + done, n - done);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            if (w < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            done += w;
+        }
+        offset += n;
+    }
+}
+
+// clones (reflink) or copies the source file to the newly created destination file
+bool clone_or_copy(int src, const std::filesystem::path& destination, bool clone, int& error) {
+    struct stat st{};
+    if (::fstat(src, &st) != 0) {
+        error = errno;
+        return false;
+    }
+    file_descriptor dst(::open(destination.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 0777));  // NOLINT
+    if (!dst) {
+        error = errno;
+        return false;
+    }
+    bool succeeded = clone ? ::ioctl(dst.get(), FICLONE, src) == 0 : copy_contents(src, dst.get());  // NOLINT(cppcoreguidelines-pro-type-vararg)
+    if (!succeeded) {
+        error = errno;
+        ::unlink(destination.c_str());
+    }
+    return succeeded;
+}
+
+bool clone_or_copy(const std::filesystem::path& source, const std::filesystem::path& destination, bool clone, int& error) {
+    file_descriptor src(::open(source.c_str(), O_RDONLY | O_CLOEXEC));  // NOLINT(cppcoreguidelines-pro-type-vararg)
+    if (!src) {
+        error = errno;
+        return false;
+    }
+    return clone_or_copy(src.get(), destination, clone, error);
+}
+
+// moves the source file, which is consumed, refusing a symbolic link so that no file but the one named is removed
+placement_strategy move_file(const std::filesystem::path& source, const std::filesystem::path& destination) {
+    file_descriptor src(::open(source.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC));  // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-signed-bitwise)
+    if (!src) {
+        if (errno == ELOOP) {
+            throw std::system_error(ELOOP, std::generic_category(), source.string() + " is a symbolic link, which cannot be moved");
+        }
+        throw std::system_error(errno, std::generic_category(), "cannot open " + source.string());
+    }
+    struct stat st{};
+    if (::fstat(src.get(), &st) != 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot stat " + source.string());
+    }
+    if (!S_ISREG(st.st_mode)) {  // NOLINT(hicpp-signed-bitwise)
+        throw std::system_error(EINVAL, std::generic_category(), source.string() + " is not a regular file");
+    }
+    // the path may be replaced after it is opened, so the file there is checked before it is moved or removed
+    auto is_opened_file = [&st](const std::filesystem::path& path) {
+        struct stat lst{};
+        return ::lstat(path.c_str(), &lst) == 0 && lst.st_dev == st.st_dev && lst.st_ino == st.st_ino;
+    };
+
+    if (::rename(source.c_str(), destination.c_str()) == 0) {
+        if (!is_opened_file(destination)) {
+            ::unlink(destination.c_str());
+            throw std::system_error(EAGAIN, std::generic_category(), source.string() + " has been replaced while it is moved");
+        }
+        VLOG_LP(log_debug) << "placed " << source.string() << " at " << destination.string() << " by " << to_string_view(placement_strategy::move);
+        return placement_strategy::move;
+    }
+    // e.g. across file systems, place the opened file and then remove the source
+    auto used = place_file(src.get(), destination, placement_strategy::hardlink);
+    if (is_opened_file(source)) {
+        ::unlink(source.c_str());
+    }
+    return used;
+}
+
+} // namespace
+
+placement_strategy place_file(const std::filesystem::path& source, const std::filesystem::path& destination, placement_strategy strategy) {
+    if (strategy == placement_strategy::move) {
+        return move_file(source, destination);
+    }
+    int error = 0;
+
+    // place the file itself rather than a symbolic link to it, which is left as it is
+    std::error_code ec{};
+    auto src = std::filesystem::canonical(source, ec);
+    if (ec) {
+        throw std::system_error(ec, "cannot resolve " + source.string());
+    }
+    if (!std::filesystem::is_regular_file(src, ec)) {
+        throw std::system_error(ec ? ec : std::make_error_code(std::errc::invalid_argument), src.string() + " is not a regular file");
+    }
+
+    auto placed = [&](placement_strategy used) {
+        VLOG_LP(log_debug) << "placed " << src.string() << " at " << destination.string() << " by " << to_string_view(used);
+        return used;
+    };
+    switch (strategy) {
+        case placement_strategy::automatic:
+        case placement_strategy::move:
+        case placement_strategy::hardlink:
+            if (::link(src.c_str(), destination.c_str()) == 0) {
+                return placed(placement_strategy::hardlink);
+            }
+            error = errno;
+            [[fallthrough]];
+        case placement_strategy::reflink:
+            if (clone_or_copy(src, destination, true, error)) {
+                return placed(placement_strategy::reflink);
+            }
+            [[fallthrough]];
+        case placement_strategy::copy:
+            if (clone_or_copy(src, destination, false, error)) {
+                return placed(placement_strategy::copy);
+            }
+            break;
+    }
+    throw std::system_error(error, std::generic_category(), "cannot place " + src.string() + " at " + destination.string());
+}
+
+placement_strategy place_file(int source, const std::filesystem::path& destination, placement_strategy strategy) {
+    int error = 0;
+
+    struct stat st{};
+    if (::fstat(source, &st) != 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot stat the file descriptor " + std::to_string(source));
+    }
+    if (!S_ISREG(st.st_mode)) {  // NOLINT(hicpp-signed-bitwise)
+        throw std::system_error(EINVAL, std::generic_category(), "the file descriptor " + std::to_string(source) + " is not a regular file");
+    }
+
+    auto placed = [&](placement_strategy used) {
+        VLOG_LP(log_debug) << "placed the file descriptor " << source << " at " << destination.string() << " by " << to_string_view(used);
+        return used;
+    };
+    switch (strategy) {
+        case placement_strategy::automatic:
+        case placement_strategy::move:
+        case placement_strategy::hardlink: {
+            // the descriptor cannot be renamed, link the file it refers to instead
+            auto proc_path = "/proc/self/fd/" + std::to_string(source);
+            if (::linkat(AT_FDCWD, proc_path.c_str(), AT_FDCWD, destination.c_str(), AT_SYMLINK_FOLLOW) == 0) {
+                return placed(placement_strategy::hardlink);
+            }
+            error = errno;
+            [[fallthrough]];
+        }
+        case placement_strategy::reflink:
+            if (clone_or_copy(source, destination, true, error)) {
+                return placed(placement_strategy::reflink);
+            }
+            [[fallthrough]];
+        case placement_strategy::copy:
+            if (clone_or_copy(source, destination, false, error)) {
+                return placed(placement_strategy::copy);
+            }
+            break;
+    }
+    throw std::system_error(error, std::generic_category(), "cannot place the file descriptor " + std::to_string(source) + " at " + destination.string());
+}
+
+bool seal_file(int fd) noexcept {
+    constexpr int required = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE;  // NOLINT(hicpp-signed-bitwise)
+    int seals = ::fcntl(fd, F_GET_SEALS);  // NOLINT(cppcoreguidelines-pro-type-vararg)
+    if (seals < 0) {
+        return false;
+    }
+    if ((seals & required) == required) {  // NOLINT(hicpp-signed-bitwise)
+        return true;
+    }
+    return ::fcntl(fd, F_ADD_SEALS, required | F_SEAL_SEAL) == 0;  // NOLINT
+}
+
+std::string_view to_string_view(placement_strategy strategy) noexcept {
+    using namespace std::string_view_literals;
+    switch (strategy) {
+        case placement_strategy::automatic: return "automatic"sv;
+        case placement_strategy::move: return "move"sv;
+        case placement_strategy::hardlink: return "hardlink"sv;
+        case placement_strategy::reflink: return "reflink"sv;
+        case placement_strategy::copy: return "copy"sv;
+    }
+    return "unknown"sv;
+}
+
+} // namespace data_relay_grpc::blob_relay
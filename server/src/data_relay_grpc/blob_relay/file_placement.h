@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+#include <data_relay_grpc/blob_relay/service_configuration.h>
+
+namespace data_relay_grpc::blob_relay {
+
+/**
+ * @brief places the source file at the destination path in the session store.
+ * @details strategies are tried in the order of hardlink, reflink and copy starting from the given one,
+ *    where placement_strategy::automatic starts from hardlink and the source file is left as it is.
+ *    If the given strategy is placement_strategy::move, the source file is renamed, or placed by the others and removed.
+ *    The source file is resolved if it is a symbolic link, except for placement_strategy::move which refuses it.
+ * @param source the file to place
+ * @param destination the path to place the file at, which must not exist
+ * @param strategy the first strategy to try
+ * @return the strategy actually used
+ * @throws std::system_error if the file cannot be placed by any strategy
+ */
+placement_strategy place_file(const std::filesystem::path& source, const std::filesystem::path& destination, placement_strategy strategy);
+
+/**
+ * @brief places the file referred by the descriptor at the destination path in the session store.
+ * @details as the descriptor cannot be renamed, placement_strategy::automatic and placement_strategy::move are
+ *    treated as placement_strategy::hardlink.
+ * @param source the descriptor of the file to place, which is not closed by this function
+ * @param destination the path to place the file at, which must not exist
+ * @param strategy the first strategy to try
+ * @return the strategy actually used
+ * @throws std::system_error if the file cannot be placed by any strategy
+ */
+placement_strategy place_file(int source, const std::filesystem::path& destination, placement_strategy strategy);
+
+/**
+ * @brief seals the memory file (memfd) against any modification.
+ * @param fd the descriptor of the file
+ * @return true if the file has been sealed against write, shrink and grow
+ * @return false if the file cannot be sealed, e.g. it is not a memfd created with MFD_ALLOW_SEALING
+ */
+bool seal_file(int fd) noexcept;
+
+std::string_view to_string_view(placement_strategy strategy) noexcept;
+
+} // namespace data_relay_grpc::blob_relay
@@ -1,56 +1,224 @@
 #include <fstream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <glog/logging.h>
 
 #include <data_relay_grpc/common/session.h>
+#include <data_relay_grpc/common/detail/trace.h>
+#include "data_relay_grpc/logging_helper.h"
+#include "data_relay_grpc/logging.h"
+
 #include "local_service.h"
+#include "file_placement.h"
 #include "utils.h"
 
 namespace data_relay_grpc::blob_relay {
 
 using data_relay_grpc::common::blob_session;
 
-local_service::local_service(common::detail::blob_session_manager& session_manager)
-    : session_manager_(session_manager) {
+local_service::local_service(common::detail::blob_session_manager& session_manager, bool upload_copy_file, placement_strategy upload_placement, relay_metrics& metrics, descriptor_relay* relay)
+    : session_manager_(session_manager), upload_copy_file_(upload_copy_file), upload_placement_(upload_placement), metrics_(metrics), relay_(relay) {
 }
 
 ::grpc::Status local_service::Get([[maybe_unused]] ::grpc::ServerContext* context,
                                        const GetLocalRequest* request,
                                        GetLocalResponse* response) {
+    trace_scope_name("BlobRelayLocal.Get");
+    auto start = relay_metrics::clock::now();
+    auto status = get(request, response);
+    metrics_.rpc_finished(rpc_method::local_get, status.error_code(), relay_metrics::clock::now() - start);
+    return status;
+}
+
+::grpc::Status local_service::Put([[maybe_unused]] ::grpc::ServerContext* context,
+                                  const ::data_relay_grpc::blob_relay::PutLocalRequest* request,
+                                  PutLocalResponse* response) {
+    trace_scope_name("BlobRelayLocal.Put");
+    auto start = relay_metrics::clock::now();
+    auto status = put(request, response);
+    metrics_.rpc_finished(rpc_method::local_put, status.error_code(), relay_metrics::clock::now() - start);
+    return status;
+}
+
+::grpc::Status local_service::get(const GetLocalRequest* request,
+                                  GetLocalResponse* response) {
     if (!check_api_version(request->api_version())) {
         return ::grpc::Status(::grpc::StatusCode::UNAVAILABLE, api_version_error_message(request->api_version()));
     }
 
-    auto& session_impl = session_manager_.get_session_impl(request->session_id());
-    if (auto transaction_id_opt = session_impl.get_transaction_id(); transaction_id_opt) {
-        blob_session::transaction_id_type transaction_id = transaction_id_opt.value();
-        blob_session::blob_id_type blob_id = request->blob().object_id();
+    try {
+        auto session = session_manager_.pin_session(request->session_id());
+        auto& session_impl = *session;
+        if (auto transaction_id_opt = session_impl.get_transaction_id(); transaction_id_opt) {
+            blob_session::transaction_id_type transaction_id = transaction_id_opt.value();
+            blob_session::blob_id_type blob_id = request->blob().object_id();
 
-        blob_session::blob_tag_type tag = session_manager_.get_tag(blob_id, transaction_id);
+            blob_session::blob_tag_type tag = session_manager_.get_tag(blob_id, transaction_id);
 
-        if (tag != request->blob().tag()) {
-            return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "can not find blob with the tag given");
-        }
+            if (tag != request->blob().tag()) {
+                trace_event("tag mismatch");
+                return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "can not find blob with the tag given");
+            }
 
-        response->mutable_data()->set_path(session_manager_.get_path(blob_id));
-        return ::grpc::Status(::grpc::StatusCode::OK, "");
+            file_descriptor fd{};
+            blob_session::blob_path_type path{};
+            bool prefer_descriptor = request->prefer_descriptor() && relay_ != nullptr;
+            if (request->blob().storage_id() == SESSION_STORAGE_ID) {
+                if (auto reopened = prefer_descriptor ? session_impl.reopen_descriptor(blob_id) : std::nullopt; reopened) {
+                    fd.reset(reopened.value());
+                } else if (auto path_opt = session_impl.materialize(blob_id); path_opt) {
+                    // the BLOB in a memory file is written to a file in the session store, as it has no path of its own
+                    path = path_opt.value();
+                } else {
+                    VLOG_LP(log_debug) << "finishes with NOT_FOUND";
+                    return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "cannot find the blob data by the blob_id given");
+                }
+            } else {
+                path = session_manager_.get_path(blob_id);
+            }
+
+            if (prefer_descriptor) {
+                if (!fd) {
+                    fd.reset(::open(path.c_str(), O_RDONLY | O_CLOEXEC));  // NOLINT(cppcoreguidelines-pro-type-vararg)
+                    if (!fd) {
+                        VLOG_LP(log_debug) << "finishes with NOT_FOUND";
+                        return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "cannot open the blob file: " + path.string());
+                    }
+                }
+                auto* handoff = response->mutable_data()->mutable_handoff();
+                handoff->set_socket_path(relay_->socket_path().string());
+                handoff->set_token(relay_->offer(std::move(fd)));
+                VLOG_LP(log_debug) << "finishes normally with a descriptor";
+                return ::grpc::Status(::grpc::StatusCode::OK, "");
+            }
+            response->mutable_data()->set_path(path);
+            return ::grpc::Status(::grpc::StatusCode::OK, "");
+        }
+    } catch (std::out_of_range &ex) {
+        VLOG_LP(log_debug) << "finishes with NOT_FOUND";
+        return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, ex.what());
+    } catch (std::system_error &ex) {
+        VLOG_LP(log_debug) << "finishes with INTERNAL";
+        return ::grpc::Status(::grpc::StatusCode::INTERNAL, ex.what());
     }
-    
+
     return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "the session has no transaction");
 }
 
-::grpc::Status local_service::Put([[maybe_unused]] ::grpc::ServerContext* context,
-                                  const ::data_relay_grpc::blob_relay::PutLocalRequest* request,
+::grpc::Status local_service::put(const PutLocalRequest* request,
                                   PutLocalResponse* response) {
     if (!check_api_version(request->api_version())) {
         return ::grpc::Status(::grpc::StatusCode::UNAVAILABLE, api_version_error_message(request->api_version()));
     }
 
-    auto& session_impl = session_manager_.get_session_impl(request->session_id());
-    auto pair = session_impl.create_blob_file();
-    std::filesystem::copy(std::filesystem::path(request->data().path()), pair.second);
-    auto* blob = response->mutable_blob();
-    blob->set_storage_id(0);
-    blob->set_object_id(pair.first);
-    return ::grpc::Status(::grpc::StatusCode::OK, "");
+    try {
+        auto session = session_manager_.pin_session(request->session_id());
+        auto& session_impl = *session;
+        auto strategy = upload_placement(request->placement());
+        file_descriptor fd{};
+        if (request->data().location_case() == BlobFile::LocationCase::kHandoff) {
+            if (relay_ == nullptr) {
+                VLOG_LP(log_debug) << "finishes with FAILED_PRECONDITION";
+                return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "file descriptor passing is not enabled");
+            }
+            fd = relay_->take(request->data().handoff().token());
+            if (!fd) {
+                VLOG_LP(log_debug) << "finishes with NOT_FOUND";
+                return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "no file descriptor has been sent with the token, or the token has expired");
+            }
+        }
+        if (fd && seal_file(fd.get())) {
+            // a sealed memory file is immutable, and thus can be adopted without copying
+            struct stat st{};
+            if (::fstat(fd.get(), &st) != 0) {
+                VLOG_LP(log_debug) << "finishes with FAILED_PRECONDITION";
+                return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "cannot stat the file descriptor sent");
+            }
+            common::detail::quota_level exceeded{};
+            auto blob_id_opt = session_impl.adopt_blob_file(fd.get(), static_cast<std::size_t>(st.st_size), exceeded);
+            if (!blob_id_opt) {
+                VLOG_LP(log_debug) << "finishes with RESOURCE_EXHAUSTED";
+                return ::grpc::Status(::grpc::StatusCode::RESOURCE_EXHAUSTED, std::string(common::detail::quota_exceeded_message(exceeded)));
+            }
+            fd.release();
+            auto* blob = response->mutable_blob();
+            blob->set_storage_id(SESSION_STORAGE_ID);
+            blob->set_object_id(blob_id_opt.value());
+            VLOG_LP(log_debug) << "finishes normally, adopted a sealed memory file as blob_id = " << blob_id_opt.value();
+            return ::grpc::Status(::grpc::StatusCode::OK, "");
+        }
+        // the size is charged before placing the file, so that a file moved into the session store is not lost when the quota is exceeded
+        std::size_t size{};
+        if (fd) {
+            struct stat st{};
+            if (::fstat(fd.get(), &st) != 0) {
+                VLOG_LP(log_debug) << "finishes with FAILED_PRECONDITION";
+                return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "cannot stat the file descriptor sent");
+            }
+            size = static_cast<std::size_t>(st.st_size);
+        } else {
+            std::error_code ec{};
+            size = std::filesystem::file_size(std::filesystem::path(request->data().path()), ec);
+            if (ec) {
+                VLOG_LP(log_debug) << "finishes with FAILED_PRECONDITION";
+                return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "cannot stat the file: " + request->data().path());
+            }
+        }
+        auto pair = session_impl.create_blob_file();
+        VLOG_LP(log_debug) << "accepted request: session_id = " << request->session_id() << ", path = " << (fd ? "(descriptor)" : request->data().path()) << ", placement = " << to_string_view(strategy) << ", to be create a blob file with blob_id = " << pair.first << " of session storage";
+        if (auto exceeded = session_impl.try_reserve_session_store(pair.first, size); exceeded != common::detail::quota_level::none) {
+            session_impl.delete_blob_file(pair.first);
+            VLOG_LP(log_debug) << "finishes with RESOURCE_EXHAUSTED";
+            return ::grpc::Status(::grpc::StatusCode::RESOURCE_EXHAUSTED, std::string(common::detail::quota_exceeded_message(exceeded)));
+        }
+        try {
+            trace_scope_name("place file");
+            if (fd) {
+                place_file(fd.get(), pair.second, strategy);
+            } else {
+                place_file(std::filesystem::path(request->data().path()), pair.second, strategy);
+            }
+        } catch (std::system_error &ex) {
+            session_impl.delete_blob_file(pair.first);
+            VLOG_LP(log_debug) << "finishes with FAILED_PRECONDITION";
+            return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, ex.what());
+        }
+        session_impl.complete_blob_file(pair.first);
+        auto* blob = response->mutable_blob();
+        blob->set_storage_id(SESSION_STORAGE_ID);
+        blob->set_object_id(pair.first);
+        VLOG_LP(log_debug) << "finishes normally";
+        return ::grpc::Status(::grpc::StatusCode::OK, "");
+    } catch (std::out_of_range &ex) {
+        VLOG_LP(log_debug) << "finishes with NOT_FOUND";
+        return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, ex.what());
+    }
+}
+
+placement_strategy local_service::upload_placement(LocalUploadPlacement requested) const noexcept {
+    placement_strategy strategy = upload_placement_;
+    switch (requested) {
+        case LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_MOVE: strategy = placement_strategy::move; break;
+        case LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_HARDLINK: strategy = placement_strategy::hardlink; break;
+        case LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_REFLINK: strategy = placement_strategy::reflink; break;
+        case LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_COPY: strategy = placement_strategy::copy; break;
+        default: break;
+    }
+    // the file of the client is consumed only if the client asks for it
+    if (strategy == placement_strategy::move && requested != LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_MOVE) {
+        strategy = placement_strategy::automatic;
+    }
+    if (strategy == placement_strategy::automatic) {
+        strategy = upload_copy_file_ ? placement_strategy::reflink : placement_strategy::hardlink;
+    }
+    // the session store must own a private copy of the file if local_upload_copy_file is set
+    if (upload_copy_file_ && (strategy == placement_strategy::move || strategy == placement_strategy::hardlink)) {
+        strategy = placement_strategy::reflink;
+    }
+    return strategy;
 }
 
 } // namespace data_relay_grpc::blob_relay
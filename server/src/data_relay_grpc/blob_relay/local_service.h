@@ -2,8 +2,11 @@
 #include <grpcpp/grpcpp.h>
 
 #include <data_relay_grpc/common/detail/session_manager.h>
+#include <data_relay_grpc/blob_relay/service_configuration.h>
 #include "data_relay_grpc/proto/blob_relay/blob_relay_local.grpc.pb.h"
 #include "data_relay_grpc/proto/blob_relay/blob_relay_local.pb.h"
+#include "descriptor_relay.h"
+#include "relay_metrics.h"
 
 namespace data_relay_grpc::blob_relay {
 
@@ -12,10 +15,12 @@ using data_relay_grpc::proto::blob_relay::blob_relay_local::PutLocalRequest;
 using data_relay_grpc::proto::blob_relay::blob_relay_local::PutLocalResponse;
 using data_relay_grpc::proto::blob_relay::blob_relay_local::GetLocalRequest;
 using data_relay_grpc::proto::blob_relay::blob_relay_local::GetLocalResponse;
+using data_relay_grpc::proto::blob_relay::blob_relay_local::LocalUploadPlacement;
+using data_relay_grpc::proto::blob_relay::blob_relay_local::BlobFile;
 
 class local_service final : public BlobRelayLocal::Service {
   public:
-    explicit local_service(common::detail::blob_session_manager& server);
+    local_service(common::detail::blob_session_manager& server, bool upload_copy_file, placement_strategy upload_placement, relay_metrics& metrics, descriptor_relay* relay = nullptr);
     ~local_service() override = default;
 
     local_service(const local_service&) = delete;
@@ -33,6 +38,19 @@ class local_service final : public BlobRelayLocal::Service {
 
 private:
     common::detail::blob_session_manager& session_manager_;
+    bool upload_copy_file_;
+    placement_strategy upload_placement_;
+    relay_metrics& metrics_;
+    descriptor_relay* relay_;
+    constexpr static std::uint64_t SESSION_STORAGE_ID = 0;
+
+    [[nodiscard]] placement_strategy upload_placement(LocalUploadPlacement requested) const noexcept;
+
+    ::grpc::Status get(const GetLocalRequest* request,
+                       GetLocalResponse* response);
+
+    ::grpc::Status put(const PutLocalRequest* request,
+                       PutLocalResponse* response);
 };
 
 } // namespace data_relay_grpc::blob_relay
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sstream>
+
+#include "relay_metrics.h"
+
+namespace data_relay_grpc::blob_relay {
+
+namespace {
+
+constexpr double nanoseconds_per_second = 1e9;
+
+void write_summary(std::ostringstream& out, std::string_view name, std::string_view labels, const common::detail::histogram::snapshot& s, double scale) {
+    auto separator = labels.empty() ? "" : ",";
+    for (auto [quantile, percentile] : {std::pair{"0.5", 50.0}, std::pair{"0.9", 90.0}, std::pair{"0.99", 99.0}}) {  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+        out << name << "{" << labels << separator << "quantile=\"" << quantile << "\"} " << static_cast<double>(s.value_at(percentile)) / scale << "\n";
+    }
+    auto braces = labels.empty() ? std::string{} : "{" + std::string(labels) + "}";
+    out << name << "_sum" << braces << " " << static_cast<double>(s.sum) / scale << "\n";
+    out << name << "_count" << braces << " " << s.count << "\n";
+}
+
+void write_metric(std::ostringstream& out, std::string_view name, std::string_view type, std::string_view help, std::uint64_t value) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+    out << name << " " << value << "\n";
+}
+
+} // namespace
+
+void relay_metrics::rpc_finished(rpc_method method, ::grpc::StatusCode code, clock::duration elapsed) noexcept {
+    auto& m = methods_[static_cast<std::size_t>(method)];  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    auto index = static_cast<std::size_t>(code);
+    if (index < status_count) {
+        m.calls[index].add();  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+    m.latency.record(nanoseconds(elapsed));
+}
+
+std::uint64_t relay_metrics::calls(rpc_method method, ::grpc::StatusCode code) const noexcept {
+    auto index = static_cast<std::size_t>(code);
+    if (index >= status_count) {
+        return 0;
+    }
+    return methods_[static_cast<std::size_t>(method)].calls[index].value();  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+}
+
+common::detail::histogram::snapshot relay_metrics::latency(rpc_method method) const {
+    return methods_[static_cast<std::size_t>(method)].latency.take();  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+}
+
+std::string_view relay_metrics::method_name(rpc_method method) noexcept {
+    switch (method) {
+        case rpc_method::streaming_get: return "BlobRelayStreaming.Get";
+        case rpc_method::streaming_put: return "BlobRelayStreaming.Put";
+        case rpc_method::local_get: return "BlobRelayLocal.Get";
+        case rpc_method::local_put: return "BlobRelayLocal.Put";
+    }
+    return "unknown";
+}
+
+std::string_view relay_metrics::status_name(::grpc::StatusCode code) noexcept {
+    static constexpr std::array<std::string_view, status_count> names{
+        "OK", "CANCELLED", "UNKNOWN", "INVALID_ARGUMENT", "DEADLINE_EXCEEDED", "NOT_FOUND", "ALREADY_EXISTS",
+        "PERMISSION_DENIED", "RESOURCE_EXHAUSTED", "FAILED_PRECONDITION", "ABORTED", "OUT_OF_RANGE",
+        "UNIMPLEMENTED", "INTERNAL", "UNAVAILABLE", "DATA_LOSS", "UNAUTHENTICATED",
+    };
+    auto index = static_cast<std::size_t>(code);
+    return index < names.size() ? names[index] : "UNKNOWN";  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+}
+
+std::string relay_metrics::prometheus_text(const common::detail::blob_session_manager& manager) const {
+    std::ostringstream out{};
+
+    out << "# HELP blob_relay_rpc_calls_total the number of the RPC calls finished\n";
+    out << "# TYPE blob_relay_rpc_calls_total counter\n";
+    for (std::size_t m = 0; m < method_count; m++) {
+        auto method = static_cast<rpc_method>(m);
+        for (std::size_t c = 0; c < status_count; c++) {
+            auto code = static_cast<::grpc::StatusCode>(c);
+            if (auto n = calls(method, code); n > 0) {
+                out << "blob_relay_rpc_calls_total{method=\"" << method_name(method) << "\",code=\"" << status_name(code) << "\"} " << n << "\n";
+            }
+        }
+    }
+    out << "# HELP blob_relay_rpc_latency_seconds the time from the start to the finish of the RPC calls\n";
+    out << "# TYPE blob_relay_rpc_latency_seconds summary\n";
+    for (std::size_t m = 0; m < method_count; m++) {
+        auto method = static_cast<rpc_method>(m);
+        write_summary(out, "blob_relay_rpc_latency_seconds", "method=\"" + std::string(method_name(method)) + "\"", latency(method), nanoseconds_per_second);
+    }
+
+    out << "# HELP blob_relay_transfer_bytes_total the bytes of the BLOB data transferred by gRPC streaming\n";
+    out << "# TYPE blob_relay_transfer_bytes_total counter\n";
+    out << "blob_relay_transfer_bytes_total{direction=\"in\"} " << bytes_in() << "\n";
+    out << "blob_relay_transfer_bytes_total{direction=\"out\"} " << bytes_out() << "\n";
+    out << "# HELP blob_relay_chunk_size_bytes the sizes of the chunks transferred\n";
+    out << "# TYPE blob_relay_chunk_size_bytes summary\n";
+    write_summary(out, "blob_relay_chunk_size_bytes", "direction=\"in\"", chunk_size_in(), 1.0);
+    write_summary(out, "blob_relay_chunk_size_bytes", "direction=\"out\"", chunk_size_out(), 1.0);
+    out << "# HELP blob_relay_stream_blocked_seconds the time blocked in reading from or writing to the stream\n";
+    out << "# TYPE blob_relay_stream_blocked_seconds summary\n";
+    write_summary(out, "blob_relay_stream_blocked_seconds", "operation=\"read\"", read_blocked(), nanoseconds_per_second);
+    write_summary(out, "blob_relay_stream_blocked_seconds", "operation=\"write\"", write_blocked(), nanoseconds_per_second);
+
+    auto stats = manager.statistics();
+    write_metric(out, "blob_relay_active_sessions", "gauge", "the number of the sessions not disposed", stats.sessions);
+    write_metric(out, "blob_relay_session_blobs", "gauge", "the number of the BLOBs in the sessions", stats.blobs);
+    write_metric(out, "blob_relay_session_blobs_max", "gauge", "the maximum number of the BLOBs in a session", stats.max_blobs_per_session);
+    write_metric(out, "blob_relay_session_store_usage_bytes", "gauge", "the bytes used in the session store", manager.session_store_current_size());
+    write_metric(out, "blob_relay_session_store_quota_bytes", "gauge", "the quota of the session store, or 0 if not limited", manager.session_store_quota());
+    write_metric(out, "blob_relay_memory_tier_usage_bytes", "gauge", "the bytes of the BLOBs kept in memory", manager.memory_tier_usage());
+    write_metric(out, "blob_relay_pending_deletions", "gauge", "the number of the BLOB files waiting for deletion", manager.pending_deletions());
+
+    out << "# HELP blob_relay_cache_lookups_total the lookups of the caches of the datastore callbacks\n";
+    out << "# TYPE blob_relay_cache_lookups_total counter\n";
+    out << "blob_relay_cache_lookups_total{cache=\"tag\",result=\"hit\"} " << manager.tag_cache_hits() << "\n";
+    out << "blob_relay_cache_lookups_total{cache=\"tag\",result=\"miss\"} " << manager.tag_cache_misses() << "\n";
+    out << "blob_relay_cache_lookups_total{cache=\"path\",result=\"hit\"} " << manager.paths().hits() << "\n";
+    out << "blob_relay_cache_lookups_total{cache=\"path\",result=\"negative_hit\"} " << manager.paths().negative_hits() << "\n";
+    out << "blob_relay_cache_lookups_total{cache=\"path\",result=\"miss\"} " << manager.paths().misses() << "\n";
+    return out.str();
+}
+
+} // namespace data_relay_grpc::blob_relay
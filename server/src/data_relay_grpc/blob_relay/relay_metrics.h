@@ -0,0 +1,123 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <grpcpp/grpcpp.h>
+
+#include <data_relay_grpc/common/detail/metrics.h>
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+namespace data_relay_grpc::blob_relay {
+
+/**
+ * @brief the RPC methods whose calls are counted
+ */
+enum class rpc_method : std::size_t {
+    streaming_get = 0,
+    streaming_put,
+    local_get,
+    local_put,
+};
+
+/**
+ * @brief the statistics of the RPCs and the BLOB data transferred by the relay
+ * @details the counters and the histograms are updated by the RPC threads without lock, and are summed when retrieved.
+ */
+class relay_metrics {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t method_count = 4;
+    static constexpr std::size_t status_count = 17;  // OK to UNAUTHENTICATED
+
+    /**
+     * @brief records a call of the method finished with the status.
+     */
+    void rpc_finished(rpc_method method, ::grpc::StatusCode code, clock::duration elapsed) noexcept;
+
+    void chunk_received(std::size_t size) noexcept {
+        bytes_in_.add(size);
+        chunk_size_in_.record(size);
+    }
+
+    void chunk_sent(std::size_t size) noexcept {
+        bytes_out_.add(size);
+        chunk_size_out_.record(size);
+    }
+
+    /**
+     * @brief records the time blocked in reading a request from the stream.
+     */
+    void record_read(clock::duration elapsed) noexcept {
+        read_blocked_.record(nanoseconds(elapsed));
+    }
+
+    /**
+     * @brief records the time blocked in writing a response to the stream.
+     */
+    void record_write(clock::duration elapsed) noexcept {
+        write_blocked_.record(nanoseconds(elapsed));
+    }
+
+    [[nodiscard]] std::uint64_t calls(rpc_method method, ::grpc::StatusCode code) const noexcept;
+    [[nodiscard]] common::detail::histogram::snapshot latency(rpc_method method) const;
+    [[nodiscard]] std::uint64_t bytes_in() const noexcept { return bytes_in_.value(); }
+    [[nodiscard]] std::uint64_t bytes_out() const noexcept { return bytes_out_.value(); }
+    [[nodiscard]] common::detail::histogram::snapshot chunk_size_in() const { return chunk_size_in_.take(); }
+    [[nodiscard]] common::detail::histogram::snapshot chunk_size_out() const { return chunk_size_out_.take(); }
+    [[nodiscard]] common::detail::histogram::snapshot read_blocked() const { return read_blocked_.take(); }
+    [[nodiscard]] common::detail::histogram::snapshot write_blocked() const { return write_blocked_.take(); }
+
+    /**
+     * @brief returns the statistics of the relay and the session manager in the Prometheus text exposition format.
+     */
+    [[nodiscard]] std::string prometheus_text(const common::detail::blob_session_manager& manager) const;
+
+    /**
+     * @brief returns the full name of the method, e.g. "BlobRelayStreaming.Get".
+     */
+    [[nodiscard]] static std::string_view method_name(rpc_method method) noexcept;
+
+    /**
+     * @brief returns the name of the status code, e.g. "NOT_FOUND".
+     */
+    [[nodiscard]] static std::string_view status_name(::grpc::StatusCode code) noexcept;
+
+private:
+    struct method_metrics {
+        std::array<common::detail::striped_counter, status_count> calls{};
+        common::detail::histogram latency{};
+    };
+    std::array<method_metrics, method_count> methods_{};
+    common::detail::striped_counter bytes_in_{};
+    common::detail::striped_counter bytes_out_{};
+    common::detail::histogram chunk_size_in_{};
+    common::detail::histogram chunk_size_out_{};
+    common::detail::histogram read_blocked_{};
+    common::detail::histogram write_blocked_{};
+
+    static std::uint64_t nanoseconds(clock::duration d) noexcept {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    }
+};
+
+} // namespace data_relay_grpc::blob_relay
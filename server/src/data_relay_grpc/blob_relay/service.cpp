@@ -36,4 +36,8 @@ common::detail::blob_session_manager& blob_relay_service::get_session_manager()
     return impl_->get_session_manager();
 }
 
+std::string blob_relay_service::metrics_text() const {
+    return impl_->metrics_text();
+}
+
 } // namespace
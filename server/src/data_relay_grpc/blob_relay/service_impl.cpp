@@ -22,6 +22,32 @@
 
 namespace data_relay_grpc::blob_relay {
 
+namespace {
+
+common::detail::session_store_options session_store_options_of(service_configuration const& conf) {
+    common::detail::session_store_options options{};
+    options.deletion_threads = conf.deletion_threads();
+    options.cleanup_threads = conf.cleanup_threads();
+    options.persistent_index = conf.persistent_index();
+    options.session_quota = conf.per_session_quota_size();
+    options.transaction_quota = conf.per_transaction_quota_size();
+    options.admission_wait = conf.quota_wait_time();
+    options.stripe_directories = conf.session_store_stripes();
+    options.placement = static_cast<common::detail::stripe_placement>(conf.session_store_stripe_placement());
+    options.fanout_levels = conf.session_store_fanout_levels();
+    options.segment_size = conf.segment_file_size();
+    options.segment_threshold = conf.segment_threshold();
+    options.memory_tier_budget = conf.memory_tier_size();
+    options.memory_tier_threshold = conf.memory_tier_threshold();
+    options.tag_cache_size = conf.tag_cache_size();
+    options.path_cache_size = conf.path_cache_size();
+    options.path_cache_ttl = conf.path_cache_ttl();
+    options.path_cache_negative_ttl = conf.path_cache_negative_ttl();
+    return options;
+}
+
+} // namespace
+
 #ifdef SMOKE_TEST_SUPPORT
 namespace smoke_test {
 static std::unique_ptr<smoketest_support_service> unqp_smoketest_support_service{};
@@ -31,13 +57,18 @@ static std::unique_ptr<smoketest_support_service> unqp_smoketest_support_service
 blob_relay_service_impl::blob_relay_service_impl(common::api const& api, service_configuration const& conf)
     : api_(api),
       configuration_(conf),
-      session_manager_(api, conf.session_store(), conf.session_quota_size(), conf.dev_accept_mock_tag()),
-      streaming_service_(std::make_unique<streaming_service>(session_manager_, configuration_.stream_chunk_size())) {
+      session_manager_(api, conf.session_store(), conf.session_quota_size(), conf.dev_accept_mock_tag(), session_store_options_of(conf)),
+      streaming_service_(std::make_unique<streaming_service>(session_manager_, configuration_.stream_chunk_size(), metrics_)),
+      stats_service_(std::make_unique<stats_service>(session_manager_, metrics_)) {
     if (streaming_service_) {
         services_.emplace_back(streaming_service_.get());
     }
+    services_.emplace_back(stats_service_.get());
     if (configuration_.local_enabled()) {
-        local_service_ = std::make_unique<local_service>(session_manager_);
+        if (auto socket_path = configuration_.local_socket_path(); !socket_path.empty()) {
+            descriptor_relay_ = std::make_unique<descriptor_relay>(socket_path);
+        }
+        local_service_ = std::make_unique<local_service>(session_manager_, configuration_.local_upload_copy_file(), configuration_.local_upload_placement(), metrics_, descriptor_relay_.get());
         services_.emplace_back(local_service_.get());
     }
 #ifdef SMOKE_TEST_SUPPORT
@@ -59,4 +90,8 @@ common::detail::blob_session_manager& blob_relay_service_impl::get_session_manag
     return session_manager_;
 }
 
+std::string blob_relay_service_impl::metrics_text() const {
+    return metrics_.prometheus_text(session_manager_);
+}
+
 } // namespace
@@ -22,6 +22,8 @@
 
 #include "streaming_service.h"
 #include "local_service.h"
+#include "stats_service.h"
+#include "relay_metrics.h"
 
 namespace data_relay_grpc::blob_relay {
 
@@ -41,12 +43,17 @@ public:
 
     common::detail::blob_session_manager& get_session_manager();
 
+    std::string metrics_text() const;
+
 private:
     common::api api_;
     service_configuration configuration_;
     common::detail::blob_session_manager session_manager_;
+    relay_metrics metrics_{};
     std::unique_ptr<streaming_service> streaming_service_;
+    std::unique_ptr<stats_service> stats_service_;
 
+    std::unique_ptr<descriptor_relay> descriptor_relay_{};
     std::unique_ptr<local_service> local_service_{};
     std::vector<::grpc::Service *> services_{};
 
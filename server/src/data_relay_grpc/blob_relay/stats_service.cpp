@@ -0,0 +1,82 @@
+#include <glog/logging.h>
+
+#include "data_relay_grpc/logging_helper.h"
+#include "data_relay_grpc/logging.h"
+
+#include "stats_service.h"
+#include "utils.h"
+
+namespace data_relay_grpc::blob_relay {
+
+using data_relay_grpc::proto::blob_relay::blob_relay_stats::Histogram;
+
+namespace {
+
+void set_histogram(Histogram* target, const common::detail::histogram::snapshot& s) {
+    target->set_count(s.count);
+    target->set_sum(s.sum);
+    target->set_max(s.max);
+    target->set_p50(s.value_at(50.0));  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+    target->set_p90(s.value_at(90.0));  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+    target->set_p99(s.value_at(99.0));  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+}
+
+} // namespace
+
+stats_service::stats_service(common::detail::blob_session_manager& session_manager, const relay_metrics& metrics)
+    : session_manager_(session_manager), metrics_(metrics) {
+}
+
+::grpc::Status stats_service::GetStats(::grpc::ServerContext*,
+                                       const GetStatsRequest* request,
+                                       GetStatsResponse* response) {
+    if (!check_api_version(request->api_version())) {
+        return ::grpc::Status(::grpc::StatusCode::UNAVAILABLE, api_version_error_message(request->api_version()));
+    }
+
+    for (std::size_t m = 0; m < relay_metrics::method_count; m++) {
+        auto method = static_cast<rpc_method>(m);
+        auto* rpc = response->add_rpcs();
+        rpc->set_method(std::string(relay_metrics::method_name(method)));
+        for (std::size_t c = 0; c < relay_metrics::status_count; c++) {
+            auto code = static_cast<::grpc::StatusCode>(c);
+            if (auto n = metrics_.calls(method, code); n > 0) {
+                (*rpc->mutable_calls())[std::string(relay_metrics::status_name(code))] = n;
+            }
+        }
+        set_histogram(rpc->mutable_latency_ns(), metrics_.latency(method));
+    }
+
+    auto* transfer = response->mutable_transfer();
+    transfer->set_bytes_in(metrics_.bytes_in());
+    transfer->set_bytes_out(metrics_.bytes_out());
+    set_histogram(transfer->mutable_chunk_size_in(), metrics_.chunk_size_in());
+    set_histogram(transfer->mutable_chunk_size_out(), metrics_.chunk_size_out());
+    set_histogram(transfer->mutable_read_blocked_ns(), metrics_.read_blocked());
+    set_histogram(transfer->mutable_write_blocked_ns(), metrics_.write_blocked());
+
+    auto stats = session_manager_.statistics();
+    auto* sessions = response->mutable_sessions();
+    sessions->set_active_sessions(stats.sessions);
+    sessions->set_blobs(stats.blobs);
+    sessions->set_max_blobs_per_session(stats.max_blobs_per_session);
+    sessions->set_store_usage(session_manager_.session_store_current_size());
+    sessions->set_store_quota(session_manager_.session_store_quota());
+    sessions->set_memory_tier_usage(session_manager_.memory_tier_usage());
+    sessions->set_pending_deletions(session_manager_.pending_deletions());
+
+    auto* caches = response->mutable_caches();
+    caches->set_tag_hits(session_manager_.tag_cache_hits());
+    caches->set_tag_misses(session_manager_.tag_cache_misses());
+    caches->set_path_hits(session_manager_.paths().hits());
+    caches->set_path_negative_hits(session_manager_.paths().negative_hits());
+    caches->set_path_misses(session_manager_.paths().misses());
+
+    if (request->prometheus()) {
+        response->set_prometheus_text(metrics_.prometheus_text(session_manager_));
+    }
+    VLOG_LP(log_debug) << "finishes normally";
+    return ::grpc::Status(::grpc::StatusCode::OK, "");
+}
+
+} // namespace data_relay_grpc::blob_relay
@@ -0,0 +1,34 @@
+#pragma once
+#include <grpcpp/grpcpp.h>
+
+#include <data_relay_grpc/common/detail/session_manager.h>
+#include "data_relay_grpc/proto/blob_relay/blob_relay_stats.grpc.pb.h"
+#include "data_relay_grpc/proto/blob_relay/blob_relay_stats.pb.h"
+#include "relay_metrics.h"
+
+namespace data_relay_grpc::blob_relay {
+
+using data_relay_grpc::proto::blob_relay::blob_relay_stats::BlobRelayStats;
+using data_relay_grpc::proto::blob_relay::blob_relay_stats::GetStatsRequest;
+using data_relay_grpc::proto::blob_relay::blob_relay_stats::GetStatsResponse;
+
+class stats_service final : public BlobRelayStats::Service {
+public:
+    stats_service(common::detail::blob_session_manager& session_manager, const relay_metrics& metrics);
+    ~stats_service() override = default;
+
+    stats_service(const stats_service&) = delete;
+    stats_service& operator=(const stats_service&) = delete;
+    stats_service(stats_service&&) = delete;
+    stats_service& operator=(stats_service&&) = delete;
+
+    ::grpc::Status GetStats(::grpc::ServerContext* context,
+                            const GetStatsRequest* request,
+                            GetStatsResponse* response) override;
+
+private:
+    common::detail::blob_session_manager& session_manager_;
+    const relay_metrics& metrics_;
+};
+
+} // namespace data_relay_grpc::blob_relay
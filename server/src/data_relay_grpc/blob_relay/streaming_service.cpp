@@ -1,12 +1,20 @@
+#include <algorithm>
+#include <cerrno>
 #include <fstream>
 #include <optional>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <glog/logging.h>
 
 #include <data_relay_grpc/common/session.h>
+#include <data_relay_grpc/common/detail/trace.h>
 #include "data_relay_grpc/logging_helper.h"
 #include "data_relay_grpc/logging.h"
 
+#include "file_descriptor.h"
 #include "streaming_service.h"
 #include "utils.h"
 
@@ -14,13 +22,56 @@ namespace data_relay_grpc::blob_relay {
 
 using data_relay_grpc::common::blob_session;
 
-streaming_service::streaming_service(common::detail::blob_session_manager& session_manager, std::size_t chunk_size)
-    : session_manager_(session_manager), chunk_size_(chunk_size) {
+streaming_service::streaming_service(common::detail::blob_session_manager& session_manager, std::size_t chunk_size, relay_metrics& metrics)
+    : session_manager_(session_manager), chunk_size_(chunk_size), metrics_(metrics) {
 }
 
 ::grpc::Status streaming_service::Get(::grpc::ServerContext*,
                                       const GetStreamingRequest* request,
                                       ::grpc::ServerWriter< GetStreamingResponse>* writer) {
+    trace_scope_name("BlobRelayStreaming.Get");
+    auto start = relay_metrics::clock::now();
+    auto status = get(request, writer);
+    metrics_.rpc_finished(rpc_method::streaming_get, status.error_code(), relay_metrics::clock::now() - start);
+    return status;
+}
+
+::grpc::Status streaming_service::Put(::grpc::ServerContext* context,
+                                      ::grpc::ServerReader< PutStreamingRequest>* reader,
+                                      PutStreamingResponse* response) {
+    trace_scope_name("BlobRelayStreaming.Put");
+    auto start = relay_metrics::clock::now();
+    auto status = put(context, reader, response);
+    metrics_.rpc_finished(rpc_method::streaming_put, status.error_code(), relay_metrics::clock::now() - start);
+    return status;
+}
+
+bool streaming_service::send(::grpc::ServerWriter< GetStreamingResponse>* writer, const GetStreamingResponse& response) {
+    trace_scope_name("grpc write");
+    trace_scope_value(response.ByteSizeLong());
+    auto start = relay_metrics::clock::now();
+    bool rv = writer->Write(response);
+    metrics_.record_write(relay_metrics::clock::now() - start);
+    if (response.payload_case() == GetStreamingResponse::PayloadCase::kChunk) {
+        metrics_.chunk_sent(response.chunk().size());
+    }
+    return rv;
+}
+
+bool streaming_service::receive(::grpc::ServerReader< PutStreamingRequest>* reader, PutStreamingRequest& request) {
+    trace_scope_name("grpc read");
+    auto start = relay_metrics::clock::now();
+    bool rv = reader->Read(&request);
+    trace_scope_value(request.ByteSizeLong());
+    metrics_.record_read(relay_metrics::clock::now() - start);
+    if (rv && request.payload_case() == PutStreamingRequest::PayloadCase::kChunk) {
+        metrics_.chunk_received(request.chunk().size());
+    }
+    return rv;
+}
+
+::grpc::Status streaming_service::get(const GetStreamingRequest* request,
+                                      ::grpc::ServerWriter< GetStreamingResponse>* writer) {
     if (!check_api_version(request->api_version())) {
         VLOG_LP(log_debug) << "finishes with UNAVAILABLE";
         return ::grpc::Status(::grpc::StatusCode::UNAVAILABLE, api_version_error_message(request->api_version()));
@@ -32,6 +83,7 @@ streaming_service::streaming_service(common::detail::blob_session_manager& sessi
         blob_session::blob_id_type blob_id = request->blob().object_id();
         blob_session::blob_tag_type blob_tag = request->blob().tag();
         bool raw_transaction{};
+        common::detail::blob_session_handle session{};  // pins the session until the BLOB has been sent
         auto storage_id = request->blob().storage_id();
         if (request->context_id_case() == GetStreamingRequest::ContextIdCase::kSessionId) {
             session_id = request->session_id();
@@ -51,8 +103,8 @@ streaming_service::streaming_service(common::detail::blob_session_manager& sessi
         }
 
         if (request->context_id_case() == GetStreamingRequest::ContextIdCase::kTransactionId && !raw_transaction) {
-            auto& session_impl = session_manager_.get_session_impl(session_id);
-            if (auto transaction_id_opt = session_impl.get_transaction_id(); transaction_id_opt) {
+            session = session_manager_.pin_session(session_id);
+            if (auto transaction_id_opt = session->get_transaction_id(); transaction_id_opt) {
                 if (transaction_id_opt.value() != transaction_id.value()) {
                     VLOG_LP(log_debug) << "finishes with PERMISSION_DENIED";
                     return ::grpc::Status(::grpc::StatusCode::PERMISSION_DENIED, "transaction_id does not match with that of the session");
@@ -64,11 +116,20 @@ streaming_service::streaming_service(common::detail::blob_session_manager& sessi
         }
 
         blob_session::blob_path_type path{};
+        std::optional<std::string> packed{};  // the BLOB packed in a segment file, which is sent without its own file
+        file_descriptor fd{};  // the BLOB in a memory file, which is read through a descriptor of its own
         if (storage_id == SESSION_STORAGE_ID) {
             bool succeeded{};
             if (!raw_transaction) {
-                auto& session_impl = session_manager_.get_session_impl(session_id);
-                if (auto path_opt = session_impl.find(blob_id); path_opt) {
+                session = session_manager_.pin_session(session_id);
+                if (packed = session->read_packed(blob_id); packed) {
+                    VLOG_LP(log_debug) << "going to send BLOB packed in a segment file of session storage";
+                    succeeded = true;
+                } else if (auto reopened = session->reopen_descriptor(blob_id); reopened) {
+                    fd.reset(reopened.value());
+                    VLOG_LP(log_debug) << "going to send BLOB in a memory file of session storage";
+                    succeeded = true;
+                } else if (auto path_opt = session->find(blob_id); path_opt) {
                     path = path_opt.value();
                     VLOG_LP(log_debug) << "going to send BLOB from sessin storage: path = " << path.string();
                     succeeded = true;
@@ -79,12 +140,12 @@ streaming_service::streaming_service(common::detail::blob_session_manager& sessi
                 return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "cannot find the blob data by the blob_id given");
             }
         } else if (storage_id == LIMESTONE_BLOB_STORE) {
-            path = session_manager_.get_path(blob_id);
-            std::error_code ec{};
-            if (!std::filesystem::exists(path, ec)) {
+            auto path_opt = session_manager_.find_path(blob_id);
+            if (!path_opt) {
                 VLOG_LP(log_debug) << "finishes with NOT_FOUND";
                 return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "cannot find the blob data by the blob_id given");
             }
+            path = std::move(path_opt.value());
             VLOG_LP(log_debug) << "going to send BLOB from limestone blob store: path = " << path.string();
         } else {
             VLOG_LP(log_debug) << "finishes with INVALID_ARGUMENT";
@@ -92,63 +153,94 @@ streaming_service::streaming_service(common::detail::blob_session_manager& sessi
         }
 
         // should be done after confirming the blob's existence
-        blob_session::blob_tag_type expected_tag{};
-        if (transaction_id) {
-            expected_tag = session_manager_.get_tag(blob_id, transaction_id.value());
-        } else {
-            auto& session_impl = session_manager_.get_session_impl(session_id);
-            expected_tag = session_impl.get_tag(blob_id);
-        }
-        if (expected_tag != blob_tag) {
-            if (!session_manager_.dev_accept_mock_tag() || blob_tag != common::detail::blob_session_manager::MOCK_TAG) {
-                VLOG_LP(log_debug) << "finishes with PERMISSION_DENIED";
-                return ::grpc::Status(::grpc::StatusCode::PERMISSION_DENIED, "the given tag does not match the desiring value");
+        {
+            trace_scope_name("verify tag");
+            blob_session::blob_tag_type expected_tag{};
+            if (transaction_id) {
+                expected_tag = session_manager_.get_tag(blob_id, transaction_id.value());
+            } else {
+                if (!session) {
+                    session = session_manager_.pin_session(session_id);
+                }
+                expected_tag = session->get_tag(blob_id);
+            }
+            if (expected_tag != blob_tag) {
+                if (!session_manager_.dev_accept_mock_tag() || blob_tag != common::detail::blob_session_manager::MOCK_TAG) {
+                    trace_event("tag mismatch");
+                    VLOG_LP(log_debug) << "finishes with PERMISSION_DENIED";
+                    return ::grpc::Status(::grpc::StatusCode::PERMISSION_DENIED, "the given tag does not match the desiring value");
+                }
             }
         }
 
-        if (std::filesystem::exists(path)) {
-            VLOG_LP(log_trace) << "start to send BLOB";
+        if (packed) {
             GetStreamingResponse response{};
-
-            // metadata
-            auto* metadata = response.mutable_metadata();
-            metadata->set_blob_size(std::filesystem::file_size(path));
-            writer->Write(response);
-            VLOG_LP(log_trace) << "send metadata done";
-
-            // chunk
+            response.mutable_metadata()->set_blob_size(packed->size());
+            send(writer, response);
             response.clear_metadata();
-            std::ifstream ifs(path);
-            std::string s{};
-            s.resize(chunk_size_);
-            while (true) {
-                ifs.read(s.data(), s.length());
-                auto size = ifs.gcount();
-                if (size == 0) {
-                    VLOG_LP(log_trace) << "send chunk done";
-                    return ::grpc::Status(::grpc::StatusCode::OK, "");
-                }
-                response.set_chunk(s.data(), size);
-                writer->Write(response);
-                VLOG_LP(log_trace) << "send chunk, size = " << chunk_size_;
+            for (std::size_t offset = 0; offset < packed->size(); offset += chunk_size_) {
+                response.set_chunk(packed->data() + offset, std::min(chunk_size_, packed->size() - offset));  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                send(writer, response);
             }
             VLOG_LP(log_debug) << "finishes normally";
             return ::grpc::Status(::grpc::StatusCode::OK, "");
-        } else {
+        }
+
+        // the file is opened once so that the size and the data sent are of the same file
+        if (!fd) {
+            fd.reset(::open(path.c_str(), O_RDONLY | O_CLOEXEC));  // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg, hicpp-signed-bitwise)
+        }
+        struct stat st{};
+        if (!fd || ::fstat(fd.get(), &st) != 0) {
             VLOG_LP(log_debug) << "finishes with NOT_FOUND";
             return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "an error occurred while reading the blob file");
         }
+        VLOG_LP(log_trace) << "start to send BLOB";
+        GetStreamingResponse response{};
+
+        // metadata
+        auto* metadata = response.mutable_metadata();
+        metadata->set_blob_size(st.st_size);
+        send(writer, response);
+        VLOG_LP(log_trace) << "send metadata done";
+
+        // chunk
+        response.clear_metadata();
+        std::string s{};
+        s.resize(chunk_size_);
+        while (true) {
+            ssize_t size{};
+            {
+                trace_scope_name("disk read");
+                size = ::read(fd.get(), s.data(), s.length());
+                trace_scope_value(size);
+            }
+            if (size < 0 && errno == EINTR) {
+                continue;
+            }
+            if (size < 0) {
+                VLOG_LP(log_debug) << "finishes with INTERNAL";
+                return ::grpc::Status(::grpc::StatusCode::INTERNAL, "an error occurred while reading the blob file");
+            }
+            if (size == 0) {
+                VLOG_LP(log_debug) << "finishes normally";
+                return ::grpc::Status(::grpc::StatusCode::OK, "");
+            }
+            response.set_chunk(s.data(), size);
+            send(writer, response);
+            VLOG_LP(log_trace) << "send chunk, size = " << size;
+        }
     } catch (std::exception &ex) {
         VLOG_LP(log_debug) << "finishes with INTERNAL";
         return ::grpc::Status(::grpc::StatusCode::INTERNAL, ex.what());
     }
 }
 
-::grpc::Status streaming_service::Put(::grpc::ServerContext*,
+::grpc::Status streaming_service::put(::grpc::ServerContext* context,
                                       ::grpc::ServerReader< PutStreamingRequest>* reader,
                                       PutStreamingResponse* response) {
     PutStreamingRequest request;
-    if (!reader->Read(&request)) {
+    if (!receive(reader, request)) {
         VLOG_LP(log_debug) << "finishes with INVALID_ARGUMENT";
         return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, "no request");
     }
@@ -167,40 +259,109 @@ streaming_service::streaming_service(common::detail::blob_session_manager& sessi
         blob_size_opt = metadata.blob_size();
     }
     try {
-        auto& session_impl = session_manager_.get_session_impl(request.metadata().session_id());
-        auto pair = session_impl.create_blob_file();
-        blob_session::blob_id_type blob_id = pair.first;
-        VLOG_LP(log_debug) << "accepted request: session_id = " << request.metadata().session_id() << ", to be create a blob file with blob_id = " << blob_id << " of session storage";
-
-        std::ofstream blob_file(pair.second);
-        if (!blob_file.is_open()) {
-            VLOG_LP(log_debug) << "finishes with FAILED_PRECONDITION";
-            return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "cannot open the file to write the blob to");
-        }
+        auto session = session_manager_.pin_session(request.metadata().session_id());
+        auto& session_impl = *session;
+        VLOG_LP(log_debug) << "accepted request: session_id = " << request.metadata().session_id() << ", to be create a blob of session storage";
+
+        // a small BLOB is buffered to be kept in the memory tier or packed in a segment file,
+        // and is written to its own file once it exceeds the thresholds
+        auto small_blob_threshold = std::max(session_manager_.memory_tier_threshold(), session_manager_.segment_threshold());
+        bool buffering = small_blob_threshold > 0 && (!blob_size_opt || blob_size_opt.value() <= small_blob_threshold);
+        std::string buffer{};
+        std::optional<std::pair<blob_session::blob_id_type, std::filesystem::path>> pair{};
+        std::ofstream blob_file{};
+        auto write = [&](const std::string& data) -> std::optional<::grpc::Status> {
+            if (!pair) {
+                pair = session_impl.create_blob_file();
+                VLOG_LP(log_debug) << "created a blob file with blob_id = " << pair->first;
+                blob_file.open(pair->second);
+                if (!blob_file.is_open()) {
+                    session_impl.delete_blob_file(pair->first);
+                    VLOG_LP(log_debug) << "finishes with FAILED_PRECONDITION";
+                    return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "cannot open the file to write the blob to");
+                }
+            }
+            if (auto exceeded = session_impl.try_reserve_session_store(pair->first, data.size(), context->deadline()); exceeded != common::detail::quota_level::none) {
+                blob_file.close();
+                session_impl.delete_blob_file(pair->first);
+                VLOG_LP(log_debug) << "finishes with RESOURCE_EXHAUSTED";
+                return ::grpc::Status(::grpc::StatusCode::RESOURCE_EXHAUSTED, std::string(common::detail::quota_exceeded_message(exceeded)));
+            }
+            trace_scope_name("disk write");
+            trace_scope_value(data.size());
+            blob_file.write(data.data(), static_cast<std::streamsize>(data.size()));
+            return std::nullopt;
+        };
+
         std::size_t total_size{};
-        while (reader->Read(&request)) {
+        while (receive(reader, request)) {
             if (request.payload_case() != PutStreamingRequest::PayloadCase::kChunk) {
+                if (pair) {
+                    blob_file.close();
+                    session_impl.delete_blob_file(pair->first);
+                }
                 VLOG_LP(log_debug) << "finishes with INVALID_ARGUMENT";
                 return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, "A subsequent requests is not chunk");
             }
             auto& chunk = request.chunk();
-            if (!session_impl.reserve_session_store(blob_id, chunk.size())) {
+            total_size += chunk.size();
+            if (buffering && total_size <= small_blob_threshold) {
+                buffer.append(chunk);
+                continue;
+            }
+            if (buffering) {
+                buffering = false;
+                if (auto status = write(buffer); status) {
+                    return status.value();
+                }
+                buffer = std::string{};
+            }
+            if (auto status = write(chunk); status) {
+                return status.value();
+            }
+        }
+        if (blob_size_opt && blob_size_opt.value() != total_size) {
+            if (pair) {
                 blob_file.close();
-                session_impl.delete_blob_file(blob_id);
+                session_impl.delete_blob_file(pair->first);
+            }
+            VLOG_LP(log_debug) << "finishes with INVALID_ARGUMENT";
+            return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, "the size in the metadata does not match the size of the sent blob");
+        }
+
+        blob_session::blob_id_type blob_id{};
+        bool small_blob{};
+        if (buffering) {
+            common::detail::quota_level exceeded{};
+            auto blob_id_opt = session_impl.add_memory_blob(buffer, exceeded);
+            if (blob_id_opt) {
+                VLOG_LP(log_debug) << "finishes blob reception in the memory tier, blob_id = " << blob_id_opt.value();
+            } else if (exceeded == common::detail::quota_level::none) {
+                blob_id_opt = session_impl.add_packed_blob(buffer, exceeded);
+                if (blob_id_opt) {
+                    VLOG_LP(log_debug) << "finishes blob reception in a segment file, blob_id = " << blob_id_opt.value();
+                }
+            }
+            if (blob_id_opt) {
+                blob_id = blob_id_opt.value();
+                small_blob = true;
+            } else if (exceeded != common::detail::quota_level::none) {
                 VLOG_LP(log_debug) << "finishes with RESOURCE_EXHAUSTED";
-                return ::grpc::Status(::grpc::StatusCode::RESOURCE_EXHAUSTED, "session storage usage has reached its limit");
+                return ::grpc::Status(::grpc::StatusCode::RESOURCE_EXHAUSTED, std::string(common::detail::quota_exceeded_message(exceeded)));
+            } else if (auto status = write(buffer); status) {  // not accepted as a small BLOB, and thus spilled to a file
+                return status.value();
             }
-            blob_file.write(chunk.data(), chunk.size());
-            total_size += chunk.size();
         }
-        blob_file.close();
-        VLOG_LP(log_debug) << "finishes blob file reception, blob_id = " << blob_id;
-        if (blob_size_opt) {
-            if (blob_size_opt.value() != total_size) {
-                std::filesystem::remove(pair.second);
-                VLOG_LP(log_debug) << "finishes with INVALID_ARGUMENT";
-                return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, "the size in the metadata does not match the size of the sent blob");
+        if (!small_blob) {
+            if (!pair) {  // no chunk has been sent
+                if (auto status = write(std::string{}); status) {
+                    return status.value();
+                }
             }
+            blob_file.close();
+            blob_id = pair->first;
+            VLOG_LP(log_debug) << "finishes blob file reception, blob_id = " << blob_id;
+            session_impl.complete_blob_file(blob_id);
         }
 
         auto* blob = response->mutable_blob();
@@ -6,6 +6,7 @@
 #include <data_relay_grpc/common/detail/session_manager.h>
 #include "data_relay_grpc/proto/blob_relay/blob_relay_streaming.grpc.pb.h"
 #include "data_relay_grpc/proto/blob_relay/blob_relay_streaming.pb.h"
+#include "relay_metrics.h"
    
 namespace data_relay_grpc::blob_relay {
 
@@ -19,7 +20,7 @@ using data_relay_grpc::proto::blob_relay::blob_relay_streaming::GetStreamingResp
 
 class streaming_service final : public BlobRelayStreaming::Service {
 public:
-    streaming_service(common::detail::blob_session_manager& session_manager, std::size_t chunk_size);
+    streaming_service(common::detail::blob_session_manager& session_manager, std::size_t chunk_size, relay_metrics& metrics);
     ~streaming_service() override = default;
 
     streaming_service(const streaming_service&) = delete;
@@ -38,6 +39,7 @@ public:
 private:
     common::detail::blob_session_manager& session_manager_;
     std::size_t chunk_size_;
+    relay_metrics& metrics_;
     constexpr static std::uint64_t SESSION_STORAGE_ID = 0;
     constexpr static std::uint64_t LIMESTONE_BLOB_STORE = 1;
 
@@ -45,6 +47,19 @@ private:
         using namespace std::string_view_literals;
         return sid == SESSION_STORAGE_ID ? "session storage"sv : "limestone blob store"sv;
     }
+
+    ::grpc::Status get(const GetStreamingRequest* request,
+                       ::grpc::ServerWriter< GetStreamingResponse>* writer);
+
+    ::grpc::Status put(::grpc::ServerContext* context,
+                       ::grpc::ServerReader< PutStreamingRequest>* reader,
+                       PutStreamingResponse* response);
+
+    // writes the response, recording the time blocked and the size of the chunk
+    bool send(::grpc::ServerWriter< GetStreamingResponse>* writer, const GetStreamingResponse& response);
+
+    // reads the request, recording the time blocked and the size of the chunk
+    bool receive(::grpc::ServerReader< PutStreamingRequest>* reader, PutStreamingRequest& request);
 };
 
 } // namespace data_relay_grpc::blob_relay
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+#include "data_relay_grpc/logging_helper.h"
+#include "data_relay_grpc/logging.h"
+
+#include <data_relay_grpc/common/detail/blob_reclaimer.h>
+
+namespace data_relay_grpc::common::detail {
+
+blob_reclaimer::blob_reclaimer(std::size_t threads) {
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; i++) {
+        workers_.emplace_back([this]{ run(); });
+    }
+}
+
+blob_reclaimer::~blob_reclaimer() {
+    stop_sweep_ = true;
+    if (sweeper_.joinable()) {
+        sweeper_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto&& e : workers_) {
+        if (e.joinable()) {
+            e.join();
+        }
+    }
+}
+
+void blob_reclaimer::remove(std::filesystem::path path) {
+    if (workers_.empty()) {
+        unlink(path);
+        deleted_++;
+        return;
+    }
+    pending_++;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        queue_.emplace_back(std::move(path));
+    }
+    cv_.notify_one();
+}
+
+void blob_reclaimer::remove(std::vector<std::filesystem::path> paths) {
+    if (paths.empty()) {
+        return;
+    }
+    if (workers_.empty()) {
+        for (auto&& e : paths) {
+            unlink(e);
+        }
+        deleted_ += paths.size();
+        return;
+    }
+    pending_ += paths.size();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto&& e : paths) {
+            queue_.emplace_back(std::move(e));
+        }
+    }
+    cv_.notify_all();
+    VLOG_LP(log_debug) << paths.size() << " files are queued for deletion, pending = " << pending_.load();
+}
+
+void blob_reclaimer::sweep(std::vector<std::filesystem::path> directories, std::function<bool(const std::filesystem::path&)> pred) {
+    if (workers_.empty()) {
+        remove(scan(directories, pred));
+        return;
+    }
+    if (sweeper_.joinable()) {
+        sweeper_.join();
+    }
+    pending_++;  // until the scan finishes
+    sweeper_ = std::thread([this, directories = std::move(directories), pred = std::move(pred)]{
+        auto paths = scan(directories, pred);
+        VLOG_LP(log_info) << "found " << paths.size() << " files to delete in sweeping " << directories.size() << " directories";
+        remove(std::move(paths));
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (pending_.fetch_sub(1) == 1) {
+            idle_cv_.notify_all();
+        }
+    });
+}
+
+std::vector<std::filesystem::path> blob_reclaimer::scan(const std::vector<std::filesystem::path>& directories, const std::function<bool(const std::filesystem::path&)>& pred) {
+    std::vector<std::filesystem::path> rv{};
+    for (auto&& directory : directories) {
+        std::error_code ec{};
+        for (std::filesystem::recursive_directory_iterator itr(directory, ec), end{}; !ec && itr != end && !stop_sweep_; itr.increment(ec)) {
+            const auto& e = *itr;
+            if (e.path().filename().string().front() == '.' && e.is_directory(ec)) {
+                itr.disable_recursion_pending();
+                continue;
+            }
+            if (!e.is_directory(ec) && pred(e.path())) {
+                rv.emplace_back(e.path());
+            }
+        }
+        if (ec) {
+            LOG_LP(ERROR) << "cannot scan " << directory.string() << ": " << ec.message();
+        }
+    }
+    return rv;
+}
+
+void blob_reclaimer::wait_idle() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    idle_cv_.wait(lock, [this]{ return pending_.load() == 0; });
+}
+
+void blob_reclaimer::run() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (true) {
+        cv_.wait(lock, [this]{ return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;  // stopping after all pending files are deleted
+        }
+        auto path = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        unlink(path);
+        lock.lock();
+        done(1);
+    }
+}
+
+void blob_reclaimer::unlink(const std::filesystem::path& path) {
+    std::error_code ec{};
+    if (!std::filesystem::remove(path, ec) && ec) {  // maybe blob file has been moved
+        LOG_LP(ERROR) << "cannot delete " << path.string() << ": " << ec.message();
+    }
+}
+
+void blob_reclaimer::done(std::size_t count) {
+    deleted_ += count;
+    if (pending_.fetch_sub(count) == count) {
+        idle_cv_.notify_all();
+    }
+}
+
+} // namespace
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <data_relay_grpc/common/detail/metrics.h>
+
+namespace data_relay_grpc::common::detail {
+
+std::size_t metric_stripe(std::size_t stripes) noexcept {
+    static std::atomic<std::size_t> next{};
+    thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index & (stripes - 1);
+}
+
+std::size_t histogram::bucket_of(std::uint64_t value) noexcept {
+    if (value < sub_buckets) {
+        return static_cast<std::size_t>(value);
+    }
+    auto msb = static_cast<std::size_t>(63 - __builtin_clzll(value));  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+    auto shift = msb - sub_bucket_bits;
+    auto mantissa = static_cast<std::size_t>(value >> shift) & (sub_buckets - 1);
+    return ((shift + 1) << sub_bucket_bits) + mantissa;
+}
+
+std::uint64_t histogram::upper_bound(std::size_t bucket) noexcept {
+    if (bucket < sub_buckets) {
+        return bucket;
+    }
+    auto shift = (bucket >> sub_bucket_bits) - 1;
+    auto mantissa = static_cast<std::uint64_t>(bucket & (sub_buckets - 1));
+    auto lower = (sub_buckets + mantissa) << shift;
+    return lower + ((std::uint64_t{1} << shift) - 1);
+}
+
+void histogram::record(std::uint64_t value) noexcept {
+    auto& s = stripes_[metric_stripe(stripes)];  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    s.buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    s.sum.fetch_add(value, std::memory_order_relaxed);
+    auto max = s.max.load(std::memory_order_relaxed);
+    while (value > max && !s.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+histogram::snapshot histogram::take() const {
+    snapshot rv{};
+    rv.buckets.resize(bucket_count);
+    for (auto&& s : stripes_) {
+        for (std::size_t i = 0; i < bucket_count; i++) {
+            auto n = s.buckets[i].load(std::memory_order_relaxed);  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            rv.buckets[i] += n;
+            rv.count += n;
+        }
+        rv.sum += s.sum.load(std::memory_order_relaxed);
+        rv.max = std::max(rv.max, s.max.load(std::memory_order_relaxed));
+    }
+    return rv;
+}
+
+std::uint64_t histogram::snapshot::value_at(double percentile) const noexcept {
+    if (count == 0) {
+        return 0;
+    }
+    auto rank = static_cast<std::uint64_t>(std::ceil(static_cast<double>(count) * std::clamp(percentile, 0.0, 100.0) / 100.0));  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+    rank = std::max<std::uint64_t>(rank, 1);
+    std::uint64_t seen{};
+    for (std::size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(upper_bound(i), max);
+        }
+    }
+    return max;
+}
+
+} // namespace
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iterator>
+#include <utility>
+
+#include <data_relay_grpc/common/detail/path_cache.h>
+
+namespace data_relay_grpc::common::detail {
+
+path_cache::path_cache(std::size_t capacity, std::chrono::milliseconds ttl, std::chrono::milliseconds negative_ttl)
+    : capacity_(capacity), shard_capacity_((capacity + shard_count - 1) / shard_count), ttl_(ttl), negative_ttl_(negative_ttl) {
+}
+
+path_cache::shard& path_cache::shard_for(blob_id_type blob_id) noexcept {
+    // Fibonacci hashing, as the IDs are mostly sequential
+    constexpr std::uint64_t multiplier = 0x9e3779b97f4a7c15ULL;
+    auto index = static_cast<std::size_t>((blob_id * multiplier) >> 32U) & (shard_count - 1);  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+    return shards_[index];  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+}
+
+std::optional<path_cache::entry> path_cache::find(blob_id_type blob_id) {
+    if (!enabled()) {
+        return std::nullopt;
+    }
+    auto now = clock::now();
+    auto& s = shard_for(blob_id);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    if (auto itr = s.entries.find(blob_id); itr != s.entries.end()) {
+        if (itr->second.expires > now) {
+            (itr->second.value.exists ? s.hits : s.negative_hits)++;
+            return itr->second.value;
+        }
+        s.entries.erase(itr);
+    }
+    s.misses++;
+    return std::nullopt;
+}
+
+void path_cache::insert(blob_id_type blob_id, entry e) {
+    if (!enabled()) {
+        return;
+    }
+    auto now = clock::now();
+    auto expires = now + (e.exists ? ttl_ : negative_ttl_);
+    auto& s = shard_for(blob_id);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    if (auto itr = s.entries.find(blob_id); itr != s.entries.end()) {
+        itr->second = cached{std::move(e), expires};
+        return;
+    }
+    if (s.entries.size() >= shard_capacity_) {
+        for (auto itr = s.entries.begin(); itr != s.entries.end(); ) {
+            itr = itr->second.expires <= now ? s.entries.erase(itr) : std::next(itr);
+        }
+        if (s.entries.size() >= shard_capacity_) {
+            s.entries.erase(s.entries.begin());
+        }
+    }
+    s.entries.emplace(blob_id, cached{std::move(e), expires});
+}
+
+template <class F>
+std::uint64_t path_cache::sum(F&& f) const {
+    std::uint64_t rv{};
+    for (auto&& s : shards_) {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        rv += f(s);
+    }
+    return rv;
+}
+
+std::uint64_t path_cache::hits() const {
+    return sum([](const shard& s){ return s.hits; });
+}
+
+std::uint64_t path_cache::negative_hits() const {
+    return sum([](const shard& s){ return s.negative_hits; });
+}
+
+std::uint64_t path_cache::misses() const {
+    return sum([](const shard& s){ return s.misses; });
+}
+
+std::size_t path_cache::size() const {
+    return sum([](const shard& s){ return static_cast<std::uint64_t>(s.entries.size()); });
+}
+
+} // namespace
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <data_relay_grpc/common/detail/quota_accountant.h>
+
+namespace data_relay_grpc::common::detail {
+
+quota_accountant::quota_accountant(std::size_t quota, std::size_t lease_unit) noexcept
+    : quota_(quota), lease_unit_(lease_unit) {
+}
+
+quota_accountant::slab& quota_accountant::local_slab() noexcept {
+    // each thread is assigned a slab in turn, which is shared with few other threads
+    static std::atomic<std::size_t> next{};
+    thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % slab_count;
+    return slabs_.at(index);
+}
+
+bool quota_accountant::near_limit() const noexcept {
+    auto leased = leased_.load(std::memory_order_relaxed);
+    return leased >= quota_ || quota_ - leased < slab_count * lease_unit_;
+}
+
+bool quota_accountant::lease(std::size_t amount) noexcept {
+    auto leased = leased_.load(std::memory_order_relaxed);
+    while (true) {
+        if (leased > quota_ || amount > quota_ - leased) {
+            return false;
+        }
+        if (leased_.compare_exchange_weak(leased, leased + amount, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+bool quota_accountant::take(slab& s, std::size_t size) noexcept {
+    auto available = s.available.load(std::memory_order_relaxed);
+    while (available >= size) {
+        if (s.available.compare_exchange_weak(available, available - size, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void quota_accountant::drain() noexcept {
+    for (auto&& s : slabs_) {
+        if (auto available = s.available.exchange(0, std::memory_order_relaxed); available > 0) {
+            leased_.fetch_sub(available, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool quota_accountant::reserve(std::size_t size) noexcept {
+    if (quota_ == 0) {
+        return true;
+    }
+    auto& s = local_slab();
+    if (take(s, size)) {
+        return true;
+    }
+    if (!near_limit()) {
+        // lease a new slab including this reservation
+        if (lease(size + lease_unit_)) {
+            s.available.fetch_add(lease_unit_, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    if (lease(size)) {
+        return true;
+    }
+    // the quota held by the slabs may be enough
+    drain();
+    return lease(size);
+}
+
+void quota_accountant::release(std::size_t size) noexcept {
+    if (quota_ == 0) {
+        return;
+    }
+    if (near_limit()) {
+        leased_.fetch_sub(size, std::memory_order_relaxed);
+        return;
+    }
+    auto& s = local_slab();
+    auto available = s.available.fetch_add(size, std::memory_order_relaxed) + size;
+    if (available > 2 * lease_unit_) {
+        // return the excess to the budget, keeping a unit for the following reservations
+        if (take(s, available - lease_unit_)) {
+            leased_.fetch_sub(available - lease_unit_, std::memory_order_relaxed);
+        }
+    }
+}
+
+void quota_accountant::restore(std::size_t size) noexcept {
+    if (quota_ != 0) {
+        leased_.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+std::size_t quota_accountant::used() const noexcept {
+    std::size_t available{};
+    for (auto&& s : slabs_) {
+        available += s.available.load(std::memory_order_relaxed);
+    }
+    auto leased = leased_.load(std::memory_order_relaxed);
+    return leased > available ? leased - available : 0;
+}
+
+} // namespace
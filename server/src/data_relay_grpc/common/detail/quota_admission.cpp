@@ -0,0 +1,69 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include <data_relay_grpc/common/detail/quota_admission.h>
+
+namespace data_relay_grpc::common::detail {
+
+bool quota_admission::wait(const std::function<bool()>& try_reserve, clock::time_point deadline) {
+    auto start = clock::now();
+    std::unique_lock<std::mutex> lock(mtx_);
+    auto ticket = next_ticket_++;
+    queue_.emplace_back(ticket);
+    waiting_ = queue_.size();
+    if (queue_.size() > max_waiting_.load()) {
+        max_waiting_ = queue_.size();
+    }
+    ++waits_;
+
+    bool reserved = false;
+    while (true) {
+        // usage released after this check is notified under the lock, and thus is not missed
+        if (queue_.front() == ticket && try_reserve()) {
+            reserved = true;
+            break;
+        }
+        if (cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+            reserved = queue_.front() == ticket && try_reserve();
+            break;
+        }
+    }
+    queue_.erase(std::find(queue_.begin(), queue_.end(), ticket));
+    waiting_ = queue_.size();
+    if (!reserved) {
+        ++timeouts_;
+    }
+    wait_time_ += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+    lock.unlock();
+
+    // the next reservation may be satisfied by the rest of the usage released
+    cv_.notify_all();
+    return reserved;
+}
+
+void quota_admission::notify() {
+    if (waiting_.load() == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+    }
+    cv_.notify_all();
+}
+
+} // namespace
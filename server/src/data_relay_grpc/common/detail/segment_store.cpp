@@ -0,0 +1,268 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+#include "data_relay_grpc/logging_helper.h"
+#include "data_relay_grpc/logging.h"
+
+#include <data_relay_grpc/common/detail/segment_store.h>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief a segment file, which is closed when no reader refers to it
+ */
+struct segment_store::segment {
+    std::uint64_t id{};
+    std::filesystem::path path{};
+    int fd{-1};
+    std::uint64_t end{};    // the size of the BLOBs appended, including those being written
+    std::size_t live{};     // the size of the BLOBs not removed
+    bool sealed{};          // whether no BLOB is appended any more
+    std::unordered_set<key_type> keys{};
+
+    segment() = default;
+    ~segment() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    segment(const segment&) = delete;
+    segment& operator=(const segment&) = delete;
+    segment(segment&&) = delete;
+    segment& operator=(segment&&) = delete;
+};
+
+namespace {
+
+bool write_at(int fd, const char* data, std::size_t size, std::uint64_t offset) {
+    while (size > 0) {
+        auto n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+    return true;
+}
+
+bool read_at(int fd, char* data, std::size_t size, std::uint64_t offset) {
+    while (size > 0) {
+        auto n = ::pread(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+segment_store::segment_store(std::filesystem::path directory, std::size_t segment_size)
+    : directory_(std::move(directory)), segment_size_(segment_size) {
+    std::error_code ec{};
+    std::filesystem::remove_all(directory_, ec);
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        throw std::runtime_error("cannot create the segment directory (" + directory_.string() + "): " + ec.message());
+    }
+}
+
+std::optional<segment_store::location> segment_store::reserve(std::size_t length) {
+    if (!active_ || (active_->end > 0 && active_->end + length > segment_size_)) {
+        if (active_) {
+            active_->sealed = true;
+            if (active_->live == 0) {
+                ::unlink(active_->path.c_str());
+                segments_.erase(active_->id);
+            }
+        }
+        auto seg = std::make_shared<segment>();
+        seg->id = next_segment_id_++;
+        seg->path = directory_ / ("segment_" + std::to_string(seg->id));
+        seg->fd = ::open(seg->path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);  // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg, hicpp-signed-bitwise)
+        if (seg->fd < 0) {
+            LOG_LP(ERROR) << "cannot create the segment file (" << seg->path.string() << "): " << std::strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+            active_.reset();
+            return std::nullopt;
+        }
+        segments_.emplace(seg->id, seg);
+        active_ = std::move(seg);
+    }
+    location rv{active_, active_->end, length};
+    active_->end += length;
+    active_->live += length;
+    return rv;
+}
+
+void segment_store::release(const location& loc) {
+    auto& seg = *loc.seg;
+    seg.live -= loc.length;
+    if (seg.sealed && seg.live == 0) {
+        // the file is closed when no reader refers to it
+        ::unlink(seg.path.c_str());
+        segments_.erase(seg.id);
+    }
+}
+
+bool segment_store::append(key_type key, std::string_view data) {
+    std::optional<location> loc{};
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        loc = reserve(data.size());
+    }
+    if (!loc) {
+        return false;
+    }
+    // BLOBs are written concurrently to the regions reserved
+    bool written = write_at(loc->seg->fd, data.data(), data.size(), loc->offset);
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!written) {
+        LOG_LP(ERROR) << "cannot write to the segment file (" << loc->seg->path.string() << "): " << std::strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+        release(loc.value());
+        return false;
+    }
+    loc->seg->keys.emplace(key);
+    index_.emplace(key, std::move(loc.value()));
+    return true;
+}
+
+std::optional<std::string> segment_store::read(key_type key) const {
+    location loc{};
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto itr = index_.find(key);
+        if (itr == index_.end()) {
+            return std::nullopt;
+        }
+        loc = itr->second;
+    }
+    std::string rv(loc.length, '\0');
+    if (!read_at(loc.seg->fd, rv.data(), rv.size(), loc.offset)) {
+        LOG_LP(ERROR) << "cannot read from the segment file (" << loc.seg->path.string() << "): " << std::strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+        return std::nullopt;
+    }
+    return rv;
+}
+
+bool segment_store::remove(key_type key) {
+    std::shared_ptr<segment> to_compact{};
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto itr = index_.find(key);
+        if (itr == index_.end()) {
+            return false;
+        }
+        auto loc = std::move(itr->second);
+        index_.erase(itr);
+        loc.seg->keys.erase(key);
+        release(loc);
+        // the segment less than half used is compacted by one thread at a time
+        if (loc.seg->sealed && loc.seg->live > 0 && loc.seg->live * 2 < loc.seg->end && !compacting_.exchange(true)) {
+            to_compact = loc.seg;
+        }
+    }
+    if (to_compact) {
+        compact(to_compact);
+        compacting_ = false;
+    }
+    return true;
+}
+
+void segment_store::compact(const std::shared_ptr<segment>& seg) {
+    std::vector<std::pair<key_type, location>> entries{};
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        entries.reserve(seg->keys.size());
+        for (auto key : seg->keys) {
+            entries.emplace_back(key, index_.at(key));
+        }
+    }
+    std::size_t moved{};
+    for (auto&& [key, old] : entries) {
+        std::string data(old.length, '\0');
+        if (!read_at(old.seg->fd, data.data(), data.size(), old.offset)) {
+            continue;
+        }
+        std::optional<location> loc{};
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            loc = reserve(old.length);
+        }
+        if (!loc) {
+            return;
+        }
+        bool written = write_at(loc->seg->fd, data.data(), data.size(), loc->offset);
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto itr = index_.find(key);
+        if (!written || itr == index_.end() || itr->second.seg != old.seg || itr->second.offset != old.offset) {
+            release(loc.value());  // removed while being moved
+            continue;
+        }
+        loc->seg->keys.emplace(key);
+        itr->second = std::move(loc.value());
+        old.seg->keys.erase(key);
+        release(old);
+        moved++;
+    }
+    VLOG_LP(log_debug) << "compacted the segment file (" << seg->path.string() << "), moving " << moved << " BLOBs";
+}
+
+std::size_t segment_store::segment_count() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return segments_.size();
+}
+
+std::size_t segment_store::live_size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::size_t rv{};
+    for (auto&& [id, seg] : segments_) {
+        rv += seg->live;
+    }
+    return rv;
+}
+
+std::size_t segment_store::file_size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::size_t rv{};
+    for (auto&& [id, seg] : segments_) {
+        rv += seg->end;
+    }
+    return rv;
+}
+
+} // namespace
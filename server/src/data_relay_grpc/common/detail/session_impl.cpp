@@ -14,39 +14,218 @@
  * limitations under the License.
  */
 
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
 #include <glog/logging.h>
 #include "data_relay_grpc/logging_helper.h"
 #include "data_relay_grpc/logging.h"
 
 #include <data_relay_grpc/common/detail/session_manager.h>
 #include <data_relay_grpc/common/detail/session_impl.h>
+#include <data_relay_grpc/common/detail/trace.h>
 
 namespace data_relay_grpc::common::detail {
 
+blob_session_impl::~blob_session_impl() {
+    std::vector<blob_path_type> paths{};
+    std::vector<std::size_t> sizes(session_store_.stripe_count());
+    std::size_t memory_size{};
+    blobs_.for_each([this, &paths, &sizes, &memory_size](blob_id_type bid, blob_entry& e) {
+        if (e.fd >= 0) {
+            ::close(e.fd);
+        } else if (e.packed) {
+            session_store_.segments()->remove(bid);  // the segment files are not kept after restart
+        } else if (disposed_) {
+            paths.emplace_back(path_of(bid, e));
+        }
+        (e.memory_tier ? memory_size : sizes.at(e.stripe)) += e.size;
+        if (e.external != nullptr) {
+            manager_.path_arena_.release(e.external);
+        }
+    });
+    if (disposed_) {
+        release_quota(sizes, memory_size);  // decrease session storage usage counter
+    }
+    manager_.reclaimer_.remove(std::move(paths));
+    if (transaction_usage_) {
+        transaction_usage_.reset();
+        manager_.release_transaction_usage(transaction_id_opt_.value());
+    }
+}
+
+namespace {
+
+// adds the size to the usage unless it exceeds the limit, or 0 not to limit
+bool add_within(std::atomic<std::size_t>& usage, std::size_t size, std::size_t limit) noexcept {
+    if (limit == 0) {
+        usage.fetch_add(size);
+        return true;
+    }
+    auto current = usage.load();
+    while (true) {
+        if (current > limit || size > limit - current) {
+            return false;
+        }
+        if (usage.compare_exchange_weak(current, current + size)) {
+            return true;
+        }
+    }
+}
+
+} // namespace
+
+quota_level blob_session_impl::reserve_session_quota(std::size_t size) {
+    if (!add_within(usage_, size, manager_.session_quota_)) {
+        return quota_level::session;
+    }
+    if (transaction_usage_ && !add_within(*transaction_usage_, size, manager_.transaction_quota_)) {
+        usage_.fetch_sub(size);
+        return quota_level::transaction;
+    }
+    return quota_level::none;
+}
+
+void blob_session_impl::release_session_quota(std::size_t size) {
+    usage_.fetch_sub(size);
+    if (transaction_usage_) {
+        transaction_usage_->fetch_sub(size);
+    }
+}
+
+quota_level blob_session_impl::reserve_quota(stripe_id_type stripe, std::size_t size, std::optional<std::chrono::system_clock::time_point> deadline) {
+    trace_scope_name("reserve_quota");
+    trace_scope_value(size);
+    if (auto rv = reserve_session_quota(size); rv != quota_level::none) {
+        trace_event("session or transaction quota exceeded");
+        return rv;
+    }
+    if (!(deadline ? session_store_.reserve(stripe, size, deadline.value()) : session_store_.reserve(stripe, size))) {
+        release_session_quota(size);
+        trace_event("session store quota exceeded");
+        return quota_level::store;
+    }
+    return quota_level::none;
+}
+
+void blob_session_impl::release_quota(stripe_id_type stripe, std::size_t size) {
+    release_session_quota(size);
+    session_store_.remove(stripe, size);
+}
+
+void blob_session_impl::release_quota(const std::vector<std::size_t>& sizes, std::size_t memory_size) {
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+        if (sizes[i] != 0) {
+            release_quota(static_cast<stripe_id_type>(i), sizes[i]);
+        }
+    }
+    if (memory_size != 0) {
+        release_session_quota(memory_size);
+        session_store_.release_memory(memory_size);
+    }
+}
+
+void blob_session_impl::restore_quota(stripe_id_type stripe, std::size_t size) {
+    usage_.fetch_add(size);
+    if (transaction_usage_) {
+        transaction_usage_->fetch_add(size);
+    }
+    session_store_.restore(stripe, size);
+}
+
+// the BLOB in a memory file has no path, as the descriptor may be closed and its number reused once the lock is released
+blob_session::blob_path_type blob_session_impl::path_of(blob_id_type bid, const blob_entry& entry) const {
+    if (entry.external != nullptr) {
+        return *entry.external;
+    }
+    return session_store_.blob_file_path(bid, entry.prefix, entry.stripe);
+}
+
+void blob_session_impl::check_not_disposed() const {
+    if (disposed_) {
+        throw std::out_of_range("the session has been disposed");
+    }
+}
+
 blob_session::blob_id_type blob_session_impl::add(blob_session::blob_path_type path) {
-    std::lock_guard<std::mutex> lock(mtx_);
+    if (!std::filesystem::exists(path)) {
+        throw std::runtime_error(path.string() + " does not exists");
+    }
+    auto canonical_path = std::filesystem::canonical(path);
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    check_not_disposed();
     blob_id_type new_blob_id = manager_.get_new_blob_id();
-    if (std::filesystem::exists(path)) {
+    // the blob file is not subject to quota management
+    blobs_.emplace(new_blob_id, blob_entry{manager_.path_arena_.intern(canonical_path.string()), 0});
+    return new_blob_id;
+}
+
+std::vector<blob_session::blob_id_type> blob_session_impl::add(const blob_path_type* paths, std::size_t count) {
+    std::vector<std::string> canonical_paths{};
+    canonical_paths.reserve(count);
+    std::unordered_map<std::string, blob_path_type> directories{};
+    for (std::size_t i = 0; i < count; i++) {
+        const auto& path = paths[i];  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        std::error_code ec{};
+        auto status = std::filesystem::symlink_status(path, ec);
+        if (status.type() == std::filesystem::file_type::not_found || status.type() == std::filesystem::file_type::none) {
+            throw std::runtime_error(path.string() + " does not exists");
+        }
+        auto filename = path.filename();
+        if (status.type() == std::filesystem::file_type::symlink || filename.empty() || filename == "." || filename == "..") {
+            if (!std::filesystem::exists(path)) {
+                throw std::runtime_error(path.string() + " does not exists");
+            }
+            canonical_paths.emplace_back(std::filesystem::canonical(path).string());
+            continue;
+        }
+        // the canonical path of a non symbolic link is the canonical path of its directory with the file name
+        auto directory = path.parent_path().string();
+        auto itr = directories.find(directory);
+        if (itr == directories.end()) {
+            itr = directories.emplace(directory, std::filesystem::canonical(directory.empty() ? "." : directory)).first;
+        }
+        canonical_paths.emplace_back((itr->second / filename).string());
+    }
+
+    std::vector<path_arena::handle_type> handles(count);
+    std::vector<blob_id_type> blob_ids(count);
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    check_not_disposed();
+    if (count == 0) {
+        return blob_ids;
+    }
+    auto first = manager_.get_new_blob_ids(count);
+    manager_.path_arena_.intern(canonical_paths.data(), count, handles.data());
+    blobs_.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
         // the blob file is not subject to quota management
-        blobs_.emplace(new_blob_id, std::make_pair<blob_path_type, std::size_t>(std::filesystem::canonical(path), 0));
-        return new_blob_id;
+        blob_ids[i] = first + i;
+        blobs_.emplace(blob_ids[i], blob_entry{handles[i], 0});
     }
-    throw std::runtime_error(path.string() + " does not exists");
+    return blob_ids;
 }
 
 void blob_session_impl::dispose() {
-    for (auto&& e: entries()) {
-        delete_blob_file(e);
-    }
+    auto self = shared_from_this();  // the BLOB files are deleted on return if no RPC pins this session
     manager_.dispose(session_id_);
 }
 
 std::pair<blob_session::blob_id_type, std::filesystem::path> blob_session_impl::create_blob_file(const std::string prefix) {
-    std::lock_guard<std::mutex> lock(mtx_);
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    check_not_disposed();
     blob_id_type new_blob_id = manager_.get_new_blob_id();
-    auto file_path = session_store_.create_blob_file(new_blob_id, prefix);
-    blobs_.emplace(new_blob_id, std::make_pair<blob_path_type, std::size_t>(blob_path_type(file_path), 0));  // the actual file does not exist
-    return { new_blob_id, file_path };
+    auto prefix_id = session_store_.prefix_id(prefix);
+    auto stripe = session_store_.place(new_blob_id);
+    blobs_.emplace(new_blob_id, blob_entry{nullptr, 0, -1, prefix_id, stripe});  // the actual file does not exist
+    return { new_blob_id, session_store_.blob_file_path(new_blob_id, prefix_id, stripe) };
 }
 
 blob_session::blob_tag_type blob_session_impl::compute_tag(blob_session::blob_id_type blob_id) const {
@@ -56,6 +235,11 @@ blob_session::blob_tag_type blob_session_impl::compute_tag(blob_session::blob_id
     return rv;
 }
 
+void blob_session_impl::compute_tags(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::blob_tag_type* tags) const {
+    manager_.generate_reference_tags(blob_ids, count, session_id_, tags);
+    VLOG_LP(log_debug) << "compute_tags with session_id = " << session_id_ << " for " << count << " BLOBs";
+}
+
 blob_session::blob_tag_type blob_session_impl::get_tag(blob_session::blob_id_type blob_id) const {
     if (transaction_id_opt_) {
         auto rv = manager_.get_tag(blob_id, transaction_id_opt_.value());
@@ -63,22 +247,82 @@ blob_session::blob_tag_type blob_session_impl::get_tag(blob_session::blob_id_typ
             ", and calcurated tag = " << rv;
         return rv;
     }
-    auto rv = manager_.get_tag(blob_id, session_id_);
+    // the session ID is not a key of the tag cache, which may be equal to a transaction ID
+    blob_session::blob_tag_type rv{};
+    manager_.retrieve_tags(&blob_id, 1, session_id_, &rv);
     VLOG_LP(log_debug) << "get_tag with session_id = " << session_id_ << " and blob_id = " << blob_id <<
         ", and calcurated tag = " << rv;
     return rv;
 }
 
+void blob_session_impl::get_tags(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::blob_tag_type* tags) const {
+    if (transaction_id_opt_) {
+        manager_.get_tags(blob_ids, count, transaction_id_opt_.value(), tags);
+        VLOG_LP(log_debug) << "get_tags with transaction_id = " << transaction_id_opt_.value() << " for " << count << " BLOBs";
+        return;
+    }
+    manager_.retrieve_tags(blob_ids, count, session_id_, tags);
+    VLOG_LP(log_debug) << "get_tags with session_id = " << session_id_ << " for " << count << " BLOBs";
+}
+
 void blob_session_impl::delete_blob_file(blob_id_type bid) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (auto itr = blobs_.find(bid); itr != blobs_.end()) {
-        session_store_.remove(itr->second.second);         // decrease session storage usage counter
-        if (std::filesystem::exists(itr->second.first)) {  // maybe blob file has been moved
-            std::filesystem::remove(itr->second.first);
+    delete_blob_files(&bid, 1);
+}
+
+void blob_session_impl::delete_blob_files(const blob_id_type* bids, std::size_t count) {
+    std::vector<std::pair<blob_id_type, blob_entry>> entries{};
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        entries.reserve(std::min(count, blobs_.size()));
+        for (std::size_t i = 0; i < count; i++) {
+            auto bid = bids[i];  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            if (auto entry = blobs_.extract(bid); entry) {
+                entries.emplace_back(bid, entry.value());
+            }
         }
-        blobs_.erase(itr);
+    }
+    if (entries.empty()) {
         return;
     }
+
+    // the files are removed outside the lock so that it does not block lookups
+    std::vector<std::size_t> sizes(session_store_.stripe_count());
+    std::size_t memory_size{};
+    std::vector<blob_path_type> paths{};
+    std::vector<blob_id_type> stored{};
+    paths.reserve(entries.size());
+    for (auto&& [bid, e] : entries) {
+        (e.memory_tier ? memory_size : sizes.at(e.stripe)) += e.size;
+        if (e.fd >= 0) {
+            ::close(e.fd);
+            continue;
+        }
+        if (e.packed) {
+            session_store_.segments()->remove(bid);
+            continue;
+        }
+        paths.emplace_back(path_of(bid, e));
+        if (e.external != nullptr) {
+            manager_.path_arena_.release(e.external);
+        } else {
+            stored.emplace_back(bid);
+        }
+    }
+    release_quota(sizes, memory_size);  // decrease session storage usage counter
+    if (manager_.index_) {
+        manager_.index_->blobs_removed(stored.data(), stored.size());
+    }
+    manager_.reclaimer_.remove(std::move(paths));
+}
+
+void blob_session_impl::complete_blob_file(blob_id_type bid) {
+    if (!manager_.index_) {
+        return;
+    }
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    if (auto* e = blobs_.find(bid); e != nullptr && e->fd < 0 && e->external == nullptr) {
+        manager_.index_->blob_added(bid, session_id_, e->size, session_store_.prefixes_.at(e->prefix), e->stripe);
+    }
 }
 
 std::optional<blob_session::transaction_id_type> blob_session_impl:: get_transaction_id() const noexcept {
@@ -86,12 +330,231 @@ std::optional<blob_session::transaction_id_type> blob_session_impl:: get_transac
 }
 
 bool blob_session_impl::reserve_session_store(blob_id_type bid, std::size_t size) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (session_store_.reserve(size)) {
-        blobs_.at(bid).second += size;
-        return true;
+    return try_reserve_session_store(bid, size) == quota_level::none;
+}
+
+quota_level blob_session_impl::try_reserve_session_store(blob_id_type bid, std::size_t size) {
+    // the shared lock only keeps the entry from being removed, as the size is added atomically
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    auto* e = blobs_.find(bid);
+    if (e == nullptr) {
+        throw std::out_of_range("can not find the blob specified");
+    }
+    auto rv = reserve_quota(e->stripe, size);
+    if (rv == quota_level::none) {
+        e->size += size;
+    }
+    return rv;
+}
+
+quota_level blob_session_impl::try_reserve_session_store(blob_id_type bid, std::size_t size, std::chrono::system_clock::time_point deadline) {
+    stripe_id_type stripe{};
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        auto* e = blobs_.find(bid);
+        if (e == nullptr) {
+            throw std::out_of_range("can not find the blob specified");
+        }
+        stripe = e->stripe;
+    }
+    // the usage is reserved outside the lock, as it may wait for usage released by other sessions
+    auto rv = reserve_quota(stripe, size, deadline);
+    if (rv != quota_level::none) {
+        return rv;
+    }
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    if (auto* e = blobs_.find(bid); e != nullptr) {
+        e->size += size;
+        return rv;
+    }
+    lock.unlock();
+    release_quota(stripe, size);
+    throw std::out_of_range("can not find the blob specified");
+}
+
+std::optional<blob_session::blob_id_type> blob_session_impl::adopt_blob_file(int fd, std::size_t size) {
+    quota_level exceeded{};
+    return adopt_blob_file(fd, size, exceeded);
+}
+
+std::optional<blob_session::blob_id_type> blob_session_impl::adopt_blob_file(int fd, std::size_t size, quota_level& exceeded) {
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    check_not_disposed();
+    // the memory file is not in the session store, but its size is charged to a stripe to bound the total usage
+    blob_id_type new_blob_id = manager_.get_new_blob_id();
+    auto stripe = session_store_.place(new_blob_id);
+    exceeded = reserve_quota(stripe, size);
+    if (exceeded != quota_level::none) {
+        return std::nullopt;
+    }
+    blobs_.emplace(new_blob_id, blob_entry{nullptr, size, fd, 0, stripe});
+    return new_blob_id;
+}
+
+std::optional<blob_session::blob_id_type> blob_session_impl::add_memory_blob(std::string_view data, quota_level& exceeded) {
+    exceeded = reserve_session_quota(data.size());
+    if (exceeded != quota_level::none) {
+        return std::nullopt;
+    }
+    if (!session_store_.reserve_memory(data.size())) {
+        release_session_quota(data.size());
+        return std::nullopt;
+    }
+    int fd = ::memfd_create("blob", MFD_CLOEXEC | MFD_ALLOW_SEALING);  // NOLINT(hicpp-signed-bitwise)
+    bool written = fd >= 0;
+    for (std::size_t offset = 0; written && offset < data.size();) {
+        auto n = ::write(fd, data.data() + offset, data.size() - offset);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        written = n > 0;
+        offset += written ? static_cast<std::size_t>(n) : 0;
+    }
+    written = written && ::fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0;  // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg, hicpp-signed-bitwise)
+    if (!written) {
+        VLOG_LP(log_info) << "cannot keep the BLOB in the memory tier: " << std::strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        release_session_quota(data.size());
+        session_store_.release_memory(data.size());
+        return std::nullopt;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    if (disposed_) {
+        lock.unlock();
+        ::close(fd);
+        release_session_quota(data.size());
+        session_store_.release_memory(data.size());
+        throw std::out_of_range("the session has been disposed");
+    }
+    blob_id_type new_blob_id = manager_.get_new_blob_id();
+    blobs_.emplace(new_blob_id, blob_entry{nullptr, data.size(), fd, 0, 0, true});
+    return new_blob_id;
+}
+
+std::optional<blob_session::blob_id_type> blob_session_impl::add_packed_blob(std::string_view data, quota_level& exceeded) {
+    trace_scope_name("add_packed_blob");
+    exceeded = quota_level::none;
+    auto* segments = session_store_.segments();
+    if (segments == nullptr || data.size() > session_store_.segment_threshold()) {
+        return std::nullopt;
+    }
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    check_not_disposed();
+    // the segment files are in the primary directory
+    exceeded = reserve_quota(0, data.size());
+    if (exceeded != quota_level::none) {
+        return std::nullopt;
+    }
+    blob_id_type new_blob_id = manager_.get_new_blob_id();
+    if (!segments->append(new_blob_id, data)) {
+        release_quota(0, data.size());
+        return std::nullopt;
+    }
+    blobs_.emplace(new_blob_id, blob_entry{nullptr, data.size(), -1, 0, 0, false, true});
+    return new_blob_id;
+}
+
+std::optional<std::string> blob_session_impl::read_packed(blob_id_type bid) const {
+    trace_scope_name("read_packed");
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    if (auto* e = blobs_.find(bid); e != nullptr && e->packed) {
+        return session_store_.segments()->read(bid);
+    }
+    return std::nullopt;
+}
+
+std::optional<blob_session::blob_path_type> blob_session_impl::materialize(blob_id_type bid) {
+    trace_scope_name("materialize");
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    auto* e = blobs_.find(bid);
+    if (e == nullptr) {
+        return std::nullopt;
+    }
+    if (e->packed) {
+        return materialize_packed(bid, *e);
+    }
+    if (e->fd < 0) {
+        return path_of(bid, *e);
+    }
+
+    // the BLOB is small, and is copied under the lock so that it is materialized only once
+    auto prefix_id = session_store_.prefix_id("upload");
+    auto stripe = e->memory_tier ? session_store_.place(bid) : e->stripe;
+    auto path = session_store_.blob_file_path(bid, prefix_id, stripe);
+    int out = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);  // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg, hicpp-signed-bitwise)
+    bool written = out >= 0;
+    for (off_t offset = 0; written && static_cast<std::size_t>(offset) < e->size;) {
+        written = ::sendfile(out, e->fd, &offset, e->size - static_cast<std::size_t>(offset)) > 0;
+    }
+    int error = errno;
+    if (out >= 0) {
+        ::close(out);
+    }
+    if (!written) {
+        std::error_code ec{};
+        std::filesystem::remove(path, ec);
+        throw std::system_error(error, std::generic_category(), "cannot write the BLOB to " + path.string());
+    }
+    if (e->memory_tier) {
+        session_store_.restore(stripe, e->size);
+        session_store_.release_memory(e->size);
+    }
+    ::close(e->fd);
+    e->fd = -1;
+    e->prefix = prefix_id;
+    e->stripe = stripe;
+    e->memory_tier = false;
+    if (manager_.index_) {
+        manager_.index_->blob_added(bid, session_id_, e->size, session_store_.prefixes_.at(prefix_id), stripe);
+    }
+    VLOG_LP(log_debug) << "materialized the BLOB in memory, blob_id = " << bid << ", path = " << path.string();
+    return path;
+}
+
+blob_session::blob_path_type blob_session_impl::materialize_packed(blob_id_type bid, blob_entry& entry) {
+    auto data = session_store_.segments()->read(bid);
+    if (!data) {
+        throw std::system_error(EIO, std::generic_category(), "cannot read the BLOB from the segment file");
+    }
+    auto prefix_id = session_store_.prefix_id("upload");
+    auto path = session_store_.blob_file_path(bid, prefix_id, entry.stripe);
+    int out = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);  // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg, hicpp-signed-bitwise)
+    bool written = out >= 0;
+    for (std::size_t offset = 0; written && offset < data->size();) {
+        auto n = ::write(out, data->data() + offset, data->size() - offset);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        written = n > 0;
+        offset += written ? static_cast<std::size_t>(n) : 0;
+    }
+    int error = errno;
+    if (out >= 0) {
+        ::close(out);
+    }
+    if (!written) {
+        std::error_code ec{};
+        std::filesystem::remove(path, ec);
+        throw std::system_error(error, std::generic_category(), "cannot write the BLOB to " + path.string());
+    }
+    // the usage stays charged to the same directory
+    session_store_.segments()->remove(bid);
+    entry.packed = false;
+    entry.prefix = prefix_id;
+    if (manager_.index_) {
+        manager_.index_->blob_added(bid, session_id_, entry.size, session_store_.prefixes_.at(prefix_id), entry.stripe);
+    }
+    VLOG_LP(log_debug) << "materialized the BLOB packed in a segment file, blob_id = " << bid << ", path = " << path.string();
+    return path;
+}
+
+std::optional<int> blob_session_impl::reopen_descriptor(blob_id_type bid) const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    if (auto* e = blobs_.find(bid); e != nullptr && e->fd >= 0) {
+        // open a new file description so that the file offset is not shared, which dup() would share
+        auto path = blob_path_type("/proc/self/fd") / std::to_string(e->fd);
+        if (int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC); fd >= 0) {  // NOLINT(cppcoreguidelines-pro-type-vararg)
+            return fd;
+        }
     }
-    return false;
+    return std::nullopt;
 }
 
 } // namespace
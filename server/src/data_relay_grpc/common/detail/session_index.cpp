@@ -0,0 +1,408 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+#include "data_relay_grpc/logging_helper.h"
+#include "data_relay_grpc/logging.h"
+
+#include <data_relay_grpc/common/detail/session_index.h>
+
+namespace data_relay_grpc::common::detail {
+
+/**
+ * @brief a record of the index, which is 32 bytes in the native byte order
+ */
+struct session_index::record {
+    std::uint32_t checksum{};
+    std::uint8_t type{};
+    std::uint8_t prefix{};
+    std::uint8_t stripe{};  // the directory of the session store where the BLOB file is placed
+    std::uint8_t reserved{};
+    std::uint64_t id{};     // the session ID or the BLOB ID
+    std::uint64_t owner{};  // the session ID of the BLOB, or the transaction ID of the session
+    std::uint64_t size{};   // the size of the BLOB, or whether the session has the transaction ID
+};
+
+namespace {
+
+constexpr std::uint8_t RECORD_MAGIC = 0x7f;
+constexpr std::uint8_t RECORD_SESSION_CREATED = 1;
+constexpr std::uint8_t RECORD_SESSION_DISPOSED = 2;
+constexpr std::uint8_t RECORD_BLOB_ADDED = 3;
+constexpr std::uint8_t RECORD_BLOB_REMOVED = 4;
+constexpr std::uint8_t RECORD_PREFIX = 5;           // the prefix name is stored in place of id, owner and size
+constexpr std::uint8_t RECORD_BLOB_ID_RESERVED = 6;
+
+constexpr std::uint64_t index_magic = 0x3130584449475244ULL;  // "DRGIDX01"
+constexpr std::size_t record_size = 32;
+constexpr std::size_t max_prefix_length = 24;
+constexpr session_index::id_type blob_id_reservation = 4096;
+constexpr session_index::id_type max_blob_id_reservation = 1ULL << 20U;
+
+/**
+ * @brief the layout of a record of RECORD_PREFIX, copied from or to a record as a whole
+ */
+struct prefix_record {
+    std::uint32_t checksum{};
+    std::uint8_t type{};
+    std::uint8_t prefix{};
+    std::uint8_t stripe{};
+    std::uint8_t reserved{};
+    std::array<char, max_prefix_length> name{};  // padded with NUL if shorter
+};
+static_assert(sizeof(prefix_record) == record_size);
+
+prefix_record prefix_record_of(std::uint8_t id, const std::string& prefix) {
+    prefix_record rv{0, RECORD_PREFIX, id, 0, 0, {}};
+    std::memcpy(rv.name.data(), prefix.data(), std::min(prefix.size(), max_prefix_length));
+    return rv;
+}
+
+std::uint32_t checksum_of(const void* data, std::size_t size) {
+    // FNV-1a
+    std::uint32_t h = 2166136261U;
+    const auto* p = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++) {
+        h ^= p[i];  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        h *= 16777619U;
+    }
+    return h;
+}
+
+} // namespace
+
+session_index::session_index(std::filesystem::path path, std::size_t compaction_threshold)
+    : path_(std::move(path)), reservation_(blob_id_reservation), compaction_threshold_(compaction_threshold) {
+    recover();
+    compact();
+}
+
+session_index::~session_index() {
+    wait_compaction();
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+// replays the records in the file up to the limit into the state, and returns the number of the records replayed
+std::size_t session_index::replay(std::size_t limit, recovered_state& state, std::map<std::uint8_t, std::string>& prefixes) const {
+    std::ifstream ifs(path_, std::ios::binary);
+    if (!ifs) {
+        return 0;
+    }
+    std::unordered_map<id_type, id_type> owners{};
+    std::size_t count{};
+    record rec{};
+    while (count < limit && ifs.read(reinterpret_cast<char*>(&rec), sizeof(rec))) {  // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        if (rec.checksum != checksum_of(&rec.type, sizeof(rec) - sizeof(rec.checksum))) {
+            LOG_LP(WARNING) << "ignores the records torn in the session index (" << path_.string() << ") after " << count << " records";
+            break;
+        }
+        if (count++ == 0 && (rec.type != RECORD_MAGIC || rec.id != index_magic)) {
+            LOG_LP(WARNING) << path_.string() << " is not a session index, and thus ignored";
+            break;
+        }
+        switch (rec.type) {
+            case RECORD_SESSION_CREATED: {
+                auto& s = state.sessions[rec.id];
+                if (rec.size != 0) {
+                    s.transaction_id_opt = rec.owner;
+                }
+                state.max_session_id = std::max(state.max_session_id, rec.id);
+                break;
+            }
+            case RECORD_SESSION_DISPOSED:
+                state.sessions.erase(rec.id);
+                break;
+            case RECORD_BLOB_ADDED:
+                if (auto itr = state.sessions.find(rec.owner); itr != state.sessions.end()) {
+                    itr->second.blobs[rec.id] = blob_state{prefixes[rec.prefix], rec.size, rec.stripe};
+                    owners[rec.id] = rec.owner;
+                }
+                state.max_blob_id = std::max(state.max_blob_id, rec.id);
+                break;
+            case RECORD_BLOB_REMOVED:
+                if (auto itr = owners.find(rec.id); itr != owners.end()) {
+                    if (auto s = state.sessions.find(itr->second); s != state.sessions.end()) {
+                        s->second.blobs.erase(rec.id);
+                    }
+                    owners.erase(itr);
+                }
+                break;
+            case RECORD_PREFIX: {
+                prefix_record p{};
+                std::memcpy(static_cast<void*>(&p), &rec, sizeof(p));
+                prefixes[p.prefix] = std::string(p.name.data(), ::strnlen(p.name.data(), p.name.size()));
+                break;
+            }
+            case RECORD_BLOB_ID_RESERVED:
+                state.max_blob_id = std::max(state.max_blob_id, rec.id);
+                break;
+            default:
+                break;
+        }
+    }
+    return count;
+}
+
+void session_index::recover() {
+    std::map<std::uint8_t, std::string> prefixes{};
+    replay(std::numeric_limits<std::size_t>::max(), recovered_, prefixes);
+    VLOG_LP(log_info) << "recovered " << recovered_.sessions.size() << " sessions from the session index (" << path_.string() << ")";
+}
+
+// the records to replace the index with, where the BLOB files refer to the prefixes by the IDs given
+std::vector<session_index::record> session_index::live_records(const recovered_state& state, id_type max_blob_id, const std::unordered_map<std::string, std::uint8_t>& prefixes) const {
+    std::vector<record> records{};
+    auto add = [&records](record rec) {
+        rec.checksum = checksum_of(&rec.type, sizeof(rec) - sizeof(rec.checksum));
+        records.emplace_back(rec);
+    };
+    add(record{0, RECORD_MAGIC, 0, 0, 0, index_magic, 0, 0});
+    add(record{0, RECORD_BLOB_ID_RESERVED, 0, 0, 0, max_blob_id, 0, 0});
+    for (auto&& [name, id] : prefixes) {
+        auto p = prefix_record_of(id, name);
+        record rec{};
+        std::memcpy(static_cast<void*>(&rec), &p, sizeof(rec));
+        add(rec);
+    }
+    for (auto&& [session_id, s] : state.sessions) {
+        add(record{0, RECORD_SESSION_CREATED, 0, 0, 0, session_id, s.transaction_id_opt.value_or(0), s.transaction_id_opt ? 1U : 0U});
+        for (auto&& [blob_id, b] : s.blobs) {
+            add(record{0, RECORD_BLOB_ADDED, prefixes.at(b.prefix), b.stripe, 0, blob_id, session_id, b.size});
+        }
+    }
+    return records;
+}
+
+// writes the records and the tail to a new file, replaces the index with it, and returns the descriptor to append
+int session_index::replace_file(const std::vector<record>& records, const std::vector<char>& tail) const {
+    auto tmp = path_;
+    tmp += ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);  // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot create " + tmp.string());
+    }
+    auto bytes = records.size() * sizeof(record);
+    bool written = ::write(fd, records.data(), bytes) == static_cast<ssize_t>(bytes)
+        && (tail.empty() || ::write(fd, tail.data(), tail.size()) == static_cast<ssize_t>(tail.size()))
+        && ::fdatasync(fd) == 0;
+    int error = errno;
+    ::close(fd);
+    if (!written || ::rename(tmp.c_str(), path_.c_str()) != 0) {
+        error = written ? errno : error;
+        ::unlink(tmp.c_str());
+        throw std::system_error(error, std::generic_category(), "cannot write " + path_.string());
+    }
+    fd = ::open(path_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);  // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot open " + path_.string());
+    }
+    return fd;
+}
+
+void session_index::compact() {
+    // the prefixes are numbered again with those in use
+    for (auto&& [session_id, s] : recovered_.sessions) {
+        for (auto&& [blob_id, b] : s.blobs) {
+            prefixes_.try_emplace(b.prefix, static_cast<std::uint8_t>(prefixes_.size()));
+        }
+    }
+    auto records = live_records(recovered_, recovered_.max_blob_id, prefixes_);
+    reserved_blob_id_ = recovered_.max_blob_id;
+    fd_ = replace_file(records, {});
+    records_ = records.size();
+}
+
+// compacts the index while the records are appended, which are carried over to the compacted one
+void session_index::compact_live() {
+    std::size_t snapshot{};
+    {
+        std::unique_lock<std::shared_mutex> lock(file_mtx_);
+        snapshot = records_.load();
+    }
+    recovered_state state{};
+    std::map<std::uint8_t, std::string> prefix_names{};
+    if (replay(snapshot, state, prefix_names) != snapshot) {
+        LOG_LP(WARNING) << "cannot compact the session index (" << path_.string() << "), as it cannot be read";
+        return;
+    }
+    // the prefixes keep their IDs, as the records appended later refer to them
+    std::unordered_map<std::string, std::uint8_t> prefixes{};
+    for (auto&& [id, name] : prefix_names) {
+        prefixes.emplace(name, id);
+    }
+    auto records = live_records(state, reserved_blob_id_.load(), prefixes);
+    auto dead = snapshot > records.size() ? snapshot - records.size() : 0;
+
+    std::unique_lock<std::shared_mutex> lock(file_mtx_);
+    std::vector<char> tail((records_.load() - snapshot) * sizeof(record));
+    if (!tail.empty()) {
+        std::ifstream ifs(path_, std::ios::binary);
+        ifs.seekg(static_cast<std::streamoff>(snapshot * sizeof(record)));
+        if (!ifs.read(tail.data(), static_cast<std::streamsize>(tail.size()))) {
+            LOG_LP(WARNING) << "cannot compact the session index (" << path_.string() << "), as it cannot be read";
+            return;
+        }
+    }
+    int fd = replace_file(records, tail);
+    ::close(fd_);
+    fd_ = fd;
+    records_ = records.size() + tail.size() / sizeof(record);
+    dead_records_ -= std::min(dead_records_.load(), dead);
+    VLOG_LP(log_info) << "compacted the session index (" << path_.string() << ") from " << snapshot << " to " << records.size() << " records";
+}
+
+void session_index::maybe_compact() {
+    auto dead = dead_records_.load();
+    if (compaction_threshold_ == 0 || dead < compaction_threshold_ || dead * 2 < records_.load()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(compactor_mtx_);
+    if (compacting_.exchange(true)) {
+        return;
+    }
+    if (compactor_.joinable()) {
+        compactor_.join();
+    }
+    compactor_ = std::thread([this] {
+        try {
+            compact_live();
+        } catch (std::system_error& ex) {
+            LOG_LP(ERROR) << "cannot compact the session index: " << ex.what();
+        }
+        compacting_ = false;
+    });
+}
+
+void session_index::wait_compaction() {
+    std::lock_guard<std::mutex> lock(compactor_mtx_);
+    if (compactor_.joinable()) {
+        compactor_.join();
+    }
+}
+
+void session_index::append(const record& rec) {
+    record r = rec;
+    append(&r, 1);
+}
+
+void session_index::append(record* records, std::size_t count) {
+    static_assert(sizeof(record) == record_size && sizeof(record) == sizeof(prefix_record));
+    static_assert(std::is_trivially_copyable_v<record> && std::is_trivially_copyable_v<prefix_record>);
+    for (std::size_t i = 0; i < count; i++) {
+        auto& r = records[i];  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        r.checksum = checksum_of(&r.type, sizeof(r) - sizeof(r.checksum));
+    }
+    // records are appended by one write, which is not interleaved with others
+    auto bytes = count * sizeof(record);
+    {
+        std::shared_lock<std::shared_mutex> lock(file_mtx_);
+        if (::write(fd_, records, bytes) != static_cast<ssize_t>(bytes)) {
+            LOG_LP(ERROR) << "cannot append records to the session index (" << path_.string() << "): " << std::strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+            return;
+        }
+        records_ += count;
+    }
+    maybe_compact();
+}
+
+std::optional<std::uint8_t> session_index::prefix_id(const std::string& prefix) {
+    if (prefix.size() > max_prefix_length) {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (auto itr = prefixes_.find(prefix); itr != prefixes_.end()) {
+        return itr->second;
+    }
+    constexpr std::size_t max_prefixes = 256;
+    if (prefixes_.size() == max_prefixes) {
+        return std::nullopt;
+    }
+    auto id = static_cast<std::uint8_t>(prefixes_.size());
+    auto p = prefix_record_of(id, prefix);
+    record rec{};
+    std::memcpy(static_cast<void*>(&rec), &p, sizeof(rec));
+    append(rec);  // before any record refers to the prefix
+    prefixes_.emplace(prefix, id);
+    return id;
+}
+
+void session_index::session_created(id_type session_id, std::optional<id_type> transaction_id_opt) {
+    append(record{0, RECORD_SESSION_CREATED, 0, 0, 0, session_id, transaction_id_opt.value_or(0), transaction_id_opt ? 1U : 0U});
+}
+
+void session_index::session_disposed(id_type session_id, std::size_t blob_count) {
+    // supersedes the record of the creation and those of the BLOB files
+    dead_records_ += 2 + blob_count;
+    append(record{0, RECORD_SESSION_DISPOSED, 0, 0, 0, session_id, 0, 0});
+}
+
+void session_index::blob_added(id_type blob_id, id_type session_id, std::size_t size, const std::string& prefix, std::uint8_t stripe) {
+    auto prefix_opt = prefix_id(prefix);
+    if (!prefix_opt) {
+        LOG_LP(WARNING) << "the BLOB file with the prefix (" << prefix << ") cannot be recorded in the session index";
+        return;
+    }
+    append(record{0, RECORD_BLOB_ADDED, prefix_opt.value(), stripe, 0, blob_id, session_id, size});
+}
+
+void session_index::blob_removed(id_type blob_id) {
+    dead_records_ += 2;
+    append(record{0, RECORD_BLOB_REMOVED, 0, 0, 0, blob_id, 0, 0});
+}
+
+void session_index::blobs_removed(const id_type* blob_ids, std::size_t count) {
+    if (count == 0) {
+        return;
+    }
+    dead_records_ += 2 * count;
+    std::vector<record> records(count);
+    for (std::size_t i = 0; i < count; i++) {
+        records[i] = record{0, RECORD_BLOB_REMOVED, 0, 0, 0, blob_ids[i], 0, 0};  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+    append(records.data(), records.size());
+}
+
+void session_index::assign_blob_id(id_type blob_id) {
+    if (blob_id <= reserved_blob_id_.load()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (blob_id <= reserved_blob_id_.load()) {
+        return;
+    }
+    auto reserved = blob_id + reservation_ - 1;
+    reservation_ = std::min(reservation_ * 2, max_blob_id_reservation);
+    dead_records_ += 1;  // supersedes the previous one
+    append(record{0, RECORD_BLOB_ID_RESERVED, 0, 0, 0, reserved, 0, 0});
+    reserved_blob_id_ = reserved;
+}
+
+} // namespace
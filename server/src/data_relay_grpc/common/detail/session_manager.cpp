@@ -14,83 +14,425 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <limits>
+#include <system_error>
+#include <unordered_set>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <glog/logging.h>
 #include "data_relay_grpc/logging_helper.h"
 #include "data_relay_grpc/logging.h"
 
 #include <data_relay_grpc/common/detail/session_manager.h>
+#include <data_relay_grpc/common/detail/trace.h>
 
 namespace data_relay_grpc::common::detail {
 
+namespace {
+
+// the primary directory followed by the additional ones to stripe the session store
+std::vector<std::filesystem::path> store_directories(const std::string& directory, const session_store_options& options) {
+    std::vector<std::filesystem::path> rv{directory};
+    rv.insert(rv.end(), options.stripe_directories.begin(), options.stripe_directories.end());
+    return rv;
+}
+
+} // namespace
+
 blob_session_manager::blob_session_manager(const api& api, const std::string& directory, std::size_t quota, bool dev_accept_mock_tag)
-    : api_(api), session_store_(directory, quota), dev_accept_mock_tag_(dev_accept_mock_tag) {
+    : blob_session_manager(api, directory, quota, dev_accept_mock_tag, session_store_options{}) {
+}
+
+blob_session_manager::blob_session_manager(const api& api, const std::string& directory, std::size_t quota, bool dev_accept_mock_tag, const session_store_options& options)
+    : api_(api), session_store_(store_directories(directory, options), quota, options.cleanup_threads, options.persistent_index, options.placement), dev_accept_mock_tag_(dev_accept_mock_tag),
+      tag_generator_(options.persistent_index ? load_tag_key(std::filesystem::path(directory) / ".tag_key") : tag_generator_type::random_key()), tag_cache_(options.tag_cache_size),
+      path_cache_(options.path_cache_size, options.path_cache_ttl, options.path_cache_negative_ttl), reclaimer_(options.deletion_threads),
+      session_quota_(options.session_quota), transaction_quota_(options.transaction_quota) {
+    session_store_.admission_wait(options.admission_wait);
+    session_store_.fanout(options.fanout_levels);
+    session_store_.memory_tier(options.memory_tier_budget, options.memory_tier_threshold);
+    session_store_.segments(options.segment_size, options.segment_threshold);
+    if (options.persistent_index) {
+        index_ = std::make_unique<session_index>(std::filesystem::path(directory) / ".index");
+        restore_sessions();
+    }
+}
+
+blob_session_manager::tag_generator_type::key_type blob_session_manager::load_tag_key(const std::filesystem::path& path) {
+    tag_generator_type::key_type key{};
+    if (!std::filesystem::exists(path)) {
+        // the key is created once by linking the file completely written, and thus a key torn by a crash is never read
+        key = tag_generator_type::random_key();
+        auto tmp = path;
+        tmp += ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);  // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot create " + tmp.string());
+        }
+        bool written = ::write(fd, key.data(), key.size()) == static_cast<ssize_t>(key.size()) && ::fdatasync(fd) == 0;
+        int error = errno;
+        ::close(fd);
+        bool linked = written && (::link(tmp.c_str(), path.c_str()) == 0 || errno == EEXIST);
+        if (written && !linked) {
+            error = errno;
+        }
+        ::unlink(tmp.c_str());
+        if (!linked) {
+            throw std::system_error(error, std::generic_category(), "cannot write " + path.string());
+        }
+    }
+    // reads the key even if created above, as another process may have created it first
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);  // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg)
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot open " + path.string());
+    }
+    auto size = ::read(fd, key.data(), key.size());
+    ::close(fd);
+    if (size != static_cast<ssize_t>(key.size())) {
+        throw std::runtime_error(path.string() + " is not a key of the reference tags");
+    }
+    return key;
+}
+
+void blob_session_manager::restore_sessions() {
+    auto& recovered = index_->recovered();
+    std::unordered_set<blob_session::blob_id_type> live_blobs{};
+    for (auto&& [session_id, s] : recovered.sessions) {
+        auto impl = make_session_impl(session_id, s.transaction_id_opt);
+        for (auto&& [blob_id, b] : s.blobs) {
+            if (b.stripe >= session_store_.stripe_count()) {
+                LOG_LP(WARNING) << "the BLOB file (" << blob_id << ") is not restored, as the directory where it has been placed is no longer in the session store";
+                continue;
+            }
+            // the quota is rebuilt from the sizes recorded without examining the files
+            impl->blobs_.emplace(blob_id, blob_session_impl::blob_entry{nullptr, b.size, -1, session_store_.prefix_id(b.prefix), b.stripe});
+            impl->restore_quota(b.stripe, b.size);
+            live_blobs.emplace(blob_id);
+        }
+        blob_sessions_.try_emplace(session_id, blob_session(std::move(impl)));
+        if (s.transaction_id_opt) {
+            blob_session_ids_.try_emplace(s.transaction_id_opt.value(), session_id);
+        }
+    }
+    session_id_ = recovered.max_session_id;
+    blob_id_ = recovered.max_blob_id;
+    restored_sessions_ = recovered.sessions.size();
+
+    // delete the files not recorded, whose BLOB IDs have been assigned before the restart,
+    // in background as it scans all files in the session store
+    std::vector<std::filesystem::path> directories{};
+    for (auto&& stripe : session_store_.stripes_) {
+        directories.emplace_back(stripe.directory);
+    }
+    VLOG_LP(log_info) << "restored " << restored_sessions_ << " sessions with " << live_blobs.size() << " BLOB files, and deletes the files not recorded in the session index";
+    reclaimer_.sweep(std::move(directories), [live_blobs = std::move(live_blobs), max_blob_id = recovered.max_blob_id](const std::filesystem::path& path) {
+        auto name = path.filename().string();
+        auto pos = name.rfind('_');
+        if (name.front() == '.' || pos == std::string::npos || pos + 1 == name.size()
+            || name.find_first_not_of("0123456789", pos + 1) != std::string::npos
+            || name.size() - pos - 1 > static_cast<std::size_t>(std::numeric_limits<blob_session::blob_id_type>::digits10)) {
+            return false;
+        }
+        auto blob_id = std::stoull(name.substr(pos + 1));
+        return blob_id <= max_blob_id && live_blobs.find(blob_id) == live_blobs.end();
+    });
 }
 
 blob_session& blob_session_manager::create_session(std::optional<blob_session::transaction_id_type> transaction_id_opt) {
-    std::lock_guard<std::mutex> lock(mtx_);
     auto session_id = ++session_id_;
-    blob_sessions_.emplace(session_id, blob_session(std::make_unique<blob_session_impl>(session_id, session_store_, transaction_id_opt, *this)));
+    // recorded before the session is published, so that no record of its BLOB files precedes it
+    if (index_) {
+        index_->session_created(session_id, transaction_id_opt);
+    }
+    auto& session = blob_sessions_.try_emplace(session_id, blob_session(make_session_impl(session_id, transaction_id_opt))).first;
     if (transaction_id_opt) {
-        blob_session_ids_.emplace(transaction_id_opt.value(), session_id);
+        blob_session_ids_.try_emplace(transaction_id_opt.value(), session_id);
     }
-    return blob_sessions_.at(session_id);
+    return session;
+}
+
+std::shared_ptr<blob_session_impl> blob_session_manager::make_session_impl(blob_session::session_id_type session_id, std::optional<blob_session::transaction_id_type> transaction_id_opt) {
+    auto impl = std::make_shared<blob_session_impl>(session_id, session_store_, transaction_id_opt, *this);
+    if (transaction_id_opt) {
+        // the tags are cached only for transactions, as session IDs may be equal to them
+        tag_cache_.open(transaction_id_opt.value());
+    }
+    if (transaction_id_opt && transaction_quota_ != 0) {
+        // shared by the sessions of the transaction
+        impl->transaction_usage_ = transaction_usages_.find_or_emplace(transaction_id_opt.value(), std::make_shared<std::atomic<std::size_t>>());
+    }
+    return impl;
+}
+
+void blob_session_manager::release_transaction_usage(blob_session::transaction_id_type transaction_id) {
+    transaction_usages_.erase_if(transaction_id, [](const std::shared_ptr<std::atomic<std::size_t>>& e){ return e.use_count() == 1; });
 }
 
 blob_session& blob_session_manager::get_session(blob_session::session_id_type session_id) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (auto&& itrs = blob_sessions_.find(session_id); itrs != blob_sessions_.end()) {
-        return itrs->second;
+    trace_scope_name("get_session");
+    blob_session* rv{};
+    if (blob_sessions_.find(session_id, [&rv](blob_session& e){ rv = &e; })) {
+        return *rv;
     }
     throw std::out_of_range("can not find the session specified");
 }
 
 void blob_session_manager::dispose(blob_session::session_id_type session_id) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (auto&& itrs = blob_sessions_.find(session_id); itrs != blob_sessions_.end()) {
-        if(auto transaction_id_opt = itrs->second.impl_->transaction_id_opt_; transaction_id_opt) {
-            if (auto&& itrt = blob_session_ids_.find(transaction_id_opt.value()); itrt != blob_session_ids_.end()) {
-                blob_session_ids_.erase(itrt);
-            }
+    auto session_opt = blob_sessions_.extract(session_id);
+    if (!session_opt) {
+        return;
+    }
+    auto& impl = session_opt.value().impl_;
+    impl->disposed_ = true;
+    if (index_) {
+        std::size_t blob_count{};
+        {
+            std::shared_lock<std::shared_mutex> lock(impl->mtx_);
+            blob_count = impl->blobs_.size();
         }
-        blob_sessions_.erase(itrs);
+        index_->session_disposed(session_id, blob_count);
+    }
+    if (auto transaction_id_opt = impl->transaction_id_opt_; transaction_id_opt) {
+        tag_cache_.close(transaction_id_opt.value());
+        blob_session_ids_.erase_if(transaction_id_opt.value(), [session_id](blob_session::session_id_type e){ return e == session_id; });
     }
+    // the session is released here, outside the lock of the shard, and is destructed unless pinned
 }
 
 blob_session_impl& blob_session_manager::get_session_impl(blob_session::session_id_type session_id) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (auto itr = blob_sessions_.find(session_id); itr != blob_sessions_.end()) {
-        return *(itr->second.impl_);
+    trace_scope_name("get_session_impl");
+    blob_session_impl* rv{};
+    if (blob_sessions_.find(session_id, [&rv](blob_session& e){ rv = e.impl_.get(); })) {
+        return *rv;
+    }
+    throw std::out_of_range("can not find the session specified");
+}
+
+blob_session_handle blob_session_manager::pin_session(blob_session::session_id_type session_id) {
+    trace_scope_name("pin_session");
+    blob_session_handle rv{};
+    if (blob_sessions_.find(session_id, [&rv](blob_session& e){ rv = blob_session_handle(e.impl_); })) {
+        return rv;
     }
     throw std::out_of_range("can not find the session specified");
 }
 
 blob_session::session_id_type blob_session_manager::get_session_id(blob_session::transaction_id_type transaction_id) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (auto itr = blob_session_ids_.find(transaction_id); itr != blob_session_ids_.end()) {
-        return itr->second;
+    trace_scope_name("get_session_id");
+    blob_session::session_id_type rv{};
+    if (blob_session_ids_.find(transaction_id, [&rv](blob_session::session_id_type e){ rv = e; })) {
+        return rv;
     }
     throw std::out_of_range("can not find the session specified by the transaction_id");
 }
 
 blob_session::blob_tag_type blob_session_manager::get_tag(blob_session::blob_id_type bid, blob_session::transaction_id_type tid) {
-    return api_.get_tag()(bid, tid);
+    trace_scope_name("get_tag");
+    if (auto tag_opt = tag_cache_.find(bid, tid); tag_opt) {
+        return tag_opt.value();
+    }
+    auto tag = api_.get_tag()(bid, tid);
+    tag_cache_.insert(bid, tid, tag);
+    return tag;
+}
+
+std::uint64_t blob_session_manager::tag_cache_hits() const {
+    return tag_cache_.hits();
+}
+
+std::uint64_t blob_session_manager::tag_cache_misses() const {
+    return tag_cache_.misses();
+}
+
+void blob_session_manager::get_tags(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::transaction_id_type tid, blob_session::blob_tag_type* tags) {
+    trace_scope_name("get_tags");
+    trace_scope_value(count);
+    // the positions of the BLOBs not cached
+    std::vector<std::size_t> missed{};
+    for (std::size_t i = 0; i < count; i++) {
+        if (auto tag_opt = tag_cache_.find(blob_ids[i], tid); tag_opt) {  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            tags[i] = tag_opt.value();  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        } else {
+            missed.emplace_back(i);
+        }
+    }
+    if (missed.empty()) {
+        return;
+    }
+    if (missed.size() == count) {
+        retrieve_tags(blob_ids, count, tid, tags);
+    } else {
+        std::vector<blob_session::blob_id_type> ids{};
+        ids.reserve(missed.size());
+        for (auto i : missed) {
+            ids.emplace_back(blob_ids[i]);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        std::vector<blob_session::blob_tag_type> missed_tags(missed.size());
+        retrieve_tags(ids.data(), ids.size(), tid, missed_tags.data());
+        for (std::size_t j = 0; j < missed.size(); j++) {
+            tags[missed[j]] = missed_tags[j];  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+    }
+    for (auto i : missed) {
+        tag_cache_.insert(blob_ids[i], tid, tags[i]);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+}
+
+void blob_session_manager::retrieve_tags(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::transaction_id_type tid, blob_session::blob_tag_type* tags) {
+    if (count > 1 && api_.get_tags()) {
+        api_.get_tags()(blob_ids, count, tid, tags);
+        return;
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        tags[i] = api_.get_tag()(blob_ids[i], tid);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
 }
 
 blob_session::blob_path_type blob_session_manager::get_path(blob_session::blob_id_type bid) {
     return api_.get_path()(bid);
 }
 
+std::optional<blob_session::blob_path_type> blob_session_manager::find_path(blob_session::blob_id_type bid) {
+    trace_scope_name("find_path");
+    if (auto e = path_cache_.find(bid); e) {
+        if (!e->exists) {
+            return std::nullopt;
+        }
+        return std::move(e->path);
+    }
+    auto path = api_.get_path()(bid);
+    std::error_code ec{};
+    bool exists = std::filesystem::exists(path, ec);
+    path_cache_.insert(bid, path_cache::entry{path, exists});
+    if (!exists) {
+        return std::nullopt;
+    }
+    return path;
+}
+
+void blob_session_manager::get_paths(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::blob_path_type* paths) {
+    trace_scope_name("get_paths");
+    trace_scope_value(count);
+    // the positions of the BLOBs not cached, which are filled in the path cache as find_path() does
+    std::vector<std::size_t> missed{};
+    for (std::size_t i = 0; i < count; i++) {
+        if (auto e = path_cache_.find(blob_ids[i]); e) {  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            paths[i] = std::move(e->path);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        } else {
+            missed.emplace_back(i);
+        }
+    }
+    if (missed.empty()) {
+        return;
+    }
+    if (missed.size() == 1 || !api_.get_paths()) {
+        for (auto i : missed) {
+            paths[i] = api_.get_path()(blob_ids[i]);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+    } else if (missed.size() == count) {
+        api_.get_paths()(blob_ids, count, paths);
+    } else {
+        std::vector<blob_session::blob_id_type> ids{};
+        ids.reserve(missed.size());
+        for (auto i : missed) {
+            ids.emplace_back(blob_ids[i]);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        std::vector<blob_session::blob_path_type> missed_paths(missed.size());
+        api_.get_paths()(ids.data(), ids.size(), missed_paths.data());
+        for (std::size_t j = 0; j < missed.size(); j++) {
+            paths[missed[j]] = std::move(missed_paths[j]);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+    }
+    for (auto i : missed) {
+        std::error_code ec{};
+        bool exists = std::filesystem::exists(paths[i], ec);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        path_cache_.insert(blob_ids[i], path_cache::entry{paths[i], exists});  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+}
+
 blob_session::blob_id_type blob_session_manager::get_new_blob_id() {
-    return blob_id_.fetch_add(1) + 1;
+    auto blob_id = blob_id_.fetch_add(1) + 1;
+    if (index_) {
+        index_->assign_blob_id(blob_id);
+    }
+    return blob_id;
+}
+
+// returns the first of the consecutive BLOB IDs assigned
+blob_session::blob_id_type blob_session_manager::get_new_blob_ids(std::size_t count) {
+    auto blob_id = blob_id_.fetch_add(count) + 1;
+    if (index_ && count > 0) {
+        index_->assign_blob_id(blob_id + count - 1);
+    }
+    return blob_id;
 }
 
 blob_session::blob_tag_type blob_session_manager::generate_reference_tag(blob_session::blob_id_type blob_id, blob_session::session_id_type session_id) {
+    trace_scope_name("generate_reference_tag");
     VLOG_LP(log_debug) << "invoke generate_reference_tag of tag_generator with session_id = " << session_id_ << ", blob_id = " << blob_id;
     return tag_generator_.generate_reference_tag(blob_id, session_id);
 }
 
+void blob_session_manager::generate_reference_tags(const blob_session::blob_id_type* blob_ids, std::size_t count, blob_session::session_id_type session_id, blob_session::blob_tag_type* tags) {
+    trace_scope_name("generate_reference_tags");
+    trace_scope_value(count);
+    VLOG_LP(log_debug) << "invoke generate_reference_tags of tag_generator with session_id = " << session_id << " for " << count << " BLOBs";
+    tag_generator_.generate_reference_tags(blob_ids, count, session_id, tags);
+}
+
 std::size_t blob_session_manager::session_store_current_size() const noexcept {
     return session_store_.current_size();
 }
 
+std::size_t blob_session_manager::session_store_quota() const noexcept {
+    return session_store_.quota();
+}
+
+session_statistics blob_session_manager::statistics() const {
+    // the sessions are examined outside the locks of the shards
+    std::vector<std::shared_ptr<blob_session_impl>> sessions{};
+    blob_sessions_.for_each([&sessions](blob_session::session_id_type, const blob_session& e){ sessions.emplace_back(e.impl_); });
+    session_statistics rv{};
+    rv.sessions = sessions.size();
+    for (auto&& e : sessions) {
+        auto n = e->blob_count();
+        rv.blobs += n;
+        rv.max_blobs_per_session = std::max(rv.max_blobs_per_session, n);
+    }
+    return rv;
+}
+
+const quota_admission& blob_session_manager::admission(std::size_t stripe_id) const noexcept {
+    return session_store_.admission(stripe_id);
+}
+
+std::size_t blob_session_manager::memory_tier_threshold() const noexcept {
+    return session_store_.memory_tier_threshold();
+}
+
+std::size_t blob_session_manager::memory_tier_usage() const noexcept {
+    return session_store_.memory_tier_usage();
+}
+
+std::size_t blob_session_manager::segment_threshold() const noexcept {
+    return session_store_.segment_threshold();
+}
+
+const segment_store* blob_session_manager::segments() const noexcept {
+    return session_store_.segments();
+}
+
+std::size_t blob_session_manager::pending_deletions() const noexcept {
+    return reclaimer_.pending();
+}
+
+void blob_session_manager::wait_deletions() {
+    reclaimer_.wait_idle();
+}
+
 } // namespace
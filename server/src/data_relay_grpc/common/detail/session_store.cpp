@@ -0,0 +1,295 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <limits>
+
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+#include "data_relay_grpc/logging_helper.h"
+#include "data_relay_grpc/logging.h"
+
+#include <data_relay_grpc/common/detail/session_store.h>
+
+namespace data_relay_grpc::common::detail {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// the trash directory in the session store, which the files left are moved into
+constexpr std::string_view in_store_trash_name = ".trash";
+
+std::string generation_name() {
+    return std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + "-" + std::to_string(::getpid());
+}
+
+bool has_entries(const fs::path& directory) {
+    for (const fs::directory_entry& itr : fs::directory_iterator(directory)) {
+        if (itr.path().filename() != in_store_trash_name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// removes the directory only if it is an empty directory
+void remove_empty_directory(const fs::path& directory) {
+    ::rmdir(directory.c_str());
+}
+
+void list_generations(const fs::path& root, std::vector<fs::path>& generations) {
+    std::error_code ec{};
+    if (!fs::is_directory(root, ec)) {
+        return;
+    }
+    for (fs::directory_iterator itr(root, ec), end{}; !ec && itr != end; itr.increment(ec)) {
+        generations.emplace_back(itr->path());
+    }
+}
+
+} // namespace
+
+blob_session_store::blob_session_store(const std::string& directory, std::size_t quota)
+    : blob_session_store(directory, quota, 0) {
+}
+
+blob_session_store::blob_session_store(const std::string& directory, std::size_t quota, std::size_t cleanup_threads)
+    : blob_session_store(directory, quota, cleanup_threads, false) {
+}
+
+blob_session_store::blob_session_store(const std::string& directory, std::size_t quota, std::size_t cleanup_threads, bool keep_files)
+    : blob_session_store(std::vector<fs::path>{directory}, quota, cleanup_threads, keep_files, stripe_placement::round_robin) {
+}
+
+blob_session_store::blob_session_store(const std::vector<fs::path>& directories, std::size_t quota, std::size_t cleanup_threads, bool keep_files, stripe_placement placement)
+    : directory_(directories.empty() ? fs::path{} : directories.front()), placement_(placement) {
+    if (directories.empty() || directories.size() > std::numeric_limits<stripe_id_type>::max() + 1UL) {
+        throw std::runtime_error("the number of the session store directories must be between 1 and 256");
+    }
+    for (std::size_t i = 0; i < directories.size(); i++) {
+        const auto& directory = directories.at(i);
+        check_directory(directory);
+        // the remainder of the quota is given to the primary directory
+        auto share = quota / directories.size() + (i == 0 ? quota % directories.size() : 0);
+        stripes_.emplace_back(stripe{directory, std::make_unique<quota_accountant>(share), std::make_unique<quota_admission>()});
+    }
+
+    if (cleanup_threads == 0) {
+        for (auto&& e : stripes_) {
+            if (!keep_files) {
+                remove_entries(e.directory);
+            }
+            list_generations(e.directory / in_store_trash_name, trash_);
+        }
+        purge_trash();
+        return;
+    }
+
+    for (auto&& e : stripes_) {
+        if (!keep_files) {
+            move_to_trash(e.directory);
+        }
+        list_generations(e.directory / in_store_trash_name, trash_);
+    }
+    if (trash_.empty()) {
+        return;
+    }
+    VLOG_LP(log_info) << "start purging " << trash_.size() << " generations of files left in the session store (" << directory_.string() << ") in background";
+    active_cleanup_threads_ = cleanup_threads;
+    cleanup_threads_.reserve(cleanup_threads);
+    for (std::size_t i = 0; i < cleanup_threads; i++) {
+        cleanup_threads_.emplace_back([this]{ purge_trash(); });
+    }
+}
+
+blob_session_store::~blob_session_store() {
+    stop_cleanup_ = true;
+    wait_cleanup();
+}
+
+void blob_session_store::wait_cleanup() {
+    for (auto&& e : cleanup_threads_) {
+        if (e.joinable()) {
+            e.join();
+        }
+    }
+}
+
+void blob_session_store::check_directory(const fs::path& directory) {
+    if (!fs::exists(directory)) {
+        throw std::runtime_error(directory.string() + " does not exists");
+    }
+    fs::file_status status = fs::status(directory);
+    if (status.type() != fs::file_type::directory &&
+        !(status.type() == fs::file_type::symlink && fs::symlink_status(directory).type() == fs::file_type::directory)) {
+        throw std::runtime_error(directory.string() + " is not a directory");
+    }
+    fs::perms perm = status.permissions();
+    if ((perm & (fs::perms::owner_write | fs::perms::group_write | fs::perms::others_write)) == fs::perms::none) {
+        throw std::runtime_error(directory.string() + " is not writable");
+    }
+}
+
+void blob_session_store::remove_entries(const fs::path& directory) {
+    for (const fs::directory_entry& itr : fs::directory_iterator(directory)) {
+        std::error_code ec;
+        fs::remove_all(itr.path(), ec);
+        if (ec) {
+            throw std::runtime_error(itr.path().string() + "remains in the session store directory (" + directory.string() + ")");
+        }
+    }
+}
+
+void blob_session_store::move_to_trash(const fs::path& directory) {
+    if (!has_entries(directory)) {
+        return;
+    }
+
+    // the directory itself is kept as it is with its owner, permissions and so on, and only the entries are moved
+    auto generation = directory / in_store_trash_name / generation_name();
+    fs::create_directories(generation);
+    for (const fs::directory_entry& itr : fs::directory_iterator(directory)) {
+        if (itr.path().filename() == in_store_trash_name) {
+            continue;
+        }
+        std::error_code ec{};
+        fs::rename(itr.path(), generation / itr.path().filename(), ec);
+        if (ec) {
+            throw std::runtime_error(itr.path().string() + "remains in the session store directory (" + directory.string() + ")");
+        }
+    }
+    VLOG_LP(log_info) << "moved the files left in the session store to " << generation.string();
+}
+
+void blob_session_store::purge_trash() {
+    while (!stop_cleanup_) {
+        auto path_opt = next_trash_entry();
+        if (!path_opt) {
+            break;
+        }
+        std::error_code ec{};
+        fs::remove_all(path_opt.value(), ec);
+        if (ec) {
+            LOG_LP(ERROR) << "cannot delete " << path_opt.value().string() << ": " << ec.message();
+        }
+    }
+    if (stop_cleanup_ || (active_cleanup_threads_.load() > 0 && active_cleanup_threads_.fetch_sub(1) > 1)) {
+        return;
+    }
+
+    // the last thread removes the emptied directories
+    for (auto&& e : trash_) {
+        remove_empty_directory(e);
+    }
+    for (auto&& e : stripes_) {
+        remove_empty_directory(e.directory / in_store_trash_name);
+    }
+    if (trash_.empty()) {
+        return;
+    }
+    VLOG_LP(log_info) << "finished purging the files left in the session store (" << directory_.string() << ")";
+}
+
+void blob_session_store::fanout(std::size_t levels) {
+    if (levels > max_fanout_levels) {
+        throw std::runtime_error("the levels of the subdirectories of the session store must be up to " + std::to_string(max_fanout_levels));
+    }
+    // pre-create all the subdirectories, so that creating a BLOB file need not check its directory
+    constexpr std::size_t buckets = 256;
+    for (auto&& e : stripes_) {
+        std::vector<fs::path> parents{e.directory};
+        for (std::size_t level = 0; level < levels; level++) {
+            std::vector<fs::path> children{};
+            children.reserve(parents.size() * buckets);
+            for (auto&& parent : parents) {
+                for (std::size_t i = 0; i < buckets; i++) {
+                    auto child = parent / bucket_name(i);
+                    std::error_code ec{};
+                    fs::create_directory(child, ec);
+                    if (ec) {
+                        throw std::runtime_error("cannot create " + child.string() + ": " + ec.message());
+                    }
+                    children.emplace_back(std::move(child));
+                }
+            }
+            parents = std::move(children);
+        }
+    }
+    fanout_levels_ = levels;
+    if (levels > 0) {
+        VLOG_LP(log_info) << "the BLOB files are placed in " << levels << " levels of subdirectories in the session store";
+    }
+}
+
+blob_session_store::stripe_id_type blob_session_store::place(std::uint64_t blob_id) {
+    if (stripes_.size() == 1) {
+        return 0;
+    }
+    switch (placement_) {
+        case stripe_placement::least_used: {
+            std::size_t rv{};
+            std::uint64_t best{};
+            for (std::size_t i = 0; i < stripes_.size(); i++) {
+                auto& e = stripes_.at(i);
+                std::uint64_t score{};  // the larger, the better
+                if (auto quota = e.quota->quota(); quota != 0) {
+                    auto used = e.quota->used();
+                    score = used < quota ? quota - used : 0;
+                } else if (struct statvfs st{}; ::statvfs(e.directory.c_str(), &st) == 0) {
+                    score = static_cast<std::uint64_t>(st.f_bavail) * st.f_frsize;
+                }
+                if (i == 0 || score > best) {
+                    rv = i;
+                    best = score;
+                }
+            }
+            return static_cast<stripe_id_type>(rv);
+        }
+        case stripe_placement::hash: {
+            constexpr std::uint64_t multiplier = 0x9e3779b97f4a7c15ULL;
+            return static_cast<stripe_id_type>(((blob_id * multiplier) >> 32U) % stripes_.size());  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+        }
+        default:
+            return static_cast<stripe_id_type>(next_stripe_.fetch_add(1, std::memory_order_relaxed) % stripes_.size());
+    }
+}
+
+std::optional<fs::path> blob_session_store::next_trash_entry() {
+    std::lock_guard<std::mutex> lock(trash_mtx_);
+    while (trash_index_ < trash_.size()) {
+        std::error_code ec{};
+        if (!trash_opened_) {
+            trash_itr_ = fs::directory_iterator(trash_.at(trash_index_), ec);
+            trash_opened_ = true;
+        }
+        if (!ec && trash_itr_ != fs::directory_iterator{}) {
+            auto path = trash_itr_->path();
+            trash_itr_.increment(ec);
+            if (ec) {
+                trash_itr_ = fs::directory_iterator{};
+            }
+            return path;
+        }
+        ++trash_index_;
+        trash_opened_ = false;
+    }
+    return std::nullopt;
+}
+
+} // namespace
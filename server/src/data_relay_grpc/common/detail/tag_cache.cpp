@@ -0,0 +1,135 @@
+/*
+ * Copyright 2026-2026 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <data_relay_grpc/common/detail/tag_cache.h>
+
+namespace data_relay_grpc::common::detail {
+
+tag_cache::tag_cache(std::size_t capacity)
+    : capacity_(capacity), shard_capacity_((capacity + shard_count - 1) / shard_count) {
+}
+
+tag_cache::shard& tag_cache::shard_for(transaction_id_type transaction_id) noexcept {
+    // Fibonacci hashing, as the IDs are mostly sequential
+    constexpr std::uint64_t multiplier = 0x9e3779b97f4a7c15ULL;
+    auto index = static_cast<std::size_t>((transaction_id * multiplier) >> 32U) & (shard_count - 1);  // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+    return shards_[index];  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+}
+
+void tag_cache::open(transaction_id_type transaction_id) {
+    if (!enabled()) {
+        return;
+    }
+    auto& s = shard_for(transaction_id);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    auto [itr, inserted] = s.transactions.try_emplace(transaction_id);
+    if (inserted) {
+        itr->second.opened = s.opened++;
+    }
+    itr->second.sessions++;
+}
+
+void tag_cache::close(transaction_id_type transaction_id) {
+    if (!enabled()) {
+        return;
+    }
+    auto& s = shard_for(transaction_id);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    if (auto itr = s.transactions.find(transaction_id); itr != s.transactions.end() && --itr->second.sessions == 0) {
+        s.size -= itr->second.tags.size();
+        s.transactions.erase(itr);
+    }
+}
+
+std::optional<tag_cache::tag_type> tag_cache::find(blob_id_type blob_id, transaction_id_type transaction_id) {
+    if (!enabled()) {
+        return std::nullopt;
+    }
+    auto& s = shard_for(transaction_id);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    if (auto itr = s.transactions.find(transaction_id); itr != s.transactions.end()) {
+        if (auto tag_itr = itr->second.tags.find(blob_id); tag_itr != itr->second.tags.end()) {
+            s.hits++;
+            return tag_itr->second;
+        }
+    }
+    s.misses++;
+    return std::nullopt;
+}
+
+void tag_cache::insert(blob_id_type blob_id, transaction_id_type transaction_id, tag_type tag) {
+    if (!enabled()) {
+        return;
+    }
+    auto& s = shard_for(transaction_id);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    auto itr = s.transactions.find(transaction_id);
+    if (itr == s.transactions.end()) {
+        return;  // not opened, or already closed
+    }
+    if (itr->second.tags.find(blob_id) != itr->second.tags.end()) {
+        return;
+    }
+    if (s.size >= shard_capacity_) {
+        evict(s, transaction_id);
+    }
+    itr->second.tags.emplace(blob_id, tag);
+    s.size++;
+}
+
+// drops the tags of the transaction opened first except the one given, or of the one given if it is the only one
+void tag_cache::evict(shard& s, transaction_id_type keep) {
+    transaction_entry* victim{};
+    for (auto&& [transaction_id, e] : s.transactions) {
+        if (transaction_id != keep && !e.tags.empty() && (victim == nullptr || e.opened < victim->opened)) {
+            victim = &e;
+        }
+    }
+    if (victim == nullptr) {
+        victim = &s.transactions.at(keep);
+    }
+    s.size -= victim->tags.size();
+    victim->tags.clear();
+}
+
+std::uint64_t tag_cache::hits() const {
+    std::uint64_t rv{};
+    for (auto&& s : shards_) {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        rv += s.hits;
+    }
+    return rv;
+}
+
+std::uint64_t tag_cache::misses() const {
+    std::uint64_t rv{};
+    for (auto&& s : shards_) {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        rv += s.misses;
+    }
+    return rv;
+}
+
+std::size_t tag_cache::size() const {
+    std::size_t rv{};
+    for (auto&& s : shards_) {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        rv += s.size;
+    }
+    return rv;
+}
+
+} // namespace
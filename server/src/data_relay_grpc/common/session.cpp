@@ -14,14 +14,12 @@
  * limitations under the License.
  */
 
-#include <list>
-
 #include <data_relay_grpc/common/session.h>
 #include <data_relay_grpc/common/detail/session_impl.h>
 
 namespace data_relay_grpc::common {
 
-blob_session::blob_session(std::unique_ptr<blob_session_impl> impl) : impl_(std::move(impl)) {
+blob_session::blob_session(std::shared_ptr<blob_session_impl> impl) : impl_(std::move(impl)) {
 }
 
 blob_session::session_id_type blob_session::session_id() const noexcept {
@@ -36,6 +34,10 @@ blob_session::blob_id_type blob_session::add(blob_path_type path) {
     return impl_->add(path);
 }
 
+std::vector<blob_session::blob_id_type> blob_session::add(const blob_path_type* paths, std::size_t count) {
+    return impl_->add(paths, count);
+}
+
 std::optional<blob_session::blob_path_type> blob_session::find(blob_id_type blob_id) const {
     return impl_->find(blob_id);
 }
@@ -44,33 +46,20 @@ std::vector<blob_session::blob_id_type> blob_session::entries() const {
     return impl_->entries();
 }
 
-template<class Iter>
-void blob_session::remove(Iter, Iter) {
-    throw std::runtime_error("not supported");
+void blob_session::remove(const blob_id_type* blob_ids, std::size_t count) {
+    impl_->delete_blob_files(blob_ids, count);
 }
 
-using vector_iterator = std::vector<blob_session::blob_id_type>::iterator;
-template <>
-void blob_session::remove<vector_iterator>(vector_iterator blob_ids_begin, vector_iterator blob_ids_end) {
-    if (std::distance(blob_ids_begin, blob_ids_end) >= 0) {
-        for (auto i = blob_ids_begin; i != blob_ids_end; i++) {
-            impl_->delete_blob_file(*i);
-        }
-        return;
-    }
-    throw std::runtime_error("iterator begin is greather than iterator end");
+blob_session::blob_tag_type blob_session::compute_tag(blob_id_type blob_id) const {
+    return impl_->compute_tag(blob_id);
 }
 
-using list_iterator = std::list<blob_session::blob_id_type>::iterator;
-template <>
-void blob_session::remove<list_iterator>(list_iterator blob_ids_begin, list_iterator blob_ids_end) {
-    for (auto i = blob_ids_begin; i != blob_ids_end; i++) {
-        impl_->delete_blob_file(*i);
-    }
+void blob_session::compute_tags(const blob_id_type* blob_ids, std::size_t count, blob_tag_type* tags) const {
+    impl_->compute_tags(blob_ids, count, tags);
 }
 
-blob_session::blob_tag_type blob_session::compute_tag(blob_id_type blob_id) const {
-    return impl_->compute_tag(blob_id);
+void blob_session::get_tags(const blob_id_type* blob_ids, std::size_t count, blob_tag_type* tags) const {
+    impl_->get_tags(blob_ids, count, tags);
 }
 
 } // namespace
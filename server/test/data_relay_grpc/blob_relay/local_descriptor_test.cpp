@@ -0,0 +1,323 @@
+#include <grpcpp/grpcpp.h>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <exception>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "test_root.h"
+#include "data_relay_grpc/grpc/grpc_server_test_base.h"
+
+#include "data_relay_grpc/blob_relay/service_impl.h"
+#include <data_relay_grpc/blob_relay/api_version.h>
+#include "data_relay_grpc/blob_relay/local_service.h"
+
+namespace data_relay_grpc::blob_relay {
+
+class local_descriptor_test : public data_relay_grpc::grpc::grpc_server_test_base {
+protected:
+    const std::string test_partial_blob{"ABCDEFGHIJKLMNOPQRSTUBWXYZabcdefghijklmnopqrstubwxyz\n"};
+    const std::string session_store_name{"session_store"};
+    const std::uint64_t transaction_id_for_test = 12345;
+    const std::uint64_t tag_for_test = 2468;
+
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("local_descriptor_test")};
+    blob_session* session_{};
+    std::filesystem::path socket_path_{};
+
+    void SetUp() override {
+        data_relay_grpc::grpc::grpc_server_test_base::SetUp();
+        helper_->set_up();
+        std::filesystem::create_directory(helper_->path(session_store_name));
+        socket_path_ = helper_->path("relay.sock");
+        service_configuration conf{
+            helper_->path(session_store_name),  // session_store
+            0,                                  // session_quota_size
+            true,                               // local_enabled
+            true,                               // local_upload_copy_file
+            32,                                 // stream_chunk_size
+            false                               // dev_accept_mock_tag
+        };
+        conf.local_socket_path(socket_path_);
+        service_ = std::make_unique<blob_relay_service_impl>(api_for_test, conf);
+        set_service_handler([this](::grpc::ServerBuilder& builder) {
+            for(auto&& e: service_->services()) {
+                builder.RegisterService(e);
+            }
+        });
+        session_ = &service_->create_session(transaction_id_for_test);
+    }
+
+    void TearDown() override {
+        service_.reset();
+        helper_->tear_down();
+        data_relay_grpc::grpc::grpc_server_test_base::TearDown();
+    }
+
+    std::filesystem::path create_blob_data(const std::string& name) {
+        std::filesystem::path path = helper_->path(name);
+        std::ofstream strm(path);
+        strm << expected_contents();
+        strm.close();
+        return path;
+    }
+
+    std::string expected_contents() {
+        std::stringstream ss{};
+        for (int i = 0; i < 10; i++ ) {
+            ss << test_partial_blob;
+        }
+        return ss.str();
+    }
+
+    int connect_relay() {
+        int sock = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, socket_path_.c_str(), sizeof(addr.sun_path) - 1);
+        if (::connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(sock);
+            throw std::runtime_error("cannot connect to the descriptor relay");
+        }
+        return sock;
+    }
+
+    // sends a descriptor and returns the token
+    std::uint64_t send_descriptor(int fd) {
+        int sock = connect_relay();
+        std::array<char, 9> req{'P'};
+        iovec iov{req.data(), req.size()};
+        alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control{};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+        cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(c), &fd, sizeof(fd));
+        EXPECT_EQ(::sendmsg(sock, &msg, 0), req.size());
+
+        std::array<char, 9> res{};
+        EXPECT_EQ(::recv(sock, res.data(), res.size(), MSG_WAITALL), res.size());
+        ::close(sock);
+        EXPECT_EQ(res[0], 0);
+        std::uint64_t token{};
+        std::memcpy(&token, res.data() + 1, sizeof(token));
+        return token;
+    }
+
+    // receives the descriptor by the token, or returns -1
+    int receive_descriptor(std::uint64_t token) {
+        int sock = connect_relay();
+        std::array<char, 9> req{'G'};
+        std::memcpy(req.data() + 1, &token, sizeof(token));
+        EXPECT_EQ(::send(sock, req.data(), req.size(), 0), req.size());
+
+        char status{};
+        iovec iov{&status, sizeof(status)};
+        alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control{};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+        int fd = -1;
+        if (::recvmsg(sock, &msg, 0) == 1 && status == 0) {
+            if (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr && c->cmsg_type == SCM_RIGHTS) {
+                std::memcpy(&fd, CMSG_DATA(c), sizeof(fd));
+            }
+        }
+        ::close(sock);
+        return fd;
+    }
+
+    std::string contents(int fd) {
+        std::string s{};
+        std::array<char, 256> buf{};
+        ssize_t n{};
+        while ((n = ::read(fd, buf.data(), buf.size())) > 0) {
+            s.append(buf.data(), n);
+        }
+        return s;
+    }
+
+    std::string contents(const std::filesystem::path& path) {
+        std::ifstream ifs(path);
+        return {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+    }
+
+private:
+    common::api api_for_test{
+        [this](std::uint64_t bid, std::uint64_t tid) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t bid){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<blob_relay_service_impl> service_{};
+};
+
+TEST_F(local_descriptor_test, put) {
+    start_server();
+    auto source = create_blob_data("blob-put");
+    int fd = ::open(source.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    auto token = send_descriptor(fd);
+    ::close(fd);
+
+    auto channel = ::grpc::CreateChannel(server_address_, ::grpc::InsecureChannelCredentials());
+    BlobRelayLocal::Stub stub(channel);
+    ::grpc::ClientContext context;
+    PutLocalRequest req;
+    req.set_api_version(BLOB_RELAY_API_VERSION);
+    req.set_session_id(session_->session_id());
+    req.mutable_data()->mutable_handoff()->set_token(token);
+    PutLocalResponse res;
+    auto status = stub.Put(&context, req, &res);
+    ASSERT_EQ(status.error_code(), ::grpc::StatusCode::OK);
+
+    auto path_opt = session_->find(res.blob().object_id());
+    ASSERT_TRUE(path_opt);
+    EXPECT_EQ(contents(path_opt.value()), expected_contents());
+    EXPECT_EQ(contents(source), expected_contents());
+}
+
+TEST_F(local_descriptor_test, put_unknown_token) {
+    start_server();
+
+    auto channel = ::grpc::CreateChannel(server_address_, ::grpc::InsecureChannelCredentials());
+    BlobRelayLocal::Stub stub(channel);
+    ::grpc::ClientContext context;
+    PutLocalRequest req;
+    req.set_api_version(BLOB_RELAY_API_VERSION);
+    req.set_session_id(session_->session_id());
+    req.mutable_data()->mutable_handoff()->set_token(1);
+    PutLocalResponse res;
+    auto status = stub.Put(&context, req, &res);
+    EXPECT_EQ(status.error_code(), ::grpc::StatusCode::NOT_FOUND);
+    EXPECT_TRUE(session_->entries().empty());
+}
+
+TEST_F(local_descriptor_test, get) {
+    start_server();
+    create_blob_data("blob-get");
+
+    auto channel = ::grpc::CreateChannel(server_address_, ::grpc::InsecureChannelCredentials());
+    BlobRelayLocal::Stub stub(channel);
+    ::grpc::ClientContext context;
+    GetLocalRequest req;
+    req.set_api_version(BLOB_RELAY_API_VERSION);
+    req.set_session_id(session_->session_id());
+    req.set_prefer_descriptor(true);
+    auto* blob = req.mutable_blob();
+    blob->set_storage_id(1);
+    blob->set_object_id(1);
+    blob->set_tag(tag_for_test);
+    GetLocalResponse res;
+    auto status = stub.Get(&context, req, &res);
+    ASSERT_EQ(status.error_code(), ::grpc::StatusCode::OK);
+    ASSERT_EQ(res.data().location_case(), BlobFile::LocationCase::kHandoff);
+    EXPECT_EQ(res.data().handoff().socket_path(), socket_path_.string());
+
+    int fd = receive_descriptor(res.data().handoff().token());
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(contents(fd), expected_contents());
+    ::close(fd);
+
+    // the token is valid only once
+    EXPECT_LT(receive_descriptor(res.data().handoff().token()), 0);
+}
+
+TEST_F(local_descriptor_test, memfd) {
+    start_server();
+    int memfd = ::memfd_create("local_descriptor_test", MFD_ALLOW_SEALING);
+    ASSERT_GE(memfd, 0);
+    auto data = expected_contents();
+    ASSERT_EQ(::write(memfd, data.data(), data.size()), data.size());
+    auto token = send_descriptor(memfd);
+
+    auto channel = ::grpc::CreateChannel(server_address_, ::grpc::InsecureChannelCredentials());
+    BlobRelayLocal::Stub stub(channel);
+    PutLocalResponse put_res;
+    {
+        ::grpc::ClientContext context;
+        PutLocalRequest req;
+        req.set_api_version(BLOB_RELAY_API_VERSION);
+        req.set_session_id(session_->session_id());
+        req.mutable_data()->mutable_handoff()->set_token(token);
+        auto status = stub.Put(&context, req, &put_res);
+        ASSERT_EQ(status.error_code(), ::grpc::StatusCode::OK);
+    }
+
+    // adopted and sealed without creating a file in the session store
+    EXPECT_NE(::fcntl(memfd, F_GET_SEALS) & F_SEAL_WRITE, 0);
+    EXPECT_LT(::write(memfd, data.data(), data.size()), 0);
+    ::close(memfd);
+    EXPECT_TRUE(std::filesystem::is_empty(helper_->path(session_store_name)));
+    auto path_opt = session_->find(put_res.blob().object_id());
+    ASSERT_TRUE(path_opt);
+    EXPECT_EQ(contents(path_opt.value()), expected_contents());
+
+    {
+        ::grpc::ClientContext context;
+        GetLocalRequest req;
+        req.set_api_version(BLOB_RELAY_API_VERSION);
+        req.set_session_id(session_->session_id());
+        req.set_prefer_descriptor(true);
+        auto* blob = req.mutable_blob();
+        blob->set_storage_id(0);
+        blob->set_object_id(put_res.blob().object_id());
+        blob->set_tag(tag_for_test);
+        GetLocalResponse res;
+        auto status = stub.Get(&context, req, &res);
+        ASSERT_EQ(status.error_code(), ::grpc::StatusCode::OK);
+        ASSERT_EQ(res.data().location_case(), BlobFile::LocationCase::kHandoff);
+
+        int fd = receive_descriptor(res.data().handoff().token());
+        ASSERT_GE(fd, 0);
+        EXPECT_EQ(contents(fd), expected_contents());
+        ::close(fd);
+    }
+
+    std::vector<blob_session::blob_id_type> bids{put_res.blob().object_id()};
+    session_->remove(bids.begin(), bids.end());
+    EXPECT_FALSE(session_->find(put_res.blob().object_id()));
+}
+
+TEST_F(local_descriptor_test, socket_mode) {
+    start_server();
+    EXPECT_EQ(std::filesystem::status(socket_path_).permissions(),
+              std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+}
+
+TEST_F(local_descriptor_test, slow_peer) {
+    start_server();
+    auto source = create_blob_data("blob-slow");
+
+    // a peer connecting without sending the request does not delay the others
+    int idle = connect_relay();
+    auto start = std::chrono::steady_clock::now();
+    int fd = ::open(source.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    auto token = send_descriptor(fd);
+    ::close(fd);
+    EXPECT_NE(token, 0);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    ::close(idle);
+}
+
+} // namespace
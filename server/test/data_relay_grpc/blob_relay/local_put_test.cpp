@@ -0,0 +1,211 @@
+#include <grpcpp/grpcpp.h>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <exception>
+
+#include <sys/stat.h>
+
+#include "test_root.h"
+#include "data_relay_grpc/grpc/grpc_server_test_base.h"
+
+#include "data_relay_grpc/blob_relay/service_impl.h"
+#include <data_relay_grpc/blob_relay/api_version.h>
+#include "data_relay_grpc/blob_relay/local_service.h"
+
+namespace data_relay_grpc::blob_relay {
+
+class local_put_test : public data_relay_grpc::grpc::grpc_server_test_base {
+protected:
+    const std::string test_partial_blob{"ABCDEFGHIJKLMNOPQRSTUBWXYZabcdefghijklmnopqrstubwxyz\n"};
+    const std::string session_store_name{"session_store"};
+    const std::uint64_t transaction_id_for_test = 12345;
+    const std::uint64_t tag_for_test = 2468;
+
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("local_put_test")};
+    blob_session* session_{};
+
+    void SetUp() override {
+        data_relay_grpc::grpc::grpc_server_test_base::SetUp();
+        helper_->set_up();
+        std::filesystem::create_directory(helper_->path(session_store_name));
+        service_ = std::make_unique<blob_relay_service_impl>(
+            api_for_test,
+            service_configuration{
+                helper_->path(session_store_name),  // session_store
+                0,                                  // session_quota_size
+                true,                               // local_enabled
+                false,                              // local_upload_copy_file
+                32,                                 // stream_chunk_size
+                false                               // dev_accept_mock_tag
+            }
+        );
+        set_service_handler([this](::grpc::ServerBuilder& builder) {
+            for(auto&& e: service_->services()) {
+                builder.RegisterService(e);
+            }
+        });
+        session_ = &service_->create_session(transaction_id_for_test);
+    }
+
+    void TearDown() override {
+        helper_->tear_down();
+        data_relay_grpc::grpc::grpc_server_test_base::TearDown();
+    }
+
+    std::filesystem::path create_blob_data(const std::string& name) {
+        std::filesystem::path path = helper_->path(name);
+        std::ofstream strm(path);
+        for (int i = 0; i < 10; i++ ) {
+            strm << test_partial_blob;
+        }
+        strm.close();
+        return path;
+    }
+
+    ::grpc::Status put(const std::filesystem::path& path, LocalUploadPlacement placement, PutLocalResponse& res) {
+        auto channel = ::grpc::CreateChannel(server_address_, ::grpc::InsecureChannelCredentials());
+        BlobRelayLocal::Stub stub(channel);
+        ::grpc::ClientContext context;
+        PutLocalRequest req;
+        req.set_api_version(BLOB_RELAY_API_VERSION);
+        req.set_session_id(session_->session_id());
+        req.mutable_data()->set_path(path.string());
+        req.set_placement(placement);
+        return stub.Put(&context, req, &res);
+    }
+
+    std::string contents(const std::filesystem::path& path) {
+        std::ifstream ifs(path);
+        return {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+    }
+
+    std::string expected_contents() {
+        std::stringstream ss{};
+        for (int i = 0; i < 10; i++ ) {
+            ss << test_partial_blob;
+        }
+        return ss.str();
+    }
+
+private:
+    common::api api_for_test{
+        [this](std::uint64_t bid, std::uint64_t tid) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t bid){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<blob_relay_service_impl> service_{};
+};
+
+TEST_F(local_put_test, automatic) {
+    start_server();
+    auto source = create_blob_data("blob-automatic");
+
+    PutLocalResponse res;
+    auto status = put(source, LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_UNSPECIFIED, res);
+    ASSERT_EQ(status.error_code(), ::grpc::StatusCode::OK);
+
+    // the file of the client is left as it is
+    auto path_opt = session_->find(res.blob().object_id());
+    ASSERT_TRUE(path_opt);
+    ASSERT_TRUE(std::filesystem::exists(source));
+    EXPECT_TRUE(std::filesystem::equivalent(source, path_opt.value()));
+    EXPECT_EQ(contents(path_opt.value()), expected_contents());
+}
+
+TEST_F(local_put_test, move) {
+    start_server();
+    auto source = create_blob_data("blob-move");
+
+    PutLocalResponse res;
+    auto status = put(source, LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_MOVE, res);
+    ASSERT_EQ(status.error_code(), ::grpc::StatusCode::OK);
+
+    auto path_opt = session_->find(res.blob().object_id());
+    ASSERT_TRUE(path_opt);
+    EXPECT_FALSE(std::filesystem::exists(source));
+    EXPECT_EQ(contents(path_opt.value()), expected_contents());
+}
+
+TEST_F(local_put_test, move_symlink) {
+    start_server();
+    auto target = create_blob_data("blob-target");
+    auto source = helper_->path("blob-symlink");
+    std::filesystem::create_symlink(target, source);
+
+    PutLocalResponse res;
+    auto status = put(source, LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_MOVE, res);
+    EXPECT_EQ(status.error_code(), ::grpc::StatusCode::FAILED_PRECONDITION);
+    EXPECT_TRUE(session_->entries().empty());
+    EXPECT_TRUE(std::filesystem::is_symlink(source));
+    EXPECT_EQ(contents(target), expected_contents());
+
+    // the file linked is placed unless it is moved
+    status = put(source, LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_UNSPECIFIED, res);
+    ASSERT_EQ(status.error_code(), ::grpc::StatusCode::OK);
+    auto path_opt = session_->find(res.blob().object_id());
+    ASSERT_TRUE(path_opt);
+    EXPECT_TRUE(std::filesystem::equivalent(target, path_opt.value()));
+    EXPECT_TRUE(std::filesystem::is_symlink(source));
+}
+
+TEST_F(local_put_test, hardlink) {
+    start_server();
+    auto source = create_blob_data("blob-hardlink");
+
+    PutLocalResponse res;
+    auto status = put(source, LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_HARDLINK, res);
+    ASSERT_EQ(status.error_code(), ::grpc::StatusCode::OK);
+
+    auto path_opt = session_->find(res.blob().object_id());
+    ASSERT_TRUE(path_opt);
+    ASSERT_TRUE(std::filesystem::exists(source));
+    EXPECT_TRUE(std::filesystem::equivalent(source, path_opt.value()));
+    EXPECT_EQ(contents(path_opt.value()), expected_contents());
+}
+
+TEST_F(local_put_test, copy) {
+    start_server();
+    auto source = create_blob_data("blob-copy");
+
+    PutLocalResponse res;
+    auto status = put(source, LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_COPY, res);
+    ASSERT_EQ(status.error_code(), ::grpc::StatusCode::OK);
+
+    auto path_opt = session_->find(res.blob().object_id());
+    ASSERT_TRUE(path_opt);
+    ASSERT_TRUE(std::filesystem::exists(source));
+    EXPECT_FALSE(std::filesystem::equivalent(source, path_opt.value()));
+    EXPECT_EQ(contents(path_opt.value()), expected_contents());
+    EXPECT_EQ(contents(source), expected_contents());
+}
+
+TEST_F(local_put_test, reflink_or_fallback) {
+    start_server();
+    auto source = create_blob_data("blob-reflink");
+
+    PutLocalResponse res;
+    auto status = put(source, LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_REFLINK, res);
+    ASSERT_EQ(status.error_code(), ::grpc::StatusCode::OK);
+
+    auto path_opt = session_->find(res.blob().object_id());
+    ASSERT_TRUE(path_opt);
+    ASSERT_TRUE(std::filesystem::exists(source));
+    EXPECT_EQ(contents(path_opt.value()), expected_contents());
+}
+
+TEST_F(local_put_test, not_exist) {
+    start_server();
+
+    PutLocalResponse res;
+    auto status = put(helper_->path("blob-not-exist"), LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_UNSPECIFIED, res);
+    EXPECT_EQ(status.error_code(), ::grpc::StatusCode::FAILED_PRECONDITION);
+    EXPECT_TRUE(session_->entries().empty());
+}
+
+} // namespace
@@ -0,0 +1,128 @@
+#include <grpcpp/grpcpp.h>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <exception>
+
+#include "test_root.h"
+#include "data_relay_grpc/grpc/grpc_server_test_base.h"
+
+#include "data_relay_grpc/blob_relay/service_impl.h"
+#include <data_relay_grpc/blob_relay/api_version.h>
+#include "data_relay_grpc/blob_relay/local_service.h"
+
+namespace data_relay_grpc::blob_relay {
+
+class local_quota_test : public data_relay_grpc::grpc::grpc_server_test_base {
+protected:
+    const std::string test_partial_blob{"ABCDEFGHIJKLMNOPQRSTUBWXYZabcdefghijklmnopqrstubwxyz\n"};
+    const std::string session_store_name{"session_store"};
+    const std::uint64_t quota_size_for_test = 1024;
+    const std::uint64_t transaction_id_for_test = 12345;
+    const std::uint64_t tag_for_test = 2468;
+    const std::uint64_t loop_count = 10;
+
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("local_quota_test")};
+
+    void SetUp() override {
+        data_relay_grpc::grpc::grpc_server_test_base::SetUp();
+        helper_->set_up();
+        std::filesystem::create_directory(helper_->path(session_store_name));
+    }
+
+    void TearDown() override {
+        helper_->tear_down();
+        data_relay_grpc::grpc::grpc_server_test_base::TearDown();
+    }
+
+    void start(std::size_t session_quota_size, std::size_t per_session_quota_size) {
+        service_configuration conf{
+            helper_->path(session_store_name),  // session_store
+            session_quota_size,                 // session_quota_size
+            true,                               // local_enabled
+            false,                              // local_upload_copy_file
+            32,                                 // stream_chunk_size
+            false                               // dev_accept_mock_tag
+        };
+        conf.per_session_quota_size(per_session_quota_size);
+        service_ = std::make_unique<blob_relay_service_impl>(api_for_test, conf);
+        set_service_handler([this](::grpc::ServerBuilder& builder) {
+            for(auto&& e: service_->services()) {
+                builder.RegisterService(e);
+            }
+        });
+        session_ = &service_->create_session(transaction_id_for_test);
+        start_server();
+    }
+
+    std::filesystem::path create_blob_data(const std::string& name) {
+        std::filesystem::path path = helper_->path(name);
+        std::ofstream strm(path);
+        for (std::uint64_t i = 0; i < loop_count; i++ ) {
+            strm << test_partial_blob;
+        }
+        strm.close();
+        return path;
+    }
+
+    ::grpc::Status put(blob_session& session, const std::filesystem::path& path, PutLocalResponse& res) {
+        auto channel = ::grpc::CreateChannel(server_address_, ::grpc::InsecureChannelCredentials());
+        BlobRelayLocal::Stub stub(channel);
+        ::grpc::ClientContext context;
+        PutLocalRequest req;
+        req.set_api_version(BLOB_RELAY_API_VERSION);
+        req.set_session_id(session.session_id());
+        req.mutable_data()->set_path(path.string());
+        req.set_placement(LocalUploadPlacement::LOCAL_UPLOAD_PLACEMENT_MOVE);
+        return stub.Put(&context, req, &res);
+    }
+
+    std::unique_ptr<blob_relay_service_impl> service_{};
+    blob_session* session_{};
+
+private:
+    common::api api_for_test{
+        [this](std::uint64_t, std::uint64_t) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t){
+            return helper_->last_path();
+        }
+    };
+};
+
+TEST_F(local_quota_test, store_quota) {
+    start(quota_size_for_test, 0);
+    auto blob_size = loop_count * test_partial_blob.length();
+
+    PutLocalResponse res;
+    EXPECT_EQ(put(*session_, create_blob_data("blob-1"), res).error_code(), ::grpc::StatusCode::OK);
+    EXPECT_EQ(service_->get_session_manager().session_store_current_size(), blob_size);
+
+    // the file exceeding the quota is left where it was
+    auto source = create_blob_data("blob-2");
+    EXPECT_EQ(put(*session_, source, res).error_code(), ::grpc::StatusCode::RESOURCE_EXHAUSTED);
+    EXPECT_TRUE(std::filesystem::exists(source));
+    EXPECT_EQ(session_->entries().size(), 1);
+    EXPECT_EQ(service_->get_session_manager().session_store_current_size(), blob_size);
+
+    // the usage is released by removing the BLOB
+    session_->remove(session_->entries());
+    EXPECT_EQ(put(*session_, source, res).error_code(), ::grpc::StatusCode::OK);
+}
+
+TEST_F(local_quota_test, session_quota) {
+    start(0, quota_size_for_test);
+    auto& other = service_->create_session(std::nullopt);
+
+    PutLocalResponse res;
+    EXPECT_EQ(put(*session_, create_blob_data("blob-1"), res).error_code(), ::grpc::StatusCode::OK);
+    auto status = put(*session_, create_blob_data("blob-2"), res);
+    EXPECT_EQ(status.error_code(), ::grpc::StatusCode::RESOURCE_EXHAUSTED);
+    EXPECT_EQ(status.error_message(), common::detail::quota_exceeded_message(common::detail::quota_level::session));
+
+    // the other session has its own quota
+    EXPECT_EQ(put(other, create_blob_data("blob-3"), res).error_code(), ::grpc::StatusCode::OK);
+}
+
+} // namespace
@@ -0,0 +1,150 @@
+#include <grpcpp/grpcpp.h>
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <atomic>
+
+#include "test_root.h"
+#include "data_relay_grpc/grpc/grpc_server_test_base.h"
+
+#include "data_relay_grpc/blob_relay/service_impl.h"
+#include <data_relay_grpc/blob_relay/api_version.h>
+#include "data_relay_grpc/blob_relay/streaming_service.h"
+#include "data_relay_grpc/blob_relay/stats_service.h"
+
+namespace data_relay_grpc::blob_relay {
+
+class stats_service_test : public data_relay_grpc::grpc::grpc_server_test_base {
+protected:
+    const std::string test_partial_blob{"ABCDEFGHIJKLMNOPQRSTUBWXYZabcdefghijklmnopqrstubwxyz\n"};
+    const std::string session_store_name{"session_store"};
+    const std::uint64_t transaction_id_for_test = 12345;
+    const std::uint64_t tag_for_test = 2468;
+    std::uint64_t blob_id_for_test{};
+
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("stats_service_test")};
+    blob_session* session_{};
+
+    void SetUp() override {
+        data_relay_grpc::grpc::grpc_server_test_base::SetUp();
+        helper_->set_up();
+        std::filesystem::create_directory(helper_->path(session_store_name));
+        service_ = std::make_unique<blob_relay_service_impl>(
+            api_for_test,
+            service_configuration{
+                helper_->path(session_store_name),  // session_store
+                0,                                  // session_quota_size
+                false,                              // local_enabled
+                false,                              // local_upload_copy_file
+                32,                                 // stream_chunk_size
+                false                               // dev_accept_mock_tag
+            }
+        );
+        set_service_handler([this](::grpc::ServerBuilder& builder) {
+            for(auto&& e: service_->services()) {
+                builder.RegisterService(e);
+            }
+        });
+        session_ = &service_->create_session(transaction_id_for_test);
+    }
+
+    void TearDown() override {
+        helper_->tear_down();
+        data_relay_grpc::grpc::grpc_server_test_base::TearDown();
+    }
+
+    void set_blob_data() {
+        std::filesystem::path path = helper_->path(std::string("blob-") + std::to_string(++blob_id_));
+        std::ofstream strm(path);
+        for (int i = 0; i < 10; i++ ) {
+            strm << test_partial_blob;
+        }
+        strm.close();
+        blob_id_for_test = session_->add(path);
+    }
+
+    GetStatsResponse get_stats(bool prometheus) {
+        auto channel = ::grpc::CreateChannel(server_address_, ::grpc::InsecureChannelCredentials());
+        BlobRelayStats::Stub stub(channel);
+        ::grpc::ClientContext context;
+        GetStatsRequest req;
+        req.set_api_version(BLOB_RELAY_API_VERSION);
+        req.set_prometheus(prometheus);
+        GetStatsResponse resp;
+        ::grpc::Status status = stub.GetStats(&context, req, &resp);
+        EXPECT_EQ(status.error_code(), ::grpc::StatusCode::OK);
+        return resp;
+    }
+
+private:
+    common::api api_for_test{
+        [this](std::uint64_t, std::uint64_t) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<blob_relay_service_impl> service_{};
+    std::atomic_uint64_t blob_id_{};
+};
+
+TEST_F(stats_service_test, get) {
+    start_server();
+    set_blob_data();
+
+    auto channel = ::grpc::CreateChannel(server_address_, ::grpc::InsecureChannelCredentials());
+    BlobRelayStreaming::Stub stub(channel);
+    ::grpc::ClientContext context;
+    GetStreamingRequest req;
+    req.set_api_version(BLOB_RELAY_API_VERSION);
+    req.set_session_id(session_->session_id());
+    auto* blob = req.mutable_blob();
+    blob->set_object_id(blob_id_for_test);
+    blob->set_tag(tag_for_test);
+    std::unique_ptr<::grpc::ClientReader<GetStreamingResponse> > reader(stub.Get(&context, req));
+    GetStreamingResponse resp;
+    while (reader->Read(&resp)) {
+    }
+    EXPECT_EQ(reader->Finish().error_code(), ::grpc::StatusCode::OK);
+
+    auto stats = get_stats(false);
+    EXPECT_EQ(stats.transfer().bytes_out(), test_partial_blob.size() * 10);
+    EXPECT_GT(stats.transfer().chunk_size_out().count(), 0);
+    EXPECT_LE(stats.transfer().chunk_size_out().max(), 32);
+    bool found = false;
+    for (auto&& e : stats.rpcs()) {
+        if (e.method() == "BlobRelayStreaming.Get") {
+            EXPECT_EQ(e.calls().at("OK"), 1);
+            EXPECT_EQ(e.latency_ns().count(), 1);
+            found = true;
+        }
+    }
+    EXPECT_TRUE(found);
+    EXPECT_EQ(stats.sessions().active_sessions(), 1);
+    EXPECT_EQ(stats.sessions().blobs(), 1);
+    EXPECT_TRUE(stats.prometheus_text().empty());
+}
+
+TEST_F(stats_service_test, prometheus) {
+    start_server();
+
+    auto stats = get_stats(true);
+    EXPECT_NE(stats.prometheus_text().find("# TYPE"), std::string::npos);
+}
+
+TEST_F(stats_service_test, api_version_mismatch) {
+    start_server();
+
+    auto channel = ::grpc::CreateChannel(server_address_, ::grpc::InsecureChannelCredentials());
+    BlobRelayStats::Stub stub(channel);
+    ::grpc::ClientContext context;
+    GetStatsRequest req;
+    req.set_api_version(BLOB_RELAY_API_VERSION + 1);
+    GetStatsResponse resp;
+    ::grpc::Status status = stub.GetStats(&context, req, &resp);
+    EXPECT_EQ(status.error_code(), ::grpc::StatusCode::UNAVAILABLE);
+}
+
+} // namespace
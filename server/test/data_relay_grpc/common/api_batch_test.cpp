@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <exception>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+namespace data_relay_grpc::common {
+
+class api_batch_test : public ::testing::Test {
+protected:
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("api_batch_test")};
+
+    void SetUp() override {
+        helper_->set_up();
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        helper_->tear_down();
+    }
+
+    void start(const api& a, std::size_t tag_cache_size = 0, std::size_t path_cache_size = 0) {
+        detail::session_store_options options{};
+        options.tag_cache_size = tag_cache_size;
+        options.path_cache_size = path_cache_size;
+        manager_ = std::make_unique<detail::blob_session_manager>(a, helper_->path().string(), 1024 * 1024, false, options);
+    }
+
+    std::size_t tag_calls_{};
+    std::size_t path_calls_{};
+    std::size_t batch_tag_calls_{};
+    std::size_t batch_path_calls_{};
+    std::size_t batch_tag_count_{};
+
+    std::function<blob_session::blob_tag_type(blob_session::blob_id_type, blob_session::transaction_id_type)> get_tag_{
+        [this](std::uint64_t bid, std::uint64_t tid) {
+            tag_calls_++;
+            return bid * 1000 + tid;
+        }
+    };
+    std::function<std::filesystem::path(blob_session::blob_id_type)> get_path_{
+        [this](std::uint64_t bid) {
+            path_calls_++;
+            return std::filesystem::path("blob_" + std::to_string(bid));
+        }
+    };
+    api::get_tags_type get_tags_{
+        [this](const std::uint64_t* bids, std::size_t count, std::uint64_t tid, std::uint64_t* tags) {
+            batch_tag_calls_++;
+            batch_tag_count_ += count;
+            for (std::size_t i = 0; i < count; i++) {
+                tags[i] = bids[i] * 1000 + tid;
+            }
+        }
+    };
+    api::get_paths_type get_paths_{
+        [this](const std::uint64_t* bids, std::size_t count, std::filesystem::path* paths) {
+            batch_path_calls_++;
+            for (std::size_t i = 0; i < count; i++) {
+                paths[i] = "blob_" + std::to_string(bids[i]);
+            }
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+TEST_F(api_batch_test, batch) {
+    start(api(get_tag_, get_path_, get_tags_, get_paths_));
+    std::array<blob_session::blob_id_type, 3> bids{1, 2, 3};
+    std::array<blob_session::blob_tag_type, 3> tags{};
+    manager_->get_tags(bids.data(), bids.size(), 7, tags.data());
+    EXPECT_EQ(tags, (std::array<blob_session::blob_tag_type, 3>{1007, 2007, 3007}));
+    EXPECT_EQ(batch_tag_calls_, 1);
+    EXPECT_EQ(tag_calls_, 0);
+
+    std::array<std::filesystem::path, 3> paths{};
+    manager_->get_paths(bids.data(), bids.size(), paths.data());
+    EXPECT_EQ(paths.at(2), std::filesystem::path("blob_3"));
+    EXPECT_EQ(batch_path_calls_, 1);
+    EXPECT_EQ(path_calls_, 0);
+
+    // the scalar function is called for a single BLOB
+    manager_->get_tags(bids.data(), 1, 7, tags.data());
+    manager_->get_paths(bids.data(), 1, paths.data());
+    EXPECT_EQ(tag_calls_, 1);
+    EXPECT_EQ(path_calls_, 1);
+}
+
+TEST_F(api_batch_test, fallback) {
+    start(api(get_tag_, get_path_));
+    std::array<blob_session::blob_id_type, 3> bids{1, 2, 3};
+    std::array<blob_session::blob_tag_type, 3> tags{};
+    manager_->get_tags(bids.data(), bids.size(), 7, tags.data());
+    EXPECT_EQ(tags, (std::array<blob_session::blob_tag_type, 3>{1007, 2007, 3007}));
+    EXPECT_EQ(tag_calls_, 3);
+
+    std::array<std::filesystem::path, 3> paths{};
+    manager_->get_paths(bids.data(), bids.size(), paths.data());
+    EXPECT_EQ(paths.at(0), std::filesystem::path("blob_1"));
+    EXPECT_EQ(path_calls_, 3);
+}
+
+TEST_F(api_batch_test, cached) {
+    start(api(get_tag_, get_path_, get_tags_, get_paths_), 100);
+    auto& session = manager_->create_session(7);
+    EXPECT_EQ(manager_->get_tag(2, 7), 2007);
+    EXPECT_EQ(tag_calls_, 1);
+
+    // only the BLOBs not cached are passed to the batch function
+    std::array<blob_session::blob_id_type, 4> bids{1, 2, 3, 4};
+    std::array<blob_session::blob_tag_type, 4> tags{};
+    session.get_tags(bids.data(), bids.size(), tags.data());
+    EXPECT_EQ(tags, (std::array<blob_session::blob_tag_type, 4>{1007, 2007, 3007, 4007}));
+    EXPECT_EQ(batch_tag_calls_, 1);
+    EXPECT_EQ(batch_tag_count_, 3);
+
+    session.get_tags(bids.data(), bids.size(), tags.data());
+    EXPECT_EQ(batch_tag_calls_, 1);
+    EXPECT_EQ(tag_calls_, 1);
+}
+
+TEST_F(api_batch_test, paths_cached) {
+    start(api(get_tag_, get_path_, get_tags_, get_paths_), 0, 100);
+    manager_->find_path(2);
+    EXPECT_EQ(path_calls_, 1);
+
+    // only the BLOBs not cached are passed to the batch function, and the rest are cached for find_path()
+    std::array<blob_session::blob_id_type, 3> bids{1, 2, 3};
+    std::array<std::filesystem::path, 3> paths{};
+    manager_->get_paths(bids.data(), bids.size(), paths.data());
+    EXPECT_EQ(paths.at(1), std::filesystem::path("blob_2"));
+    EXPECT_EQ(paths.at(2), std::filesystem::path("blob_3"));
+    EXPECT_EQ(batch_path_calls_, 1);
+    manager_->find_path(3);
+    manager_->get_paths(bids.data(), bids.size(), paths.data());
+    EXPECT_EQ(batch_path_calls_, 1);
+    EXPECT_EQ(path_calls_, 1);
+}
+
+} // namespace
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <data_relay_grpc/common/detail/blob_index.h>
+
+namespace data_relay_grpc::common {
+
+class blob_index_test : public ::testing::Test {
+protected:
+    using index_type = detail::blob_index<std::string>;
+
+    // the slot the key hashes to in the table of the initial capacity, which is 8 slots
+    static std::size_t home(std::uint64_t key) {
+        return static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ULL) >> 61U);
+    }
+
+    // returns the keys from 1 up whose home is the slot given
+    static std::vector<std::uint64_t> keys_at(std::size_t slot, std::size_t count) {
+        std::vector<std::uint64_t> rv{};
+        for (std::uint64_t key = 1; rv.size() < count; key++) {
+            if (home(key) == slot) {
+                rv.emplace_back(key);
+            }
+        }
+        return rv;
+    }
+
+    static std::string value_of(std::uint64_t key) {
+        return "blob_" + std::to_string(key);
+    }
+
+    static void expect_found(index_type& index, const std::vector<std::uint64_t>& keys) {
+        for (auto key : keys) {
+            auto* e = index.find(key);
+            ASSERT_NE(e, nullptr);
+            EXPECT_EQ(*e, value_of(key));
+        }
+    }
+};
+
+TEST_F(blob_index_test, find_zero) {
+    index_type index{};
+    EXPECT_EQ(index.find(0), nullptr);
+    EXPECT_FALSE(index.extract(0));
+
+    // the empty key is never found even though it marks the empty slots
+    index.emplace(1, value_of(1));
+    index.emplace(2, value_of(2));
+    EXPECT_EQ(index.find(0), nullptr);
+    EXPECT_FALSE(index.extract(0));
+    EXPECT_EQ(index.size(), 2);
+}
+
+TEST_F(blob_index_test, remove_in_wrapped_probe_run) {
+    // the run starts at the last slot and wraps around to the first ones: 7, 0, 1 for the last slot and 2 for the first
+    auto last = keys_at(7, 3);
+    auto first = keys_at(0, 1);
+    index_type index{};
+    for (auto key : last) {
+        EXPECT_TRUE(index.emplace(key, value_of(key)).second);
+    }
+    EXPECT_TRUE(index.emplace(first.at(0), value_of(first.at(0))).second);
+    auto capacity = index.memory_usage();
+
+    // removing the head of the run shifts the rest back across the end of the table
+    auto removed = index.extract(last.at(0));
+    ASSERT_TRUE(removed);
+    EXPECT_EQ(removed.value(), value_of(last.at(0)));
+    EXPECT_EQ(index.find(last.at(0)), nullptr);
+    expect_found(index, {last.at(1), last.at(2), first.at(0)});
+
+    // removing one wrapped around
+    removed = index.extract(last.at(2));
+    ASSERT_TRUE(removed);
+    EXPECT_EQ(removed.value(), value_of(last.at(2)));
+    expect_found(index, {last.at(1), first.at(0)});
+    EXPECT_EQ(index.size(), 2);
+    EXPECT_EQ(index.memory_usage(), capacity);
+}
+
+TEST_F(blob_index_test, extract_and_find_shifted) {
+    auto keys = keys_at(3, 4);
+    auto next = keys_at(4, 2);
+    index_type index{};
+    for (auto key : keys) {
+        index.emplace(key, value_of(key));
+    }
+    for (auto key : next) {
+        index.emplace(key, value_of(key));
+    }
+
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        auto removed = index.extract(keys.at(i));
+        ASSERT_TRUE(removed);
+        EXPECT_EQ(removed.value(), value_of(keys.at(i)));
+        EXPECT_FALSE(index.extract(keys.at(i)));
+        expect_found(index, std::vector<std::uint64_t>(keys.begin() + static_cast<std::ptrdiff_t>(i) + 1, keys.end()));
+        expect_found(index, next);
+    }
+    EXPECT_EQ(index.size(), next.size());
+
+    // the slots freed are reused
+    for (auto key : keys) {
+        EXPECT_TRUE(index.emplace(key, value_of(key)).second);
+    }
+    expect_found(index, keys);
+    expect_found(index, next);
+}
+
+TEST_F(blob_index_test, rehash_during_emplace) {
+    index_type index{};
+    std::vector<std::uint64_t> keys{};
+    for (std::uint64_t key = 1; key <= 7; key++) {
+        index.emplace(key, value_of(key));
+        keys.emplace_back(key);
+    }
+    auto capacity = index.memory_usage();
+
+    // the 8th entry exceeds the load factor of the 8 slots
+    auto [e, inserted] = index.emplace(8, value_of(8));
+    keys.emplace_back(8);
+    EXPECT_TRUE(inserted);
+    EXPECT_EQ(*e, value_of(8));
+    EXPECT_EQ(index.find(8), e);
+    EXPECT_EQ(index.memory_usage(), capacity * 2);
+    EXPECT_EQ(index.size(), 8);
+    expect_found(index, keys);
+
+    // the existing entry is kept
+    auto [existing, again] = index.emplace(3, "other");
+    EXPECT_FALSE(again);
+    EXPECT_EQ(*existing, value_of(3));
+}
+
+TEST_F(blob_index_test, reserve) {
+    index_type index{};
+    index.emplace(1, value_of(1));
+    index.reserve(999);
+    auto capacity = index.memory_usage();
+    auto* first = index.find(1);
+
+    // no rehash while inserting the entries reserved
+    for (std::uint64_t key = 2; key <= 1000; key++) {
+        index.emplace(key, value_of(key));
+    }
+    EXPECT_EQ(index.memory_usage(), capacity);
+    EXPECT_EQ(index.find(1), first);
+    EXPECT_EQ(index.size(), 1000);
+
+    // reserving the room already made does nothing
+    index.reserve(0);
+    EXPECT_EQ(index.memory_usage(), capacity);
+    for (std::uint64_t key = 1; key <= 1000; key++) {
+        ASSERT_NE(index.find(key), nullptr);
+        EXPECT_EQ(*index.find(key), value_of(key));
+    }
+}
+
+TEST_F(blob_index_test, churn) {
+    index_type index{};
+    std::map<std::uint64_t, std::string> expected{};
+    std::mt19937_64 random(12345);  // NOLINT(cert-msc32-c, cert-msc51-cpp): reproducible
+    std::uniform_int_distribution<std::uint64_t> key_dist(1, 3000);
+    std::bernoulli_distribution insert_dist(0.55);
+
+    for (std::size_t op = 0; op < 200000; op++) {
+        auto key = key_dist(random);
+        if (insert_dist(random)) {
+            auto [e, inserted] = index.emplace(key, value_of(key) + "_" + std::to_string(op));
+            auto [itr, expected_inserted] = expected.try_emplace(key, value_of(key) + "_" + std::to_string(op));
+            ASSERT_EQ(inserted, expected_inserted);
+            ASSERT_EQ(*e, itr->second);
+        } else {
+            auto removed = index.extract(key);
+            auto itr = expected.find(key);
+            ASSERT_EQ(removed.has_value(), itr != expected.end());
+            if (itr != expected.end()) {
+                ASSERT_EQ(removed.value(), itr->second);
+                expected.erase(itr);
+            }
+        }
+        ASSERT_EQ(index.size(), expected.size());
+
+        // check a key not operated on as well, which may have been shifted
+        auto probe = key_dist(random);
+        auto* e = index.find(probe);
+        auto itr = expected.find(probe);
+        ASSERT_EQ(e != nullptr, itr != expected.end());
+        if (e != nullptr) {
+            ASSERT_EQ(*e, itr->second);
+        }
+    }
+
+    std::map<std::uint64_t, std::string> actual{};
+    index.for_each([&actual](std::uint64_t key, const std::string& value) {
+        EXPECT_TRUE(actual.emplace(key, value).second);
+    });
+    EXPECT_EQ(actual, expected);
+}
+
+} // namespace
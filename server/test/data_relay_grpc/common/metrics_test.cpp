@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/metrics.h>
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+namespace data_relay_grpc::common {
+
+class metrics_test : public ::testing::Test {
+protected:
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("metrics_test")};
+
+    void SetUp() override {
+        helper_->set_up();
+        manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, helper_->path().string(), 1024 * 1024, false);
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        helper_->tear_down();
+    }
+
+    void put(blob_session& session, std::size_t count) {
+        auto& session_impl = manager_->get_session_impl(session.session_id());
+        for (std::size_t i = 0; i < count; i++) {
+            auto [bid, path] = session_impl.create_blob_file();
+            EXPECT_TRUE(session_impl.reserve_session_store(bid, 4));
+            std::ofstream(path) << "data";
+        }
+    }
+
+    api api_for_test{
+        [](std::uint64_t, std::uint64_t) {
+            return std::uint64_t{};
+        },
+        [this](std::uint64_t){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+TEST_F(metrics_test, striped_counter) {
+    detail::striped_counter counter{};
+    std::vector<std::thread> threads{};
+    for (std::size_t i = 0; i < 8; i++) {
+        threads.emplace_back([&counter]{
+            for (std::size_t j = 0; j < 10000; j++) {
+                counter.add();
+            }
+        });
+    }
+    for (auto&& e : threads) {
+        e.join();
+    }
+    counter.add(5);
+    EXPECT_EQ(counter.value(), 80005);
+}
+
+TEST_F(metrics_test, buckets) {
+    // the values less than 2^sub_bucket_bits have their own buckets
+    for (std::uint64_t v = 0; v < detail::histogram::sub_buckets; v++) {
+        EXPECT_EQ(detail::histogram::bucket_of(v), v);
+        EXPECT_EQ(detail::histogram::upper_bound(v), v);
+    }
+    for (std::uint64_t v : {8UL, 9UL, 100UL, 1000UL, 123456789UL, ~0UL}) {
+        auto b = detail::histogram::bucket_of(v);
+        ASSERT_LT(b, detail::histogram::bucket_count);
+        EXPECT_GE(detail::histogram::upper_bound(b), v);
+        EXPECT_LE(detail::histogram::upper_bound(b) - v, v / detail::histogram::sub_buckets);
+        if (b > 0) {
+            EXPECT_LT(detail::histogram::upper_bound(b - 1), v);
+        }
+    }
+}
+
+TEST_F(metrics_test, percentiles) {
+    detail::histogram h{};
+    for (std::uint64_t v = 1; v <= 1000; v++) {
+        h.record(v);
+    }
+    auto s = h.take();
+    EXPECT_EQ(s.count, 1000);
+    EXPECT_EQ(s.sum, 500500);
+    EXPECT_EQ(s.max, 1000);
+    EXPECT_EQ(s.value_at(0), 1);
+    auto p50 = s.value_at(50);
+    EXPECT_GE(p50, 500);
+    EXPECT_LE(p50, 500 + 500 / detail::histogram::sub_buckets);
+    auto p99 = s.value_at(99);
+    EXPECT_GE(p99, 990);
+    EXPECT_LE(p99, 1000 + 1000 / detail::histogram::sub_buckets);
+    EXPECT_EQ(detail::histogram{}.take().value_at(99), 0);
+}
+
+TEST_F(metrics_test, statistics) {
+    auto& s1 = manager_->create_session(std::nullopt);
+    auto& s2 = manager_->create_session(std::nullopt);
+    put(s1, 3);
+    put(s2, 5);
+    auto stats = manager_->statistics();
+    EXPECT_EQ(stats.sessions, 2);
+    EXPECT_EQ(stats.blobs, 8);
+    EXPECT_EQ(stats.max_blobs_per_session, 5);
+    EXPECT_EQ(manager_->session_store_quota(), 1024 * 1024);
+
+    s1.dispose();
+    stats = manager_->statistics();
+    EXPECT_EQ(stats.sessions, 1);
+    EXPECT_EQ(stats.blobs, 5);
+}
+
+} // namespace
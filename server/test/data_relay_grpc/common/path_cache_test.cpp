@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/path_cache.h>
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+namespace data_relay_grpc::common {
+
+class path_cache_test : public ::testing::Test {
+protected:
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("path_cache_test")};
+
+    void SetUp() override {
+        helper_->set_up();
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        helper_->tear_down();
+    }
+
+    void start(std::size_t capacity, std::chrono::milliseconds ttl, std::chrono::milliseconds negative_ttl) {
+        detail::session_store_options options{};
+        options.path_cache_size = capacity;
+        options.path_cache_ttl = ttl;
+        options.path_cache_negative_ttl = negative_ttl;
+        auto store = helper_->path("store");
+        std::filesystem::create_directory(store);
+        manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, store.string(), 1024 * 1024, false, options);
+    }
+
+    std::filesystem::path blob_path(std::uint64_t bid) {
+        return helper_->path("blob_" + std::to_string(bid));
+    }
+
+    std::size_t calls_{};
+
+    api api_for_test{
+        [](std::uint64_t, std::uint64_t) {
+            return std::uint64_t{};
+        },
+        [this](std::uint64_t bid){
+            calls_++;
+            return blob_path(bid);
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+TEST_F(path_cache_test, ttl) {
+    using namespace std::chrono_literals;
+    detail::path_cache cache(100, 10s, 50ms);
+    cache.insert(1, {"exists", true});
+    cache.insert(2, {"missing", false});
+    EXPECT_EQ(cache.find(1).value().path, std::filesystem::path("exists"));
+    EXPECT_FALSE(cache.find(2).value().exists);
+    EXPECT_FALSE(cache.find(3));
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(cache.negative_hits(), 1);
+    EXPECT_EQ(cache.misses(), 1);
+
+    // the entry of the file not found expires first
+    std::this_thread::sleep_for(100ms);
+    EXPECT_TRUE(cache.find(1));
+    EXPECT_FALSE(cache.find(2));
+    EXPECT_EQ(cache.size(), 1);
+}
+
+TEST_F(path_cache_test, bounded) {
+    using namespace std::chrono_literals;
+    // one entry in each shard
+    detail::path_cache cache(detail::path_cache::shard_count, 10s, 10s);
+    for (std::uint64_t bid = 0; bid < 100; bid++) {
+        cache.insert(bid, {"path", true});
+    }
+    EXPECT_LE(cache.size(), detail::path_cache::shard_count);
+    EXPECT_TRUE(cache.find(99));
+}
+
+TEST_F(path_cache_test, find_path) {
+    using namespace std::chrono_literals;
+    start(100, 10s, 50ms);
+    EXPECT_FALSE(manager_->find_path(1));
+    EXPECT_FALSE(manager_->find_path(1));
+    EXPECT_EQ(calls_, 1);
+
+    // the file created is found after the negative entry expires
+    std::ofstream(blob_path(1)) << "data";
+    EXPECT_FALSE(manager_->find_path(1));
+    std::this_thread::sleep_for(100ms);
+    EXPECT_EQ(manager_->find_path(1).value(), blob_path(1));
+    EXPECT_EQ(manager_->find_path(1).value(), blob_path(1));
+    EXPECT_EQ(calls_, 2);
+    EXPECT_EQ(manager_->paths().hits(), 1);
+    EXPECT_EQ(manager_->paths().negative_hits(), 2);
+}
+
+TEST_F(path_cache_test, disabled) {
+    using namespace std::chrono_literals;
+    start(0, 10s, 10s);
+    std::ofstream(blob_path(1)) << "data";
+    EXPECT_EQ(manager_->find_path(1).value(), blob_path(1));
+    EXPECT_EQ(manager_->find_path(1).value(), blob_path(1));
+    EXPECT_EQ(calls_, 2);
+}
+
+} // namespace
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include <data_relay_grpc/common/detail/quota_accountant.h>
+
+namespace data_relay_grpc::common {
+
+class quota_accountant_test : public ::testing::Test {
+};
+
+TEST_F(quota_accountant_test, exact_near_limit) {
+    detail::quota_accountant quota(1000, 10);
+
+    EXPECT_TRUE(quota.reserve(600));
+    EXPECT_TRUE(quota.reserve(400));
+    EXPECT_EQ(quota.used(), 1000);
+    EXPECT_FALSE(quota.reserve(1));
+    quota.release(400);
+    EXPECT_EQ(quota.used(), 600);
+    EXPECT_TRUE(quota.reserve(400));
+    EXPECT_FALSE(quota.reserve(1));
+}
+
+TEST_F(quota_accountant_test, slabs) {
+    const std::size_t quota_size = 100000;
+    detail::quota_accountant quota(quota_size, 10);
+
+    // reserved from the slabs leased, which do not prevent reserving the whole quota
+    for (std::size_t i = 0; i < quota_size; i++) {
+        ASSERT_TRUE(quota.reserve(1));
+    }
+    EXPECT_EQ(quota.used(), quota_size);
+    EXPECT_FALSE(quota.reserve(1));
+    for (std::size_t i = 0; i < quota_size; i++) {
+        quota.release(1);
+    }
+    EXPECT_EQ(quota.used(), 0);
+    EXPECT_TRUE(quota.reserve(quota_size));
+}
+
+TEST_F(quota_accountant_test, concurrent) {
+    const std::size_t quota_size = 100000;
+    const std::size_t thread_count = 8;
+    detail::quota_accountant quota(quota_size, 16);
+
+    std::vector<std::thread> threads{};
+    std::vector<std::size_t> reserved(thread_count);
+    for (std::size_t t = 0; t < thread_count; t++) {
+        threads.emplace_back([&quota, &reserved, t]{
+            for (std::size_t i = 0; quota.reserve(3); i++) {
+                reserved.at(t) += 3;
+                if (i % 3 == 0) {
+                    quota.release(3);
+                    reserved.at(t) -= 3;
+                }
+            }
+        });
+    }
+    for (auto&& e : threads) {
+        e.join();
+    }
+    std::size_t total{};
+    for (auto e : reserved) {
+        total += e;
+    }
+    EXPECT_EQ(quota.used(), total);
+    EXPECT_LE(total, quota_size);
+    EXPECT_GT(total + 3, quota_size);
+}
+
+TEST_F(quota_accountant_test, unlimited) {
+    detail::quota_accountant quota(0);
+
+    EXPECT_TRUE(quota.reserve(1UL << 40U));
+    quota.restore(100);
+    EXPECT_EQ(quota.used(), 0);
+}
+
+TEST_F(quota_accountant_test, restore) {
+    detail::quota_accountant quota(1000, 10);
+
+    quota.restore(1500);
+    EXPECT_EQ(quota.used(), 1500);
+    EXPECT_FALSE(quota.reserve(1));
+    quota.release(1000);
+    EXPECT_TRUE(quota.reserve(500));
+    EXPECT_FALSE(quota.reserve(1));
+}
+
+} // namespace
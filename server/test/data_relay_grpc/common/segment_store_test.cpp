@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <exception>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/segment_store.h>
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+namespace data_relay_grpc::common {
+
+class segment_store_test : public ::testing::Test {
+protected:
+    const std::uint64_t tag_for_test = 2468;
+    const std::string test_blob{"ABCDEFGHIJKLMNOPQRSTUBWXYZabcdefghijklmnopqrstubwxyz\n"};
+
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("segment_store_test")};
+
+    void SetUp() override {
+        helper_->set_up();
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        helper_->tear_down();
+    }
+
+    void start() {
+        detail::session_store_options options{};
+        options.segment_size = 4 * test_blob.size();
+        options.segment_threshold = test_blob.size();
+        manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, helper_->path().string(), 1024 * 1024, false, options);
+    }
+
+    std::string read(const std::filesystem::path& path) {
+        std::ifstream strm(path);
+        return std::string(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
+    }
+
+    api api_for_test{
+        [this](std::uint64_t, std::uint64_t) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+TEST_F(segment_store_test, append_read_remove) {
+    detail::segment_store store(helper_->path("segments"), 1024);
+
+    EXPECT_TRUE(store.append(1, "first"));
+    EXPECT_TRUE(store.append(2, "second"));
+    EXPECT_EQ(store.read(1).value(), "first");
+    EXPECT_EQ(store.read(2).value(), "second");
+    EXPECT_FALSE(store.read(3));
+    EXPECT_EQ(store.segment_count(), 1);
+    EXPECT_EQ(store.live_size(), 11);
+
+    EXPECT_TRUE(store.remove(1));
+    EXPECT_FALSE(store.remove(1));
+    EXPECT_FALSE(store.read(1));
+    EXPECT_EQ(store.read(2).value(), "second");
+    EXPECT_EQ(store.live_size(), 6);
+}
+
+TEST_F(segment_store_test, sealed_segment_deleted) {
+    detail::segment_store store(helper_->path("segments"), 10);
+
+    EXPECT_TRUE(store.append(1, "0123456789"));
+    EXPECT_TRUE(store.append(2, "abcdefghij"));
+    EXPECT_EQ(store.segment_count(), 2);
+
+    // the first segment is sealed, and is deleted when it has no BLOB
+    EXPECT_TRUE(store.remove(1));
+    EXPECT_EQ(store.segment_count(), 1);
+    EXPECT_EQ(store.read(2).value(), "abcdefghij");
+}
+
+TEST_F(segment_store_test, compaction) {
+    detail::segment_store store(helper_->path("segments"), 12);
+
+    for (std::uint64_t key = 1; key <= 4; key++) {
+        EXPECT_TRUE(store.append(key, std::string(3, static_cast<char>('a' + key))));
+    }
+    EXPECT_TRUE(store.append(5, "next"));
+    EXPECT_EQ(store.file_size(), 16);
+
+    // the sealed segment less than half used is compacted
+    EXPECT_TRUE(store.remove(1));
+    EXPECT_TRUE(store.remove(2));
+    EXPECT_TRUE(store.remove(3));
+    EXPECT_EQ(store.read(4).value(), "eee");
+    EXPECT_EQ(store.live_size(), 7);
+    EXPECT_EQ(store.file_size(), 7);
+    EXPECT_EQ(store.segment_count(), 1);
+}
+
+TEST_F(segment_store_test, packed_blob) {
+    start();
+    auto& session = manager_->create_session(std::nullopt);
+    auto& session_impl = manager_->get_session_impl(session.session_id());
+
+    detail::quota_level exceeded{};
+    auto bid = session_impl.add_packed_blob(test_blob, exceeded);
+    ASSERT_TRUE(bid);
+    EXPECT_EQ(session_impl.read_packed(bid.value()).value(), test_blob);
+    EXPECT_EQ(manager_->session_store_current_size(), test_blob.size());
+    EXPECT_EQ(manager_->segments()->live_size(), test_blob.size());
+
+    // larger than the threshold
+    EXPECT_FALSE(session_impl.add_packed_blob(test_blob + test_blob, exceeded));
+    EXPECT_EQ(exceeded, detail::quota_level::none);
+
+    std::vector<blob_session::blob_id_type> bids{bid.value()};
+    session.remove(bids.begin(), bids.end());
+    EXPECT_FALSE(session_impl.read_packed(bid.value()));
+    EXPECT_EQ(manager_->segments()->live_size(), 0);
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+}
+
+TEST_F(segment_store_test, materialize_on_find) {
+    start();
+    auto& session = manager_->create_session(std::nullopt);
+    auto& session_impl = manager_->get_session_impl(session.session_id());
+
+    detail::quota_level exceeded{};
+    auto bid = session_impl.add_packed_blob(test_blob, exceeded);
+    ASSERT_TRUE(bid);
+
+    // the path is required, and thus the BLOB is moved to its own file
+    auto path_opt = session.find(bid.value());
+    ASSERT_TRUE(path_opt);
+    EXPECT_EQ(path_opt.value().parent_path(), helper_->path());
+    EXPECT_EQ(read(path_opt.value()), test_blob);
+    EXPECT_FALSE(session_impl.read_packed(bid.value()));
+    EXPECT_EQ(manager_->segments()->live_size(), 0);
+    EXPECT_EQ(manager_->session_store_current_size(), test_blob.size());
+
+    session.dispose();
+    manager_->wait_deletions();
+    EXPECT_FALSE(std::filesystem::exists(path_opt.value()));
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+}
+
+TEST_F(segment_store_test, dispose) {
+    start();
+    auto& session = manager_->create_session(std::nullopt);
+    auto& session_impl = manager_->get_session_impl(session.session_id());
+
+    detail::quota_level exceeded{};
+    for (std::size_t i = 0; i < 10; i++) {
+        ASSERT_TRUE(session_impl.add_packed_blob(test_blob, exceeded));
+    }
+    EXPECT_GT(manager_->segments()->segment_count(), 1);
+    session.dispose();
+    EXPECT_EQ(manager_->segments()->live_size(), 0);
+    EXPECT_LE(manager_->segments()->segment_count(), 1);
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+}
+
+} // namespace
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "data_relay_grpc/common/session_test_base.h"
+
+namespace data_relay_grpc::common {
+
+class session_async_deletion_test : public session_test_base {
+protected:
+    const std::size_t blob_count = 100;
+
+    session_async_deletion_test() : session_test_base("session_async_deletion_test") {}
+
+    void SetUp() override {
+        session_test_base::SetUp();
+        detail::session_store_options options{};
+        options.deletion_threads = 2;
+        start(1024 * 1024, options);
+    }
+};
+
+TEST_F(session_async_deletion_test, dispose) {
+    auto& session = manager_->create_session(std::nullopt);
+    put(session, blob_count);
+    EXPECT_EQ(file_count(), blob_count);
+    EXPECT_EQ(manager_->session_store_current_size(), blob_count * test_blob.size());
+
+    session.dispose();
+    // the quota is released before the files are deleted
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+
+    manager_->wait_deletions();
+    EXPECT_EQ(manager_->pending_deletions(), 0);
+    EXPECT_EQ(file_count(), 0);
+}
+
+TEST_F(session_async_deletion_test, remove) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto bids = put(session, blob_count);
+
+    session.remove(bids.begin(), bids.end());
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+    EXPECT_TRUE(session.entries().empty());
+
+    manager_->wait_deletions();
+    EXPECT_EQ(file_count(), 0);
+}
+
+TEST_F(session_async_deletion_test, shutdown) {
+    auto& session = manager_->create_session(std::nullopt);
+    put(session, blob_count);
+    session.dispose();
+
+    // pending deletions are completed before the manager is destructed
+    manager_.reset();
+    EXPECT_EQ(file_count(), 0);
+}
+
+} // namespace
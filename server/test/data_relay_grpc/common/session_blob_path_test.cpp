@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <exception>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+namespace data_relay_grpc::common {
+
+class session_blob_path_test : public ::testing::Test {
+protected:
+    const std::uint64_t tag_for_test = 2468;
+
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("session_blob_path_test")};
+
+    void SetUp() override {
+        helper_->set_up();
+        std::filesystem::create_directory(helper_->path("session_store"));
+        manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, helper_->path("session_store").string(), 0, false);
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        helper_->tear_down();
+    }
+
+    std::filesystem::path create_file(const std::string& name) {
+        auto path = helper_->path(name);
+        std::ofstream strm(path);
+        strm << name;
+        return path;
+    }
+
+    api api_for_test{
+        [this](std::uint64_t, std::uint64_t) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+TEST_F(session_blob_path_test, derived_path) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto& session_impl = manager_->get_session_impl(session.session_id());
+    auto store = helper_->path("session_store");
+
+    auto [bid1, path1] = session_impl.create_blob_file();
+    auto [bid2, path2] = session_impl.create_blob_file("download");
+    EXPECT_EQ(path1, store / ("upload_" + std::to_string(bid1)));
+    EXPECT_EQ(path2, store / ("download_" + std::to_string(bid2)));
+    EXPECT_EQ(session.find(bid1), path1);
+    EXPECT_EQ(session.find(bid2), path2);
+
+    std::ofstream(path1) << "data";
+    std::vector<blob_session::blob_id_type> bids{bid1};
+    session.remove(bids.begin(), bids.end());
+    EXPECT_FALSE(session.find(bid1));
+    EXPECT_FALSE(std::filesystem::exists(path1));
+    EXPECT_EQ(session.find(bid2), path2);
+}
+
+TEST_F(session_blob_path_test, external_path) {
+    auto path = create_file("external");
+    auto canonical_path = std::filesystem::canonical(path);
+    auto& session1 = manager_->create_session(std::nullopt);
+    auto& session2 = manager_->create_session(std::nullopt);
+
+    // the same path added by two sessions
+    auto bid1 = session1.add(path);
+    auto bid2 = session2.add(helper_->path() / "." / "external");
+    EXPECT_EQ(session1.find(bid1), canonical_path);
+    EXPECT_EQ(session2.find(bid2), canonical_path);
+
+    std::vector<blob_session::blob_id_type> bids{bid1};
+    session1.remove(bids.begin(), bids.end());
+    EXPECT_FALSE(session1.find(bid1));
+    EXPECT_EQ(session2.find(bid2), canonical_path);
+}
+
+TEST_F(session_blob_path_test, bulk_add) {
+    std::filesystem::create_directory(helper_->path("sub"));
+    std::vector<std::filesystem::path> paths{create_file("a"), create_file("sub/b"), create_file("c"), helper_->path("sub") / ".." / "sub" / "b"};
+    std::filesystem::create_symlink(paths.at(0), helper_->path("link"));
+    paths.emplace_back(helper_->path("link"));
+    auto& session = manager_->create_session(std::nullopt);
+
+    auto bids = session.add(paths.begin(), paths.end());
+    ASSERT_EQ(bids.size(), paths.size());
+    for (std::size_t i = 0; i < bids.size(); i++) {
+        if (i > 0) {
+            EXPECT_EQ(bids.at(i), bids.at(i - 1) + 1);
+        }
+        EXPECT_EQ(session.find(bids.at(i)), std::filesystem::canonical(paths.at(i)));
+    }
+    EXPECT_EQ(session.entries(), bids);
+}
+
+TEST_F(session_blob_path_test, bulk_add_not_exist) {
+    std::vector<std::filesystem::path> paths{create_file("a"), helper_->path("not_exist")};
+    auto& session = manager_->create_session(std::nullopt);
+
+    EXPECT_THROW({ (void) session.add(paths.begin(), paths.end()); }, std::runtime_error);
+    EXPECT_TRUE(session.entries().empty());
+}
+
+} // namespace
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include <list>
+#include <set>
+#include <vector>
+
+#include "data_relay_grpc/common/session_test_base.h"
+
+namespace data_relay_grpc::common {
+
+class session_bulk_remove_test : public session_test_base {
+protected:
+    const std::size_t blob_count = 10;
+
+    session_bulk_remove_test() : session_test_base("session_bulk_remove_test") {}
+
+    void SetUp() override {
+        session_test_base::SetUp();
+        start(1024 * 1024);
+    }
+};
+
+TEST_F(session_bulk_remove_test, vector) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto bids = put(session, blob_count);
+
+    session.remove(bids.begin(), bids.begin() + 4);
+    EXPECT_EQ(session.entries().size(), blob_count - 4);
+    EXPECT_EQ(file_count(), blob_count - 4);
+    EXPECT_EQ(manager_->session_store_current_size(), (blob_count - 4) * test_blob.size());
+
+    const auto& rest = bids;
+    session.remove(rest);
+    EXPECT_TRUE(session.entries().empty());
+    EXPECT_EQ(file_count(), 0);
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+}
+
+TEST_F(session_bulk_remove_test, forward_range) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto bids = put(session, blob_count);
+
+    std::list<blob_session::blob_id_type> list(bids.begin(), bids.begin() + 3);
+    session.remove(list.begin(), list.end());
+    EXPECT_EQ(session.entries().size(), blob_count - 3);
+
+    std::set<blob_session::blob_id_type> set(bids.begin() + 3, bids.end());
+    session.remove(set);
+    EXPECT_TRUE(session.entries().empty());
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+}
+
+TEST_F(session_bulk_remove_test, array) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto bids = put(session, blob_count);
+
+    session.remove(bids.data(), 5);
+    EXPECT_EQ(session.entries().size(), blob_count - 5);
+
+    // unknown and already removed BLOB IDs are ignored
+    bids.emplace_back(bids.back() + 1000);
+    session.remove(bids.data(), bids.size());
+    EXPECT_TRUE(session.entries().empty());
+    EXPECT_EQ(file_count(), 0);
+}
+
+TEST_F(session_bulk_remove_test, reversed) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto bids = put(session, blob_count);
+
+    EXPECT_THROW({ session.remove(bids.end(), bids.begin()); }, std::runtime_error);
+    EXPECT_EQ(session.entries().size(), blob_count);
+}
+
+} // namespace
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "data_relay_grpc/common/session_test_base.h"
+
+namespace data_relay_grpc::common {
+
+class session_memory_tier_test : public session_test_base {
+protected:
+    session_memory_tier_test() : session_test_base("session_memory_tier_test") {}
+
+    void SetUp() override {
+        session_test_base::SetUp();
+        detail::session_store_options options{};
+        options.memory_tier_budget = 2 * test_blob.size();
+        options.memory_tier_threshold = test_blob.size();
+        start(1024 * 1024, options);
+    }
+
+    std::string read(const std::filesystem::path& path) {
+        std::ifstream strm(path);
+        return std::string(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
+    }
+
+    std::string read(int fd) {
+        std::string s(test_blob.size() * 2, '\0');
+        auto n = ::read(fd, s.data(), s.size());
+        s.resize(n < 0 ? 0 : static_cast<std::size_t>(n));
+        return s;
+    }
+};
+
+TEST_F(session_memory_tier_test, in_memory) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto handle = manager_->pin_session(session.session_id());
+
+    detail::quota_level exceeded{};
+    auto bid = handle->add_memory_blob(test_blob, exceeded);
+    ASSERT_TRUE(bid);
+    EXPECT_EQ(manager_->memory_tier_usage(), test_blob.size());
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+    EXPECT_EQ(handle->usage(), test_blob.size());
+
+    // no file is created in the session store
+    auto fd = handle->reopen_descriptor(bid.value());
+    ASSERT_TRUE(fd);
+    EXPECT_TRUE(std::filesystem::is_empty(helper_->path()));
+
+    // the descriptor remains valid after the BLOB is removed
+    std::vector<blob_session::blob_id_type> bids{bid.value()};
+    session.remove(bids.begin(), bids.end());
+    EXPECT_EQ(manager_->memory_tier_usage(), 0);
+    EXPECT_EQ(handle->usage(), 0);
+    EXPECT_FALSE(handle->reopen_descriptor(bid.value()));
+    EXPECT_EQ(read(fd.value()), test_blob);
+    ::close(fd.value());
+}
+
+TEST_F(session_memory_tier_test, find) {
+    auto& session = manager_->create_session(std::nullopt);
+
+    detail::quota_level exceeded{};
+    auto bid = manager_->pin_session(session.session_id())->add_memory_blob(test_blob, exceeded);
+    ASSERT_TRUE(bid);
+
+    // the path of the BLOB in memory is of the file written by materialize()
+    auto path_opt = session.find(bid.value());
+    ASSERT_TRUE(path_opt);
+    EXPECT_EQ(path_opt.value().parent_path(), helper_->path());
+    EXPECT_EQ(read(path_opt.value()), test_blob);
+    EXPECT_EQ(manager_->memory_tier_usage(), 0);
+    EXPECT_EQ(manager_->session_store_current_size(), test_blob.size());
+}
+
+TEST_F(session_memory_tier_test, adopted) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto handle = manager_->pin_session(session.session_id());
+    int memfd = ::memfd_create("session_memory_tier_test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    ASSERT_GE(memfd, 0);
+    ASSERT_EQ(::write(memfd, test_blob.data(), test_blob.size()), test_blob.size());
+    ASSERT_EQ(::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE), 0);
+
+    auto bid = handle->adopt_blob_file(memfd, test_blob.size());
+    ASSERT_TRUE(bid);
+    auto fd = handle->reopen_descriptor(bid.value());
+    ASSERT_TRUE(fd);
+
+    // the path of the adopted memory file is of the file written by materialize(), not in /proc/self/fd
+    auto path_opt = session.find(bid.value());
+    ASSERT_TRUE(path_opt);
+    EXPECT_EQ(path_opt.value().parent_path(), helper_->path());
+    EXPECT_EQ(read(path_opt.value()), test_blob);
+    EXPECT_FALSE(handle->reopen_descriptor(bid.value()));
+
+    // the descriptor opened before remains valid
+    EXPECT_EQ(read(fd.value()), test_blob);
+    ::close(fd.value());
+    EXPECT_EQ(manager_->session_store_current_size(), test_blob.size());
+}
+
+TEST_F(session_memory_tier_test, spill) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto handle = manager_->pin_session(session.session_id());
+
+    // larger than the threshold
+    detail::quota_level exceeded{};
+    EXPECT_FALSE(handle->add_memory_blob(test_blob + test_blob, exceeded));
+    EXPECT_EQ(exceeded, detail::quota_level::none);
+
+    // exceeds the budget
+    EXPECT_TRUE(handle->add_memory_blob(test_blob, exceeded));
+    EXPECT_TRUE(handle->add_memory_blob(test_blob, exceeded));
+    EXPECT_FALSE(handle->add_memory_blob(test_blob, exceeded));
+    EXPECT_EQ(exceeded, detail::quota_level::none);
+    EXPECT_EQ(manager_->memory_tier_usage(), 2 * test_blob.size());
+    EXPECT_EQ(handle->usage(), 2 * test_blob.size());
+
+    // the session is disposed when unpinned
+    session.dispose();
+    EXPECT_EQ(manager_->memory_tier_usage(), 2 * test_blob.size());
+    handle = {};
+    EXPECT_EQ(manager_->memory_tier_usage(), 0);
+}
+
+TEST_F(session_memory_tier_test, materialize) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto handle = manager_->pin_session(session.session_id());
+
+    detail::quota_level exceeded{};
+    auto bid = handle->add_memory_blob(test_blob, exceeded);
+    ASSERT_TRUE(bid);
+    auto path_opt = handle->materialize(bid.value());
+    ASSERT_TRUE(path_opt);
+    EXPECT_EQ(path_opt.value().parent_path(), helper_->path());
+    EXPECT_EQ(read(path_opt.value()), test_blob);
+    EXPECT_EQ(session.find(bid.value()), path_opt);
+
+    // the usage is moved from the memory tier to the session store
+    EXPECT_EQ(manager_->memory_tier_usage(), 0);
+    EXPECT_EQ(manager_->session_store_current_size(), test_blob.size());
+    EXPECT_EQ(handle->usage(), test_blob.size());
+
+    // materialized only once
+    EXPECT_EQ(handle->materialize(bid.value()), path_opt);
+    EXPECT_FALSE(handle->materialize(bid.value() + 1));
+
+    std::vector<blob_session::blob_id_type> bids{bid.value()};
+    session.remove(bids.begin(), bids.end());
+    manager_->wait_deletions();
+    EXPECT_FALSE(std::filesystem::exists(path_opt.value()));
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+}
+
+} // namespace
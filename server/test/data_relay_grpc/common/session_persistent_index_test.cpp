@@ -0,0 +1,243 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <exception>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/session_manager.h>
+#include <data_relay_grpc/common/detail/session_index.h>
+
+namespace data_relay_grpc::common {
+
+class session_persistent_index_test : public ::testing::Test {
+protected:
+    const std::uint64_t tag_for_test = 2468;
+    const std::string test_blob{"ABCDEFGHIJKLMNOPQRSTUBWXYZabcdefghijklmnopqrstubwxyz\n"};
+    const std::size_t quota = 1024 * 1024;
+
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("session_persistent_index_test")};
+
+    void SetUp() override {
+        helper_->set_up();
+        start();
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        helper_->tear_down();
+    }
+
+    void start(bool persistent = true, std::size_t deletion_threads = 0) {
+        manager_.reset();
+        detail::session_store_options options{};
+        options.cleanup_threads = 0;
+        options.deletion_threads = deletion_threads;
+        options.persistent_index = persistent;
+        manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, helper_->path().string(), quota, false, options);
+    }
+
+    blob_session::blob_id_type put(blob_session& session, bool complete = true) {
+        auto& session_impl = manager_->get_session_impl(session.session_id());
+        auto [bid, path] = session_impl.create_blob_file();
+        EXPECT_TRUE(session_impl.reserve_session_store(bid, test_blob.size()));
+        std::ofstream strm(path);
+        strm << test_blob;
+        strm.close();
+        if (complete) {
+            session_impl.complete_blob_file(bid);
+        }
+        return bid;
+    }
+
+    std::string read(const std::filesystem::path& path) {
+        std::ifstream strm(path);
+        return std::string(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
+    }
+
+    api api_for_test{
+        [this](std::uint64_t, std::uint64_t) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+TEST_F(session_persistent_index_test, restore) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto sid = session.session_id();
+    auto bid1 = put(session);
+    auto bid2 = put(session);
+    auto& transaction_session = manager_->create_session(1234);
+    auto tsid = transaction_session.session_id();
+    auto bid3 = put(transaction_session);
+
+    start();
+    EXPECT_EQ(manager_->restored_sessions(), 2);
+    EXPECT_EQ(manager_->session_store_current_size(), 3 * test_blob.size());
+
+    auto& restored = manager_->get_session(sid);
+    EXPECT_EQ(restored.entries(), (std::vector<blob_session::blob_id_type>{bid1, bid2}));
+    auto path_opt = restored.find(bid2);
+    ASSERT_TRUE(path_opt);
+    EXPECT_EQ(read(path_opt.value()), test_blob);
+
+    EXPECT_EQ(manager_->get_session_id(1234), tsid);
+    EXPECT_EQ(manager_->get_session(tsid).entries(), (std::vector<blob_session::blob_id_type>{bid3}));
+
+    // the IDs assigned after the restart do not collide with the restored ones
+    auto& new_session = manager_->create_session(std::nullopt);
+    EXPECT_GT(new_session.session_id(), tsid);
+    EXPECT_GT(put(new_session), bid3);
+}
+
+TEST_F(session_persistent_index_test, removed_and_disposed) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto sid = session.session_id();
+    auto bid1 = put(session);
+    auto bid2 = put(session);
+    std::vector<blob_session::blob_id_type> removed{bid1};
+    session.remove(removed.begin(), removed.end());
+    auto& disposed = manager_->create_session(std::nullopt);
+    auto dsid = disposed.session_id();
+    put(disposed);
+    disposed.dispose();
+
+    start();
+    EXPECT_EQ(manager_->restored_sessions(), 1);
+    EXPECT_EQ(manager_->get_session(sid).entries(), (std::vector<blob_session::blob_id_type>{bid2}));
+    EXPECT_THROW(manager_->get_session(dsid), std::out_of_range);
+    EXPECT_EQ(manager_->session_store_current_size(), test_blob.size());
+}
+
+TEST_F(session_persistent_index_test, incomplete_upload) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto sid = session.session_id();
+    auto bid = put(session);
+    auto incomplete = put(session, false);
+    auto path = manager_->get_session_impl(sid).find(incomplete).value();
+
+    start();
+    // the file being uploaded at the restart is deleted
+    EXPECT_EQ(manager_->get_session(sid).entries(), (std::vector<blob_session::blob_id_type>{bid}));
+    EXPECT_FALSE(std::filesystem::exists(path));
+    EXPECT_EQ(manager_->session_store_current_size(), test_blob.size());
+}
+
+TEST_F(session_persistent_index_test, sweep_in_background) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto sid = session.session_id();
+    auto bid = put(session);
+    auto incomplete = put(session, false);
+    auto path = manager_->get_session_impl(sid).find(incomplete).value();
+
+    start(true, 2);
+    manager_->wait_deletions();
+    EXPECT_FALSE(std::filesystem::exists(path));
+    EXPECT_TRUE(manager_->get_session(sid).find(bid));
+    EXPECT_EQ(manager_->pending_deletions(), 0);
+}
+
+TEST_F(session_persistent_index_test, torn_record) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto sid = session.session_id();
+    auto bid = put(session);
+    manager_.reset();
+    {
+        std::ofstream strm(helper_->path() / ".index", std::ios::binary | std::ios::app);
+        strm << "torn";
+    }
+
+    start();
+    EXPECT_EQ(manager_->get_session(sid).entries(), (std::vector<blob_session::blob_id_type>{bid}));
+}
+
+TEST_F(session_persistent_index_test, tag_key) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto sid = session.session_id();
+    auto bid = put(session);
+    auto tag = session.compute_tag(bid);
+    auto key = helper_->path() / ".tag_key";
+    EXPECT_EQ(std::filesystem::status(key).permissions(), std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+
+    // the tags issued before the restart remain valid
+    start();
+    EXPECT_EQ(manager_->get_session(sid).compute_tag(bid), tag);
+
+    // the key broken is not replaced silently
+    manager_.reset();
+    std::filesystem::resize_file(key, 4);
+    EXPECT_THROW(start(), std::runtime_error);
+}
+
+TEST_F(session_persistent_index_test, not_persistent) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto sid = session.session_id();
+    put(session);
+
+    start(false);
+    EXPECT_EQ(manager_->restored_sessions(), 0);
+    EXPECT_THROW(manager_->get_session(sid), std::out_of_range);
+    EXPECT_TRUE(std::filesystem::is_empty(helper_->path()));
+}
+
+TEST_F(session_persistent_index_test, compaction_in_background) {
+    manager_.reset();
+    auto path = helper_->path("index_for_test");
+    {
+        detail::session_index index(path, 100);
+        index.session_created(1, std::nullopt);
+        index.session_created(2, 7);
+        for (std::uint64_t bid = 1; bid <= 200; bid++) {
+            index.blob_added(bid, bid % 2 == 0 ? 2 : 1, bid, bid % 3 == 0 ? "upload" : "copy");
+        }
+        for (std::uint64_t bid = 1; bid <= 200; bid++) {
+            if (bid % 10 != 0) {
+                index.blob_removed(bid);
+            }
+        }
+        index.wait_compaction();
+
+        // the records appended after compaction are kept as well
+        index.session_created(3, std::nullopt);
+        index.blob_added(201, 3, 201, "upload");
+        index.session_disposed(1, 10);
+        index.wait_compaction();
+        EXPECT_LT(index.record_count(), 100);
+    }
+
+    detail::session_index index(path, 0);
+    auto& sessions = index.recovered().sessions;
+    ASSERT_EQ(sessions.size(), 2);
+    EXPECT_EQ(sessions.at(2).transaction_id_opt, 7);
+    EXPECT_EQ(sessions.at(2).blobs.size(), 20);
+    EXPECT_EQ(sessions.at(2).blobs.at(30).prefix, "upload");
+    EXPECT_EQ(sessions.at(2).blobs.at(20).prefix, "copy");
+    EXPECT_EQ(sessions.at(2).blobs.at(20).size, 20);
+    ASSERT_EQ(sessions.at(3).blobs.size(), 1);
+    EXPECT_EQ(sessions.at(3).blobs.at(201).prefix, "upload");
+    EXPECT_EQ(index.recovered().max_session_id, 3);
+}
+
+TEST_F(session_persistent_index_test, blob_id_reservation) {
+    manager_.reset();
+    auto path = helper_->path("index_for_test");
+    std::size_t records{};
+    {
+        detail::session_index index(path, 0);
+        records = index.record_count();
+        for (std::uint64_t bid = 1; bid <= 100000; bid++) {
+            index.assign_blob_id(bid);
+        }
+        // the blocks reserved grow from 4096 BLOB IDs
+        EXPECT_LE(index.record_count() - records, 5);
+    }
+    detail::session_index index(path, 0);
+    EXPECT_GE(index.recovered().max_blob_id, 100000);
+}
+
+} // namespace
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <exception>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+namespace data_relay_grpc::common {
+
+class session_pin_test : public ::testing::Test {
+protected:
+    const std::uint64_t tag_for_test = 2468;
+    const std::string test_blob{"ABCDEFGHIJKLMNOPQRSTUBWXYZabcdefghijklmnopqrstubwxyz\n"};
+
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("session_pin_test")};
+
+    void SetUp() override {
+        helper_->set_up();
+        manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, helper_->path().string(), 1024, false);
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        helper_->tear_down();
+    }
+
+    // creates a BLOB file in the session store and returns its path
+    std::filesystem::path put(detail::blob_session_impl& session_impl) {
+        auto [bid, path] = session_impl.create_blob_file();
+        EXPECT_TRUE(session_impl.reserve_session_store(bid, test_blob.size()));
+        std::ofstream strm(path);
+        strm << test_blob;
+        return path;
+    }
+
+    api api_for_test{
+        [this](std::uint64_t, std::uint64_t) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+TEST_F(session_pin_test, dispose_unpinned) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto path = put(manager_->get_session_impl(session.session_id()));
+    ASSERT_TRUE(std::filesystem::exists(path));
+
+    session.dispose();
+    EXPECT_FALSE(std::filesystem::exists(path));
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+}
+
+TEST_F(session_pin_test, dispose_pinned) {
+    auto session_id = manager_->create_session(std::nullopt).session_id();
+    auto pinned = manager_->pin_session(session_id);
+    auto path = put(*pinned);
+    auto bid = pinned->entries().at(0);
+
+    manager_->get_session(session_id).dispose();
+    EXPECT_THROW(manager_->pin_session(session_id), std::out_of_range);
+    EXPECT_THROW(manager_->get_session_impl(session_id), std::out_of_range);
+
+    // the pinned session is still readable, but no more BLOB can be added
+    EXPECT_TRUE(pinned->disposed());
+    EXPECT_EQ(pinned->find(bid), path);
+    EXPECT_TRUE(std::filesystem::exists(path));
+    EXPECT_THROW(pinned->create_blob_file(), std::out_of_range);
+    EXPECT_EQ(manager_->session_store_current_size(), test_blob.size());
+
+    // the BLOB files are deleted when the last pin is released
+    pinned = {};
+    EXPECT_FALSE(std::filesystem::exists(path));
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+}
+
+TEST_F(session_pin_test, transaction_id) {
+    auto session_id = manager_->create_session(1234).session_id();
+    auto pinned = manager_->pin_session(session_id);
+    EXPECT_EQ(manager_->get_session_id(1234), session_id);
+
+    pinned->dispose();
+    EXPECT_THROW(manager_->get_session_id(1234), std::out_of_range);
+    EXPECT_EQ(pinned->get_transaction_id(), 1234);
+}
+
+} // namespace
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <thread>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+namespace data_relay_grpc::common {
+
+class session_quota_admission_test : public ::testing::Test {
+protected:
+    const std::uint64_t tag_for_test = 2468;
+
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("session_quota_admission_test")};
+
+    void SetUp() override {
+        helper_->set_up();
+        detail::session_store_options options{};
+        options.admission_wait = std::chrono::milliseconds(10000);
+        manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, helper_->path().string(), 100, false, options);
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        helper_->tear_down();
+    }
+
+    blob_session::blob_id_type create_blob(blob_session& session) {
+        return manager_->get_session_impl(session.session_id()).create_blob_file().first;
+    }
+
+    detail::quota_level reserve(blob_session& session, blob_session::blob_id_type bid, std::size_t size, std::chrono::milliseconds timeout) {
+        return manager_->get_session_impl(session.session_id()).try_reserve_session_store(bid, size, std::chrono::system_clock::now() + timeout);
+    }
+
+    void wait_for_waiting(std::size_t count) {
+        for (int i = 0; i < 1000 && manager_->admission().waiting() != count; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ASSERT_EQ(manager_->admission().waiting(), count);
+    }
+
+    api api_for_test{
+        [this](std::uint64_t, std::uint64_t) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+TEST_F(session_quota_admission_test, wait_for_release) {
+    auto& holder = manager_->create_session(std::nullopt);
+    auto held = create_blob(holder);
+    ASSERT_EQ(reserve(holder, held, 100, std::chrono::milliseconds(0)), detail::quota_level::none);
+
+    auto& session = manager_->create_session(std::nullopt);
+    auto bid = create_blob(session);
+    auto result = std::async(std::launch::async, [&]{ return reserve(session, bid, 50, std::chrono::milliseconds(10000)); });
+    wait_for_waiting(1);
+
+    std::vector<blob_session::blob_id_type> bids{held};
+    holder.remove(bids.begin(), bids.end());
+    EXPECT_EQ(result.get(), detail::quota_level::none);
+    EXPECT_EQ(manager_->session_store_current_size(), 50);
+    EXPECT_EQ(manager_->admission().waits(), 1);
+    EXPECT_EQ(manager_->admission().timeouts(), 0);
+}
+
+TEST_F(session_quota_admission_test, deadline) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto bid = create_blob(session);
+    ASSERT_EQ(reserve(session, bid, 100, std::chrono::milliseconds(0)), detail::quota_level::none);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(reserve(session, bid, 1, std::chrono::milliseconds(50)), detail::quota_level::store);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(40));
+    EXPECT_EQ(manager_->admission().timeouts(), 1);
+    EXPECT_EQ(manager_->admission().waiting(), 0);
+    EXPECT_EQ(manager_->session_store_current_size(), 100);
+}
+
+TEST_F(session_quota_admission_test, first_in_first_out) {
+    auto& holder = manager_->create_session(std::nullopt);
+    auto held1 = create_blob(holder);
+    auto held2 = create_blob(holder);
+    ASSERT_EQ(reserve(holder, held1, 90, std::chrono::milliseconds(0)), detail::quota_level::none);
+    ASSERT_EQ(reserve(holder, held2, 10, std::chrono::milliseconds(0)), detail::quota_level::none);
+
+    auto& session = manager_->create_session(std::nullopt);
+    auto large = create_blob(session);
+    auto small = create_blob(session);
+    auto large_result = std::async(std::launch::async, [&]{ return reserve(session, large, 80, std::chrono::milliseconds(10000)); });
+    wait_for_waiting(1);
+    auto small_result = std::async(std::launch::async, [&]{ return reserve(session, small, 10, std::chrono::milliseconds(10000)); });
+    wait_for_waiting(2);
+
+    // the small one does not overtake the large one
+    std::vector<blob_session::blob_id_type> bids{held2};
+    holder.remove(bids.begin(), bids.end());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(manager_->admission().waiting(), 2);
+
+    bids = {held1};
+    holder.remove(bids.begin(), bids.end());
+    EXPECT_EQ(large_result.get(), detail::quota_level::none);
+    EXPECT_EQ(small_result.get(), detail::quota_level::none);
+    EXPECT_EQ(manager_->session_store_current_size(), 90);
+    EXPECT_EQ(manager_->admission().max_waiting(), 2);
+}
+
+TEST_F(session_quota_admission_test, per_stripe) {
+    directory_helper stripe_helper{"session_quota_admission_test_stripe"};
+    stripe_helper.set_up();
+    manager_.reset();
+    detail::session_store_options options{};
+    options.admission_wait = std::chrono::milliseconds(10000);
+    options.stripe_directories = {stripe_helper.path()};
+    manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, helper_->path().string(), 100, false, options);
+
+    // placed in the stripes by turns, 50 bytes each
+    auto& holder = manager_->create_session(std::nullopt);
+    auto held = create_blob(holder);
+    auto& session = manager_->create_session(std::nullopt);
+    auto other = create_blob(session);
+    auto waiter = create_blob(session);
+    ASSERT_EQ(reserve(holder, held, 50, std::chrono::milliseconds(0)), detail::quota_level::none);
+    auto result = std::async(std::launch::async, [&]{ return reserve(session, waiter, 10, std::chrono::milliseconds(10000)); });
+    wait_for_waiting(1);
+
+    // the reservation for the other stripe does not queue behind the one waiting
+    EXPECT_EQ(reserve(session, other, 10, std::chrono::milliseconds(0)), detail::quota_level::none);
+    EXPECT_EQ(manager_->admission(1).waits(), 0);
+
+    std::vector<blob_session::blob_id_type> bids{held};
+    holder.remove(bids.begin(), bids.end());
+    EXPECT_EQ(result.get(), detail::quota_level::none);
+    EXPECT_EQ(manager_->session_store_current_size(), 20);
+    manager_.reset();
+    stripe_helper.tear_down();
+}
+
+} // namespace
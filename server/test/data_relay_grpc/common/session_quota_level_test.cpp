@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "data_relay_grpc/common/session_test_base.h"
+
+namespace data_relay_grpc::common {
+
+class session_quota_level_test : public session_test_base {
+protected:
+    session_quota_level_test() : session_test_base("session_quota_level_test") {}
+
+    void SetUp() override {
+        session_test_base::SetUp();
+        detail::session_store_options options{};
+        options.session_quota = 100;
+        options.transaction_quota = 150;
+        start(200, options);
+    }
+
+    detail::quota_level reserve(blob_session& session, std::size_t size) {
+        auto handle = manager_->pin_session(session.session_id());
+        auto bid = handle->create_blob_file().first;
+        return handle->try_reserve_session_store(bid, size);
+    }
+};
+
+TEST_F(session_quota_level_test, session) {
+    auto& session = manager_->create_session(std::nullopt);
+
+    EXPECT_EQ(reserve(session, 60), detail::quota_level::none);
+    EXPECT_EQ(reserve(session, 60), detail::quota_level::session);
+    EXPECT_EQ(reserve(session, 40), detail::quota_level::none);
+    EXPECT_EQ(manager_->pin_session(session.session_id())->usage(), 100);
+    EXPECT_EQ(manager_->session_store_current_size(), 100);
+}
+
+TEST_F(session_quota_level_test, transaction) {
+    auto& session1 = manager_->create_session(1);
+    auto& session2 = manager_->create_session(1);
+    auto& other = manager_->create_session(2);
+
+    EXPECT_EQ(reserve(session1, 100), detail::quota_level::none);
+    EXPECT_EQ(reserve(session2, 60), detail::quota_level::transaction);
+    EXPECT_EQ(reserve(other, 60), detail::quota_level::none);
+    EXPECT_EQ(manager_->pin_session(session2.session_id())->usage(), 0);
+
+    // the usage of the transaction is released by disposing a session of it
+    session1.dispose();
+    EXPECT_EQ(reserve(session2, 60), detail::quota_level::none);
+}
+
+TEST_F(session_quota_level_test, store) {
+    auto& session1 = manager_->create_session(std::nullopt);
+    auto& session2 = manager_->create_session(std::nullopt);
+    auto& session3 = manager_->create_session(std::nullopt);
+
+    EXPECT_EQ(reserve(session1, 100), detail::quota_level::none);
+    EXPECT_EQ(reserve(session2, 80), detail::quota_level::none);
+    EXPECT_EQ(reserve(session3, 30), detail::quota_level::store);
+    // the usage of the session is rolled back
+    EXPECT_EQ(manager_->pin_session(session3.session_id())->usage(), 0);
+    EXPECT_EQ(reserve(session3, 20), detail::quota_level::none);
+}
+
+TEST_F(session_quota_level_test, concurrent_chunks) {
+    auto& session = manager_->create_session(std::nullopt);
+    auto handle = manager_->pin_session(session.session_id());
+    std::vector<blob_session::blob_id_type> bids{};
+    for (std::size_t i = 0; i < 4; i++) {
+        bids.emplace_back(handle->create_blob_file().first);
+    }
+
+    // the chunks of the BLOBs are reserved in parallel within the quota of the session
+    std::atomic<std::size_t> reserved{};
+    std::vector<std::thread> threads{};
+    for (auto bid : bids) {
+        threads.emplace_back([&handle, &reserved, bid] {
+            for (std::size_t i = 0; i < 50; i++) {
+                if (handle->try_reserve_session_store(bid, 1) == detail::quota_level::none) {
+                    reserved++;
+                }
+            }
+        });
+    }
+    for (auto&& e : threads) {
+        e.join();
+    }
+    EXPECT_EQ(reserved.load(), 100);
+    EXPECT_EQ(handle->usage(), 100);
+
+    // the sizes added to the entries are released on removal
+    handle->delete_blob_files(bids.data(), bids.size());
+    EXPECT_EQ(handle->usage(), 0);
+    EXPECT_EQ(manager_->session_store_current_size(), 0);
+}
+
+TEST_F(session_quota_level_test, message) {
+    EXPECT_NE(detail::quota_exceeded_message(detail::quota_level::session), detail::quota_exceeded_message(detail::quota_level::store));
+    EXPECT_NE(detail::quota_exceeded_message(detail::quota_level::transaction), detail::quota_exceeded_message(detail::quota_level::store));
+    EXPECT_EQ(detail::quota_exceeded_message(detail::quota_level::store), "session storage usage has reached its limit");
+}
+
+} // namespace
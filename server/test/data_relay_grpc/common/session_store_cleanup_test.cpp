@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+
+#include <sys/stat.h>
+
+#include "data_relay_grpc/common/session_test_base.h"
+
+#include <data_relay_grpc/common/detail/session_store.h>
+
+namespace data_relay_grpc::common {
+
+class session_store_cleanup_test : public session_test_base {
+protected:
+    const std::size_t leftover_count = 1000;
+
+    std::filesystem::path store_{};
+    std::filesystem::path trash_{};
+
+    session_store_cleanup_test() : session_test_base("session_store_cleanup_test") {}
+
+    void SetUp() override {
+        session_test_base::SetUp();
+        store_ = helper_->path("session_store");
+        trash_ = store_ / ".trash";
+        std::filesystem::create_directory(store_);
+    }
+
+    void create_files(const std::filesystem::path& directory, std::size_t count) {
+        std::filesystem::create_directories(directory);
+        for (std::size_t i = 0; i < count; i++) {
+            std::ofstream(directory / ("upload_" + std::to_string(i + 1))) << "leftover";
+        }
+    }
+};
+
+TEST_F(session_store_cleanup_test, background) {
+    create_files(store_, leftover_count);
+    create_files(store_ / "subdir", leftover_count);
+
+    detail::blob_session_store store(store_.string(), 0, 2);
+    // the files left are moved aside at once
+    for (auto&& e : std::filesystem::directory_iterator(store_)) {
+        EXPECT_EQ(e.path().filename(), ".trash");
+    }
+    EXPECT_EQ(store.current_size(), 0);
+
+    store.wait_cleanup();
+    EXPECT_EQ(file_count(store_), 0);
+    EXPECT_EQ(file_count(helper_->path()), 1);
+}
+
+TEST_F(session_store_cleanup_test, symbolic_link) {
+    auto link = helper_->path("link");
+    std::filesystem::create_directory_symlink(store_, link);
+    create_files(store_, leftover_count);
+
+    detail::blob_session_store store(link.string(), 0, 2);
+    EXPECT_TRUE(std::filesystem::is_symlink(link));
+
+    store.wait_cleanup();
+    EXPECT_EQ(file_count(link), 0);
+    EXPECT_TRUE(std::filesystem::is_symlink(link));
+}
+
+TEST_F(session_store_cleanup_test, directory_kept) {
+    std::filesystem::permissions(store_, std::filesystem::perms::owner_all | std::filesystem::perms::group_read | std::filesystem::perms::group_exec);
+    create_files(store_, leftover_count);
+    struct stat before{};
+    ASSERT_EQ(::stat(store_.c_str(), &before), 0);
+
+    // the session store directory itself is neither renamed nor recreated
+    detail::blob_session_store store(store_.string(), 0, 2);
+    store.wait_cleanup();
+    struct stat after{};
+    ASSERT_EQ(::stat(store_.c_str(), &after), 0);
+    EXPECT_EQ(after.st_ino, before.st_ino);
+    EXPECT_EQ(after.st_mode, before.st_mode);
+    EXPECT_EQ(file_count(store_), 0);
+    EXPECT_EQ(file_count(helper_->path()), 1);
+}
+
+TEST_F(session_store_cleanup_test, interrupted) {
+    // the trash left by the previous run which stopped before purging it
+    create_files(trash_ / "1-1", leftover_count);
+    create_files(trash_ / "2-2", leftover_count);
+
+    detail::blob_session_store store(store_.string(), 0, 2);
+    store.wait_cleanup();
+    EXPECT_EQ(file_count(store_), 0);
+}
+
+TEST_F(session_store_cleanup_test, synchronous) {
+    create_files(store_, leftover_count);
+    create_files(trash_ / "1-1", leftover_count);
+
+    detail::blob_session_store store(store_.string(), 0, 0);
+    EXPECT_EQ(file_count(store_), 0);
+}
+
+} // namespace
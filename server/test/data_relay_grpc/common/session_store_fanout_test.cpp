@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <exception>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+namespace data_relay_grpc::common {
+
+class session_store_fanout_test : public ::testing::Test {
+protected:
+    const std::uint64_t tag_for_test = 2468;
+    const std::string test_blob{"ABCDEFGHIJKLMNOPQRSTUBWXYZabcdefghijklmnopqrstubwxyz\n"};
+
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("session_store_fanout_test")};
+
+    void SetUp() override {
+        helper_->set_up();
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        helper_->tear_down();
+    }
+
+    void start(std::size_t levels, bool persistent = false) {
+        manager_.reset();
+        detail::session_store_options options{};
+        options.cleanup_threads = 0;
+        options.persistent_index = persistent;
+        options.fanout_levels = levels;
+        manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, helper_->path().string(), 1024 * 1024, false, options);
+    }
+
+    std::pair<blob_session::blob_id_type, std::filesystem::path> put(blob_session& session, bool complete = true) {
+        auto& session_impl = manager_->get_session_impl(session.session_id());
+        auto [bid, path] = session_impl.create_blob_file();
+        EXPECT_TRUE(session_impl.reserve_session_store(bid, test_blob.size()));
+        std::ofstream strm(path);
+        strm << test_blob;
+        strm.close();
+        if (complete) {
+            session_impl.complete_blob_file(bid);
+        }
+        return {bid, path};
+    }
+
+    api api_for_test{
+        [this](std::uint64_t, std::uint64_t) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+TEST_F(session_store_fanout_test, one_level) {
+    start(1);
+    std::size_t buckets{};
+    for (auto&& e : std::filesystem::directory_iterator(helper_->path())) {
+        EXPECT_TRUE(e.is_directory());
+        buckets++;
+    }
+    EXPECT_EQ(buckets, 256);
+
+    auto& session = manager_->create_session(std::nullopt);
+    auto [bid, path] = put(session);
+    EXPECT_EQ(path.parent_path().parent_path(), helper_->path());
+    EXPECT_EQ(path.parent_path().filename().string().size(), 2);
+    EXPECT_TRUE(std::filesystem::exists(path));
+
+    std::vector<blob_session::blob_id_type> bids{bid};
+    session.remove(bids.begin(), bids.end());
+    manager_->wait_deletions();
+    EXPECT_FALSE(std::filesystem::exists(path));
+    EXPECT_TRUE(std::filesystem::exists(path.parent_path()));
+}
+
+TEST_F(session_store_fanout_test, two_levels) {
+    start(2);
+    auto& session = manager_->create_session(std::nullopt);
+    auto [bid, path] = put(session);
+    EXPECT_EQ(path.parent_path().parent_path().parent_path(), helper_->path());
+    EXPECT_EQ(session.find(bid).value(), path);
+}
+
+TEST_F(session_store_fanout_test, too_many_levels) {
+    EXPECT_THROW(start(detail::blob_session_store::max_fanout_levels + 1), std::runtime_error);
+}
+
+TEST_F(session_store_fanout_test, purge_at_start) {
+    start(1);
+    auto& session = manager_->create_session(std::nullopt);
+    auto path = put(session).second;
+
+    // the files left are purged, and the subdirectories are created again
+    start(1);
+    EXPECT_FALSE(std::filesystem::exists(path));
+    EXPECT_TRUE(std::filesystem::exists(path.parent_path()));
+}
+
+TEST_F(session_store_fanout_test, restore) {
+    start(1, true);
+    auto& session = manager_->create_session(std::nullopt);
+    auto sid = session.session_id();
+    auto [bid, path] = put(session);
+    auto incomplete = put(session, false).second;
+
+    start(1, true);
+    EXPECT_EQ(manager_->get_session(sid).find(bid).value(), path);
+    EXPECT_TRUE(std::filesystem::exists(path));
+    // the file not recorded in the subdirectory is deleted
+    manager_->wait_deletions();
+    EXPECT_FALSE(std::filesystem::exists(incomplete));
+}
+
+} // namespace
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <exception>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+namespace data_relay_grpc::common {
+
+class session_store_stripe_test : public ::testing::Test {
+protected:
+    const std::uint64_t tag_for_test = 2468;
+    const std::string test_blob{"ABCDEFGHIJKLMNOPQRSTUBWXYZabcdefghijklmnopqrstubwxyz\n"};
+
+    std::vector<std::unique_ptr<directory_helper>> helpers_{};
+
+    void SetUp() override {
+        for (auto&& name : {"session_store_stripe_test0", "session_store_stripe_test1", "session_store_stripe_test2"}) {
+            helpers_.emplace_back(std::make_unique<directory_helper>(name));
+            helpers_.back()->set_up();
+        }
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        for (auto&& e : helpers_) {
+            e->tear_down();
+        }
+    }
+
+    void start(detail::stripe_placement placement, std::size_t quota, bool persistent = false) {
+        manager_.reset();
+        detail::session_store_options options{};
+        options.cleanup_threads = 0;
+        options.persistent_index = persistent;
+        options.stripe_directories = {helpers_.at(1)->path(), helpers_.at(2)->path()};
+        options.placement = placement;
+        manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, helpers_.at(0)->path().string(), quota, false, options);
+    }
+
+    std::pair<blob_session::blob_id_type, std::filesystem::path> put(blob_session& session, std::size_t size) {
+        auto& session_impl = manager_->get_session_impl(session.session_id());
+        auto [bid, path] = session_impl.create_blob_file();
+        if (!session_impl.reserve_session_store(bid, size)) {
+            return {bid, {}};
+        }
+        std::ofstream strm(path);
+        strm << test_blob;
+        strm.close();
+        session_impl.complete_blob_file(bid);
+        return {bid, path};
+    }
+
+    std::size_t stripe_of(const std::filesystem::path& path) {
+        for (std::size_t i = 0; i < helpers_.size(); i++) {
+            if (path.parent_path() == helpers_.at(i)->path()) {
+                return i;
+            }
+        }
+        return helpers_.size();
+    }
+
+    api api_for_test{
+        [this](std::uint64_t, std::uint64_t) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t){
+            return helpers_.at(0)->last_path();
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+TEST_F(session_store_stripe_test, round_robin) {
+    start(detail::stripe_placement::round_robin, 0);
+    auto& session = manager_->create_session(std::nullopt);
+
+    std::vector<std::size_t> counts(3);
+    for (std::size_t i = 0; i < 6; i++) {
+        auto path = put(session, test_blob.size()).second;
+        EXPECT_TRUE(std::filesystem::exists(path));
+        counts.at(stripe_of(path))++;
+    }
+    EXPECT_EQ(counts, (std::vector<std::size_t>{2, 2, 2}));
+}
+
+TEST_F(session_store_stripe_test, hash) {
+    start(detail::stripe_placement::hash, 0);
+    auto& session = manager_->create_session(std::nullopt);
+
+    auto [bid, path] = put(session, test_blob.size());
+    auto stripe = stripe_of(path);
+    EXPECT_LT(stripe, 3);
+    EXPECT_EQ(manager_->get_session(session.session_id()).find(bid).value(), path);
+}
+
+TEST_F(session_store_stripe_test, quota_share) {
+    start(detail::stripe_placement::round_robin, 300);
+    auto& session = manager_->create_session(std::nullopt);
+
+    // each directory has 100 bytes of the quota
+    EXPECT_TRUE(put(session, 101).second.empty());
+    EXPECT_FALSE(put(session, 100).second.empty());
+    EXPECT_FALSE(put(session, 100).second.empty());
+    EXPECT_EQ(manager_->session_store_current_size(), 200);
+}
+
+TEST_F(session_store_stripe_test, least_used) {
+    start(detail::stripe_placement::least_used, 300);
+    auto& session = manager_->create_session(std::nullopt);
+
+    std::vector<blob_session::blob_id_type> bids{};
+    std::vector<std::size_t> counts(3);
+    for (std::size_t i = 0; i < 3; i++) {
+        auto [bid, path] = put(session, 100);
+        ASSERT_FALSE(path.empty());
+        counts.at(stripe_of(path))++;
+        bids.emplace_back(bid);
+    }
+    // the files are spread as each directory is full after one
+    EXPECT_EQ(counts, (std::vector<std::size_t>{1, 1, 1}));
+    EXPECT_TRUE(put(session, 1).second.empty());
+
+    // the usage is released from the directory where the file has been placed
+    auto path = manager_->get_session(session.session_id()).find(bids.at(1)).value();
+    session.remove(bids.begin() + 1, bids.begin() + 2);
+    EXPECT_EQ(manager_->session_store_current_size(), 200);
+    auto reput = put(session, 100).second;
+    EXPECT_EQ(stripe_of(reput), stripe_of(path));
+}
+
+TEST_F(session_store_stripe_test, restore) {
+    start(detail::stripe_placement::round_robin, 3000, true);
+    auto& session = manager_->create_session(std::nullopt);
+    auto sid = session.session_id();
+    std::vector<std::pair<blob_session::blob_id_type, std::filesystem::path>> blobs{};
+    for (std::size_t i = 0; i < 3; i++) {
+        blobs.emplace_back(put(session, test_blob.size()));
+    }
+
+    start(detail::stripe_placement::round_robin, 3000, true);
+    auto& restored = manager_->get_session(sid);
+    for (auto&& [bid, path] : blobs) {
+        EXPECT_EQ(restored.find(bid).value(), path);
+        EXPECT_TRUE(std::filesystem::exists(path));
+    }
+    EXPECT_EQ(manager_->session_store_current_size(), 3 * test_blob.size());
+}
+
+} // namespace
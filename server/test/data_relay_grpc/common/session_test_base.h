@@ -0,0 +1,81 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/session_manager.h>
+#include <data_relay_grpc/common/detail/session_impl.h>
+
+namespace data_relay_grpc::common {
+
+class session_test_base : public ::testing::Test {
+protected:
+    const std::uint64_t tag_for_test = 2468;
+    const std::string test_blob{"ABCDEFGHIJKLMNOPQRSTUBWXYZabcdefghijklmnopqrstubwxyz\n"};
+
+    std::unique_ptr<directory_helper> helper_;
+
+    explicit session_test_base(const std::string& name) : helper_(std::make_unique<directory_helper>(name)) {}
+
+    void SetUp() override {
+        helper_->set_up();
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        helper_->tear_down();
+    }
+
+    // creates the manager with the session store on the directory of the test
+    void start(std::size_t quota, const detail::session_store_options& options = {}) {
+        manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, helper_->path().string(), quota, false, options);
+    }
+
+    // creates BLOB files of test_blob in the session, charged to the session store
+    std::vector<blob_session::blob_id_type> put(blob_session& session, std::size_t count) {
+        auto handle = manager_->pin_session(session.session_id());
+        std::vector<blob_session::blob_id_type> bids{};
+        for (std::size_t i = 0; i < count; i++) {
+            auto [bid, path] = handle->create_blob_file();
+            EXPECT_TRUE(handle->reserve_session_store(bid, test_blob.size()));
+            std::ofstream strm(path);
+            strm << test_blob;
+            bids.emplace_back(bid);
+        }
+        return bids;
+    }
+
+    // counts the entries in the directory, not recursively
+    static std::size_t file_count(const std::filesystem::path& directory) {
+        std::size_t count{};
+        for (auto&& e : std::filesystem::directory_iterator(directory)) {
+            (void) e;
+            count++;
+        }
+        return count;
+    }
+
+    std::size_t file_count() {
+        return file_count(helper_->path());
+    }
+
+    api api_for_test{
+        [this](std::uint64_t, std::uint64_t) {
+            return tag_for_test;
+        },
+        [this](std::uint64_t){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+} // namespace
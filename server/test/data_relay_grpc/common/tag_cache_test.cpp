@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <exception>
+
+#include "test_root.h"
+
+#include <data_relay_grpc/common/detail/tag_cache.h>
+#include <data_relay_grpc/common/detail/session_manager.h>
+
+namespace data_relay_grpc::common {
+
+class tag_cache_test : public ::testing::Test {
+protected:
+    std::unique_ptr<directory_helper> helper_{std::make_unique<directory_helper>("tag_cache_test")};
+
+    void SetUp() override {
+        helper_->set_up();
+    }
+
+    void TearDown() override {
+        manager_.reset();
+        helper_->tear_down();
+    }
+
+    void start(std::size_t capacity) {
+        detail::session_store_options options{};
+        options.tag_cache_size = capacity;
+        manager_ = std::make_unique<detail::blob_session_manager>(api_for_test, helper_->path().string(), 1024 * 1024, false, options);
+    }
+
+    std::atomic<std::size_t> calls_{};
+
+    api api_for_test{
+        [this](std::uint64_t bid, std::uint64_t tid) {
+            calls_++;
+            return bid * 1000 + tid;
+        },
+        [this](std::uint64_t){
+            return helper_->last_path();
+        }
+    };
+
+    std::unique_ptr<detail::blob_session_manager> manager_{};
+};
+
+TEST_F(tag_cache_test, open_and_close) {
+    detail::tag_cache cache(100);
+    EXPECT_TRUE(cache.enabled());
+
+    // not cached unless the transaction is opened
+    cache.insert(1, 10, 111);
+    EXPECT_FALSE(cache.find(1, 10));
+
+    cache.open(10);
+    cache.insert(1, 10, 111);
+    EXPECT_EQ(cache.find(1, 10).value(), 111);
+    EXPECT_FALSE(cache.find(2, 10));
+    EXPECT_FALSE(cache.find(1, 11));
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(cache.misses(), 3);
+
+    cache.close(10);
+    EXPECT_FALSE(cache.find(1, 10));
+    EXPECT_EQ(cache.size(), 0);
+    cache.insert(1, 10, 111);
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(tag_cache_test, opened_twice) {
+    detail::tag_cache cache(100);
+    cache.open(10);
+    cache.open(10);
+    cache.insert(1, 10, 111);
+
+    // kept until closed as many times as opened
+    cache.close(10);
+    EXPECT_EQ(cache.find(1, 10).value(), 111);
+    cache.close(10);
+    EXPECT_FALSE(cache.find(1, 10));
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(tag_cache_test, disabled) {
+    detail::tag_cache cache(0);
+    EXPECT_FALSE(cache.enabled());
+    cache.open(10);
+    cache.insert(1, 10, 111);
+    EXPECT_FALSE(cache.find(1, 10));
+    EXPECT_EQ(cache.misses(), 0);
+}
+
+TEST_F(tag_cache_test, bounded) {
+    // one entry in each shard
+    detail::tag_cache cache(detail::tag_cache::shard_count);
+    cache.open(10);
+    cache.insert(1, 10, 111);
+    cache.insert(2, 10, 222);
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.find(2, 10).value(), 222);
+}
+
+TEST_F(tag_cache_test, transaction) {
+    start(100);
+    auto& session = manager_->create_session(7);
+
+    EXPECT_EQ(manager_->get_tag(1, 7), 1007);
+    EXPECT_EQ(manager_->get_tag(1, 7), 1007);
+    EXPECT_EQ(manager_->get_tag(2, 7), 2007);
+    EXPECT_EQ(calls_, 2);
+    EXPECT_EQ(manager_->tag_cache_hits(), 1);
+    EXPECT_EQ(manager_->tag_cache_misses(), 2);
+
+    // the transaction without session is not cached
+    EXPECT_EQ(manager_->get_tag(1, 8), 1008);
+    EXPECT_EQ(manager_->get_tag(1, 8), 1008);
+    EXPECT_EQ(calls_, 4);
+
+    // the tags are dropped on dispose
+    session.dispose();
+    EXPECT_EQ(manager_->get_tag(1, 7), 1007);
+    EXPECT_EQ(calls_, 5);
+}
+
+TEST_F(tag_cache_test, two_sessions_one_transaction) {
+    start(100);
+    auto& session1 = manager_->create_session(7);
+    auto& session2 = manager_->create_session(7);
+    EXPECT_EQ(manager_->get_tag(1, 7), 1007);
+
+    // the tags are kept for the other session of the transaction
+    session1.dispose();
+    EXPECT_EQ(manager_->get_tag(1, 7), 1007);
+    EXPECT_EQ(calls_, 1);
+
+    session2.dispose();
+    EXPECT_EQ(manager_->get_tag(1, 7), 1007);
+    EXPECT_EQ(calls_, 2);
+}
+
+TEST_F(tag_cache_test, session_without_transaction) {
+    start(100);
+    auto& session = manager_->create_session(std::nullopt);
+    auto& session_impl = manager_->get_session_impl(session.session_id());
+    auto tag = session_impl.get_tag(1);
+    EXPECT_EQ(session_impl.get_tag(1), tag);
+    EXPECT_EQ(calls_, 2);
+    EXPECT_EQ(manager_->tag_cache_hits(), 0);
+}
+
+TEST_F(tag_cache_test, session_id_equal_to_transaction_id) {
+    start(100);
+    auto& session = manager_->create_session(std::nullopt);
+    auto id = session.session_id();
+    auto& transaction_session = manager_->create_session(id);
+    EXPECT_EQ(manager_->get_tag(1, id), 1000 + id);
+    EXPECT_EQ(calls_, 1);
+
+    // the tag of the transaction is not returned for the session of the same ID, and vice versa
+    auto& session_impl = manager_->get_session_impl(session.session_id());
+    EXPECT_EQ(session_impl.get_tag(2), 2000 + id);
+    EXPECT_EQ(manager_->get_tag(2, id), 2000 + id);
+    EXPECT_EQ(calls_, 3);
+
+    // the tags of the transaction are kept on dispose of the session
+    session.dispose();
+    EXPECT_EQ(manager_->get_tag(1, id), 1000 + id);
+    EXPECT_EQ(calls_, 3);
+    transaction_session.dispose();
+}
+
+TEST_F(tag_cache_test, cache_disabled) {
+    start(0);
+    manager_->create_session(7);
+    EXPECT_EQ(manager_->get_tag(1, 7), 1007);
+    EXPECT_EQ(manager_->get_tag(1, 7), 1007);
+    EXPECT_EQ(calls_, 2);
+}
+
+} // namespace
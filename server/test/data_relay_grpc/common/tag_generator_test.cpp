@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <thread>
+#include <vector>
+
+#include <data_relay_grpc/common/tag_generator.h>
+
+namespace data_relay_grpc::common {
+
+class tag_generator_test : public ::testing::Test {
+protected:
+    using generator_type = tag_generator<std::uint64_t, std::uint64_t, std::uint64_t>;
+};
+
+TEST_F(tag_generator_test, deterministic) {
+    generator_type generator{};
+    auto tag = generator.generate_reference_tag(1, 2);
+    EXPECT_EQ(generator.generate_reference_tag(1, 2), tag);
+    EXPECT_NE(generator.generate_reference_tag(2, 2), tag);
+    EXPECT_NE(generator.generate_reference_tag(1, 3), tag);
+}
+
+TEST_F(tag_generator_test, batch) {
+    generator_type generator{};
+    std::array<std::uint64_t, 5> ids{10, 20, 30, 40, 10};
+    std::array<std::uint64_t, 5> tags{};
+    generator.generate_reference_tags(ids.data(), ids.size(), 7, tags.data());
+    for (std::size_t i = 0; i < ids.size(); i++) {
+        EXPECT_EQ(tags.at(i), generator.generate_reference_tag(ids.at(i), 7));
+    }
+    EXPECT_EQ(tags.at(0), tags.at(4));
+
+    // no tag is written for an empty batch
+    generator.generate_reference_tags(ids.data(), 0, 7, nullptr);
+}
+
+TEST_F(tag_generator_test, instances_interleaved) {
+    // each thread switches its context between the instances keyed differently
+    generator_type first{};
+    generator_type second{};
+    auto tag1 = first.generate_reference_tag(1, 2);
+    auto tag2 = second.generate_reference_tag(1, 2);
+    EXPECT_NE(tag1, tag2);
+    EXPECT_EQ(first.generate_reference_tag(1, 2), tag1);
+    EXPECT_EQ(second.generate_reference_tag(1, 2), tag2);
+
+    // a new instance does not use the context of the instance destroyed
+    std::uint64_t tag3{};
+    {
+        generator_type third{};
+        tag3 = third.generate_reference_tag(1, 2);
+    }
+    generator_type fourth{};
+    EXPECT_NE(fourth.generate_reference_tag(1, 2), tag3);
+}
+
+TEST_F(tag_generator_test, concurrent) {
+    generator_type generator{};
+    constexpr std::size_t count = 1000;
+    std::vector<std::uint64_t> expected(count);
+    for (std::size_t i = 0; i < count; i++) {
+        expected.at(i) = generator.generate_reference_tag(i, 3);
+    }
+
+    std::vector<std::thread> threads{};
+    std::array<bool, 4> matched{};
+    for (std::size_t t = 0; t < matched.size(); t++) {
+        threads.emplace_back([&, t]{
+            std::vector<std::uint64_t> ids(count);
+            std::vector<std::uint64_t> tags(count);
+            for (std::size_t i = 0; i < count; i++) {
+                ids.at(i) = i;
+            }
+            generator.generate_reference_tags(ids.data(), count, 3, tags.data());
+            matched.at(t) = (tags == expected);
+        });
+    }
+    for (auto&& e : threads) {
+        e.join();
+    }
+    for (auto e : matched) {
+        EXPECT_TRUE(e);
+    }
+}
+
+} // namespace